@@ -9,246 +9,498 @@
  * @note This file is part of the IFJ2024 project.
  */
 
+#include <stdint.h>
+
 #include "Code_generator.h"
+#include "builtins.h"
+#include "literal_pool.h"
+
+// Appends one formatted IFJcode24 instruction to the program of the current context
+#define EMIT(...) ir_emit(compilerContext->program, __VA_ARGS__)
+
+// Types of the variables of the current function, used to choose between IDIV and DIV and to
+// write int literals next to f64 operands as floats. Names are interned, so the table
+// (compilerContext->declaredTypes) is keyed by the pointer (open addressing); an entry belongs to
+// the function whose number it carries.
+#define DECLARED_TYPES_INITIAL_SIZE 64
+typedef struct DeclaredType {
+    const char *name;  // Interned name, NULL for a free entry
+    unsigned function; // Number of the function the entry belongs to
+    DataType type;
+} DeclaredType;
+
+static char *generateOperand(BinaryTreeNode *node);
+static void generateConditionalJump(BinaryTreeNode *condition, bool jumpIf, const char *label);
+static void generateOperands(BinaryTreeNode *node, char **left, char **right);
 
 /**
- * @brief Generates the header for the IFJcode24 intermediate code.
+ * @brief Emits the CALL of a user function.
+ *
+ * @details For --profile-generate the call is preceded by the label of its call site
+ * ("$name%call_N"), so the profile counts every call site on its own.
  *
- * This function outputs the initial header line and defines the result variable in the global frame.
+ * @param function Name of the called function.
  */
-void generateHeader(){
-    printf(".IFJcode24\n");
+static void emitCall(const char *function) {
+
+    if (compilerContext->instrument) {
+        char site[300];
+        compiler_label(site, sizeof(site), "call", compilerContext->callSiteCounter++);
+        EMIT("LABEL %s", site);
+    }
+    EMIT("CALL $%s", function);
 }
 
 /**
- * @brief Declares a global variable.
- *
- * @details Handles global variable declaration in IFJcode24. Generates code for built-in functions, function calls,
- * or literal assignments.
+ * @brief Declares a frame variable in the slot assigned by semantic analysis.
  *
- * @param node Pointer to the binary tree node representing the variable declaration.
- * @see generateBuildInFuncions(), generateFunctionCall()
+ * @param target Operand of the variable (e.g. "LF@a").
+ * @param slot Slot of the variable, -1 when it has none.
  */
-void generateGlobalVarDecl(BinaryTreeNode *node) {
+static void emitDefvar(const char *target, int slot) {
 
-    BinaryTreeNode *varNode = node->right;
-    if (varNode->tokenType == TOKEN_ASSIGNMENT) {
-        if (strcmp(varNode->right->strValue, "ifj") == 0) {
-            generateBuildInFuncions(node);
-            return;
-        }
-        if (varNode->right && varNode->right->type == NODE_FUNC_CALL) {
-            generateFunctionCall(node);
-            return;
-        }
-    }
+    EMIT("DEFVAR %s", target);
+    compilerContext->program->code[compilerContext->program->count - 1].slot = slot;
+}
 
-    const char *varName = varNode->strValue;
-    printf("DEFVAR GF@%s\n", varName);
-    BinaryTreeNode *valueNode = varNode->right->right->right->left;
-    if (!valueNode) {
-        valueNode = varNode->right->right->right->right;
-        if (strcmp(valueNode->strValue, "ifj") == 0) {
-            if (strcmp(valueNode->right->right->strValue, "i2f") == 0) {
-                printf("MOVE GF@%s  int@%s\n", varName, valueNode->right->right->left->right->strValue);
-                printf("INT2FLOAT GF@result GF@%s  \n", varName);
-                printf("MOVE GF@%s  GF@result\n", varName);
-                return;
-            } else if (strcmp(valueNode->right->right->strValue, "f2i") == 0) {
-                printf("MOVE GF@%s  float@%s\n", varName, valueNode->right->right->left->right->strValue);
-                printf("FLOAT@INT GF@result GF@%s  \n", varName);
-                printf("MOVE GF@%s  GF@result\n", varName);
-                return;
-            } else if (strcmp(valueNode->right->right->strValue, "length") == 0) {
-                printf("MOVE GF@result  string@%s\n", valueNode->right->right->left->right->strValue);
-                printf("STRLEN GF@%s GF@result  \n", varName);
-                return;
-            }else if (strcmp(valueNode->right->right->strValue, "concat") == 0) {
-                printf("CONCAT GF@result  string@%s string@%s\n", valueNode->right->right->left->right->strValue, valueNode->right->right->left->right->right->right->strValue);
-                printf("MOVE GF@%s GF@result  \n", varName);
-                return;
-            } else {
-                printf("MOVE GF@%s string@%s\n", varName, valueNode->right->right->left->right->strValue);
-                return;
-            }
-        }
+static int declaredTypeIndex(DeclaredType *table, int size, unsigned function, const char *name) {
+
+    int index = (int)(((uintptr_t)name >> 4) * 2654435761u & (uintptr_t)(size - 1));
+    while (table[index].function == function && table[index].name != name) {
+        index = (index + 1) & (size - 1);
     }
-        switch (valueNode->tokenType) {
-            case TOKEN_INT_LITERAL:
-                printf("MOVE GF@%s int@%s\n", varName, valueNode->strValue);
-                break;
+    return index;
+}
 
-            case TOKEN_FLOAT_LITERAL:
-                printf("MOVE GF@%s float@%s\n", varName, valueNode->strValue);
-                break;
+static void growDeclaredTypes(CompilerContext *ctx) {
 
-            default:
-                printf("MOVE GF@%s string@%s\n", varName, valueNode->strValue);
-                break;
+    int newSize = ctx->declaredTypesSize ? 2 * ctx->declaredTypesSize : DECLARED_TYPES_INITIAL_SIZE;
+    DeclaredType *newTable = calloc(newSize, sizeof(DeclaredType));
+    if (!newTable) {
+        handle_error(ERR_COMPILER_INTERNAL);
+    }
+    for (int i = 0; i < ctx->declaredTypesSize; i++) {
+        DeclaredType *entry = &ctx->declaredTypes[i];
+        if (entry->function == ctx->declaredTypesFunction && entry->name != NULL) {
+            newTable[declaredTypeIndex(newTable, newSize, entry->function, entry->name)] = *entry;
         }
+    }
+    free(ctx->declaredTypes);
+    ctx->declaredTypes = newTable;
+    ctx->declaredTypesSize = newSize;
+}
 
+/**
+ * @brief Forgets the types of the variables of the previous function.
+ */
+static void beginDeclaredTypes() {
+
+    CompilerContext *ctx = compilerContext;
+    ctx->declaredTypeCount = 0;
+    if (++ctx->declaredTypesFunction == 0) {
+        // The numbers wrapped around, entries of old functions could be taken for current ones
+        free(ctx->declaredTypes);
+        ctx->declaredTypes = NULL;
+        ctx->declaredTypesSize = 0;
+        ctx->declaredTypesFunction = 1;
+    }
 }
 
 /**
- * @brief Declares local variables.
+ * @brief Remembers the type of a variable of the current function.
  *
- * @details Handles local variable declaration in IFJcode24. Generates code for built-in functions, function calls,
- * or literal assignments.
+ * @details A name declared again (in another block) takes the later type, as the last
+ * declaration before a use is the one in scope.
  *
- * @param node Pointer to the binary tree node representing the variable declaration.
- * @see generateBuildInFuncions(), generateFunctionCall()
+ * @param name Interned name of the variable.
+ * @param type Declared or inferred type of the variable.
  */
-void generateLocalVarDecl(BinaryTreeNode *node) {
+static void recordType(const char *name, DataType type) {
 
-    BinaryTreeNode *varNode = node->right;
+    CompilerContext *ctx = compilerContext;
+    if (2 * (ctx->declaredTypeCount + 1) > ctx->declaredTypesSize) {
+        growDeclaredTypes(ctx);
+    }
+    DeclaredType *entry =
+        &ctx->declaredTypes[declaredTypeIndex(ctx->declaredTypes, ctx->declaredTypesSize, ctx->declaredTypesFunction, name)];
+    if (entry->function != ctx->declaredTypesFunction) {
+        entry->name = name;
+        entry->function = ctx->declaredTypesFunction;
+        ctx->declaredTypeCount++;
+    }
+    entry->type = type;
+}
 
-    if (varNode->tokenType == TOKEN_ASSIGNMENT) {
-        if(varNode->right) {
-            if (strcmp(varNode->right->strValue, "ifj") == 0) {
-                generateBuildInFuncions(node);
-                return;
-            }
+/**
+ * @brief Remembers the type of a variable declared with an explicit type ("x : i32").
+ *
+ * @param identifier Pointer to the identifier node of the declaration or parameter.
+ * @return true when the declaration has an explicit type.
+ */
+static bool recordDeclaredType(BinaryTreeNode *identifier) {
 
-            if (varNode->right && varNode->right->type == NODE_FUNC_CALL) {
-                generateFunctionCall(node);
-                return;
-            }
-            return;
-        }
-        return;
+    BinaryTreeNode *colon = identifier->right;
+    if (!colon || colon->tokenType != TOKEN_COLON || !colon->right) {
+        return false;
     }
+    recordType(node_identifier(identifier), node_data_type(colon->right));
+    return true;
+}
 
-    const char *varName = varNode->strValue;
-    printf("DEFVAR LF@%s\n", varName);
-    BinaryTreeNode *valueNode = varNode->right->right->right->left;
-    if (!valueNode) {
-        valueNode = varNode->right->right->right->right;
-        if (strcmp(valueNode->strValue, "ifj") == 0) {
-            if (strcmp(valueNode->right->right->strValue, "i2f") == 0) {
-                printf("MOVE LF@%s  int@%s\n", varName, valueNode->right->right->left->right->strValue);
-                printf("INT2FLOAT GF@result LF@%s  \n", varName);
-                printf("MOVE LF@%s  GF@result\n", varName);
-                return;
-            } else if (strcmp(valueNode->right->right->strValue, "f2i") == 0) {
-                printf("MOVE LF@%s  float@%s\n", varName, valueNode->right->right->left->right->strValue);
-                printf("FLOAT@INT GF@result LF@%s  \n", varName);
-                printf("MOVE LF@%s  GF@result\n", varName);
-                return;
-            } else if (strcmp(valueNode->right->right->strValue, "length") == 0) {
-                printf("MOVE GF@result  string@%s\n", valueNode->right->right->left->right->strValue);
-                printf("STRLEN LF@%s GF@result  \n", varName);
-                return;
-            }else if (strcmp(valueNode->right->right->strValue, "concat") == 0) {
-                printf("CONCAT GF@result  string@%s string@%s\n", valueNode->right->right->left->right->strValue, valueNode->right->right->left->right->right->right->strValue);
-                printf("MOVE LF@%s GF@result  \n", varName);
-                return;
-            }  if (strcmp(valueNode->right->right->strValue, "strcmp") == 0) {
-                printf("CONCAT GF@result  string@%s string@%s\n", valueNode->right->right->left->right->strValue, valueNode->right->right->left->right->right->right->strValue);
-                printf("MOVE LF@%s GF@result  \n", varName);
-                return;
-            }else {
-                printf("MOVE LF@%s string@%s\n", varName, valueNode->right->right->left->right->strValue);
-                return;
-            }
-        }
-        switch (valueNode->tokenType) {
-            case TOKEN_INT_LITERAL:
-                printf("MOVE LF@%s int@%s\n", varName, valueNode->strValue);
-                break;
+/**
+ * @brief Returns the remembered type of a variable, TYPE_UNKNOWN when it has none.
+ *
+ * @param identifier Pointer to the identifier node.
+ */
+static DataType variableType(BinaryTreeNode *identifier) {
 
-            case TOKEN_FLOAT_LITERAL:
-                printf("MOVE LF@%s float@%s\n", varName, valueNode->strValue);
-                break;
+    CompilerContext *ctx = compilerContext;
+    if (!ctx->declaredTypes) {
+        return TYPE_UNKNOWN;
+    }
+    const char *name = node_identifier(identifier);
+    DeclaredType *entry =
+        &ctx->declaredTypes[declaredTypeIndex(ctx->declaredTypes, ctx->declaredTypesSize, ctx->declaredTypesFunction, name)];
+    return entry->function == ctx->declaredTypesFunction ? entry->type : TYPE_UNKNOWN;
+}
 
-            default:
-                printf("MOVE LF@%s string@%s\n", varName, valueNode->strValue);
-                break;
+/**
+ * @brief Decides whether a division works with integers.
+ *
+ * @details Both operands of an IFJ24 division have the same type, literals take the type of
+ * the variable, so one integer variable (or two integer literals) is enough.
+ */
+static bool isIntegerDivision(BinaryTreeNode *left, BinaryTreeNode *right) {
+
+    BinaryTreeNode *operands[2] = {left, right};
+    int intLiterals = 0;
+    for (int i = 0; i < 2; i++) {
+        if (!operands[i]) {
+            continue;
+        }
+        if (operands[i]->tokenType == TOKEN_INT_LITERAL) {
+            intLiterals++;
+            continue;
+        }
+        if (operands[i]->tokenType != TOKEN_IDENTIFIER) {
+            continue;
         }
+        DataType type = variableType(operands[i]);
+        if (type == TYPE_INT || type == TYPE_INT_NULL) {
+            return true;
+        }
+    }
+    return intLiterals == 2;
+}
+
+/**
+ * @brief Decides whether an expression has the type f64.
+ *
+ * @details A float literal, a variable of type f64 (declared or inferred from its initialiser)
+ * and an arithmetic operation with such an operand are f64.
+ *
+ * @param node Pointer to the expression.
+ */
+static bool isFloatExpression(BinaryTreeNode *node) {
 
+    if (!node) {
+        return false;
     }
+    if (node->tokenType == TOKEN_FLOAT_LITERAL) {
+        return true;
+    }
+    if (node->tokenType == TOKEN_IDENTIFIER) {
+        DataType type = variableType(node);
+        return type == TYPE_FLOAT || type == TYPE_FLOAT_NULL;
+    }
+    if (node->type == NODE_OP && (node->tokenType == TOKEN_ADDITION || node->tokenType == TOKEN_SUBTRACTION ||
+                                  node->tokenType == TOKEN_MULTIPLY || node->tokenType == TOKEN_DIVISION)) {
+        return isFloatExpression(node->left) || isFloatExpression(node->right);
+    }
+    return false;
 }
 
 /**
- * @brief Declares a global constant.
+ * @brief Generates IFJcode24 code for the whole program.
  *
- * @details Handles global constant declaration in IFJcode24. Generates code for built-in functions, function calls,
- * or literal assignments.
+ * @details Instructions are collected into the intermediate representation, optimised
+ * and printed to the output stream at the end.
  *
- * @param node Pointer to the binary tree node representing the constant declaration.
- * @see generateHeader(), generateBuildInFuncions(), generateFunctionCall()
+ * @param ctx Context of the compilation.
+ * @param root Root of the abstract syntax tree.
+ * @param out Output stream for the generated code.
+ * @param stats Optimisation counters to fill (may be NULL).
+ * @see processTokenType(), optimize_program()
  */
-void generateGlobalConstDecl(BinaryTreeNode *node) {
+void generateCode(CompilerContext *ctx, BinaryTreeNode *root, FILE *out, OptimizerStats *stats)
+{
+    IRProgram *result = generateProgram(ctx, root, stats, NULL, false);
+    ir_print(result, out);
+    ir_free_program(result);
+}
 
-    BinaryTreeNode *varNode = node->right;
+// Generates the instructions of the tree into a new program, nothing is optimised yet
+static IRProgram *generateInstructions(CompilerContext *ctx, BinaryTreeNode *root, const Profile *executionProfile,
+                                       bool instrumented)
+{
+    compilerContext = ctx;
+    ctx->program = ir_create_program();
+    ctx->profile = executionProfile;
+    ctx->instrument = instrumented;
+    ctx->branchesFlipped = 0;
+    ctx->tailCallsEliminated = 0;
+    ctx->declaredTypesFunction = 1; // Never 0, the number of the entries of a new table
+    processTokenType(ctx, root);
+    IRProgram *result = ctx->program;
+    ctx->program = NULL;
+    freeGeneratorState(ctx);
+    return result;
+}
 
-    if(varNode->right->right->tokenType == TOKEN_IMPORT) {
-        generateHeader();
-        return;
+/**
+ * @brief Frees what the generator keeps in the context.
+ *
+ * @details Called when the generation ends, also by an error, which leaves the unfinished program
+ * in the context.
+ *
+ * @param ctx Context of the compilation.
+ */
+void freeGeneratorState(CompilerContext *ctx)
+{
+    if (ctx->program) {
+        ir_free_program(ctx->program);
+        ctx->program = NULL;
     }
+    ctx->profile = NULL;
+    free(ctx->declaredTypes);
+    ctx->declaredTypes = NULL;
+    ctx->declaredTypesSize = ctx->declaredTypeCount = 0;
+}
 
-    if (varNode->tokenType == TOKEN_ASSIGNMENT) {
-        if (strcmp(varNode->right->strValue, "ifj") == 0) {
-            generateBuildInFuncions(node);
-            return;
-        }
-        if (varNode->right && varNode->right->type == NODE_FUNC_CALL) {
-            generateFunctionCall(node);
-            return;
-        }
-        return;
+/**
+ * @brief Generates and optimises the program without printing it.
+ *
+ * @details ctx becomes the current context of the thread for the generation and holds the state of
+ * the generator, so threads can generate programs at the same time.
+ *
+ * @param ctx Context of the compilation.
+ * @param root Root of the abstract syntax tree.
+ * @param stats Optimisation counters to fill (may be NULL).
+ * @param executionProfile Profile recorded by --profile-generate (may be NULL).
+ * @param instrumented Generate also the labels counted by --profile-generate.
+ * @return The program, owned by the caller.
+ */
+IRProgram *generateProgram(CompilerContext *ctx, BinaryTreeNode *root, OptimizerStats *stats,
+                           const Profile *executionProfile, bool instrumented)
+{
+    IRProgram *result = generateInstructions(ctx, root, executionProfile, instrumented);
+    finishProgram(result, stats, executionProfile);
+    if (stats) {
+        stats->branchesFlipped = ctx->branchesFlipped;
+        stats->tailCallsEliminated = ctx->tailCallsEliminated;
     }
+    return result;
+}
 
-    const char *varName = varNode->strValue;
-    printf("CONST GF@%s\n", varName);
+/**
+ * @brief Generates the program without optimising it.
+ *
+ * @details The code of every function depends only on the function and the signatures of the
+ * functions it calls (labels and temporaries are numbered per function), so the incremental
+ * compilation can put together a program from functions generated by different compilations
+ * and finish it with finishProgram().
+ *
+ * @param ctx Context of the compilation.
+ * @param root Root of the abstract syntax tree.
+ * @return The program, owned by the caller.
+ */
+IRProgram *generateUnoptimisedProgram(CompilerContext *ctx, BinaryTreeNode *root)
+{
+    return generateInstructions(ctx, root, NULL, false);
+}
 
-    BinaryTreeNode  *valueNode = varNode->right;
+/**
+ * @brief Declares the scratch registers, optimises the program and annotates its frames.
+ *
+ * @param target Generated program (see generateUnoptimisedProgram()).
+ * @param stats Optimisation counters to fill (may be NULL).
+ * @param executionProfile Profile recorded by --profile-generate (may be NULL).
+ */
+void finishProgram(IRProgram *target, OptimizerStats *stats, const Profile *executionProfile)
+{
+    ir_declare_scratch(target);
+    optimize_program(target, stats, executionProfile);
+    ir_annotate_frame_slots(target);
+}
 
-    if (valueNode->tokenType == TOKEN_ASSIGNMENT) {
-        valueNode = valueNode->left;
-        switch (valueNode->tokenType) {
-            case TOKEN_INT_LITERAL:
-                printf("MOVE GF@%s int@%s\n", varName, valueNode->strValue);
-                break;
+/**
+ * @brief Generates one expression into the given program, without the rest of the pipeline.
+ *
+ * @details Used by the microbenchmarks to measure the emission of expressions alone.
+ *
+ * @param target Program receiving the instructions.
+ * @param node Pointer to the expression.
+ * @return Newly allocated operand holding the value of the expression (see generateExpression()).
+ */
+char *generateExpressionInto(IRProgram *target, BinaryTreeNode *node)
+{
+    compilerContext->program = target;
+    char *value = generateExpression(node);
+    compilerContext->program = NULL;
+    return value;
+}
 
-            case TOKEN_FLOAT_LITERAL:
-                printf("MOVE GF@%s float@%s\n", varName, valueNode->strValue);
-                break;
+/**
+ * @brief Generates the header for the IFJcode24 intermediate code.
+ *
+ * This function outputs the initial header line followed by the call of the main function.
+ */
+void generateHeader(){
+    EMIT(".IFJcode24\n");
+    EMIT("CALL $main\n");
+    EMIT("EXIT int@0\n");
+}
 
-            default:
-                printf("MOVE GF@%s string@%s\n", varName, valueNode->strValue);
-                break;
-        }
+/**
+ * @brief Stores the value of an initialiser or an assignment into the target.
+ *
+ * @param valueNode Pointer to the assigned expression or built-in call.
+ * @param target Operand of the assigned variable (e.g. "LF@a").
+ */
+static void generateAssignedValue(BinaryTreeNode *valueNode, const char *target) {
+
+    if (valueNode->type == NODE_FUNC_CALL && valueNode->right && valueNode->right->tokenType == TOKEN_DOT) {
+        generateBuildInFuncions(valueNode, target);
+        return;
+    }
+    if (valueNode->type == NODE_FUNC_CALL) {
+        generateFunctionCall(valueNode, target);
         return;
     }
 
-    valueNode = varNode->right->right->right->left;
+    // Literals, variables and expressions
+    char *value = generateExpression(valueNode);
+    if (value) {
+        EMIT("MOVE %s %s\n", target, value);
+        free(value);
+    }
+}
+
+/**
+ * @brief Declares a variable or constant and generates its initialisation.
+ *
+ * @param varNode Pointer to the identifier node of the declaration.
+ * @param frame Frame of the variable ("GF" or "LF").
+ */
+static void generateDeclaration(BinaryTreeNode *varNode, const char *frame) {
 
+    char target[256];
+    snprintf(target, sizeof(target), "%s@%s", frame, varNode->strValue);
+    emitDefvar(target, varNode->slot);
+    bool typed = recordDeclaredType(varNode);
+
+    BinaryTreeNode *assignNode = move_right_until(varNode->right, TOKEN_ASSIGNMENT);
+    if (!assignNode) {
+        return;
+    }
+    BinaryTreeNode *valueNode = assignNode->left ? assignNode->left : assignNode->right;
     if (!valueNode) {
-        if (strcmp(varNode->right->right->right->right->strValue, "ifj") == 0) {
-            printf("MOVE GF@%s string@%s\n", varName,
-                varNode->right->right->right->right->right->right->left->right->strValue);
-            return;
-        } else if (strcmp(varNode->right->right->strValue, "ifj") == 0) {
-            printf("MOVE GF@%s string@%s\n", varName, varNode->right->right->right->right->left->right->strValue);
+        return;
+    }
+    if (!typed && valueNode->type != NODE_FUNC_CALL && isFloatExpression(valueNode)) {
+        recordType(node_identifier(varNode), TYPE_FLOAT);
+    }
+    generateAssignedValue(valueNode, target);
+}
+
+/**
+ * @brief Generates an assignment to an already declared variable.
+ *
+ * @param node Pointer to the identifier node (followed by "=").
+ * @param frame Frame of the variable ("GF" or "LF").
+ */
+static void generateAssignment(BinaryTreeNode *node, const char *frame) {
+
+    BinaryTreeNode *assignNode = node->right;
+    char target[256];
+    snprintf(target, sizeof(target), "%s@%s", frame, node->strValue);
+
+    if (assignNode->right) {
+        if (assignNode->right->right && assignNode->right->right->tokenType == TOKEN_DOT) {
+            generateAssignedValue(assignNode->right, target);
             return;
         }
+        if (assignNode->right->type == NODE_FUNC_CALL) {
+            generateFunctionCall(assignNode->right, target);
+        }
         return;
     }
+    if (assignNode->left) {
+        generateAssignedValue(assignNode->left, target);
+    }
+}
 
+/**
+ * @brief Declares a global variable.
+ *
+ * @details Handles global variable declaration in IFJcode24. Generates code for built-in functions, function calls,
+ * or literal assignments.
+ *
+ * @param node Pointer to the binary tree node representing the variable declaration.
+ * @see generateBuildInFuncions(), generateFunctionCall()
+ */
+void generateGlobalVarDecl(BinaryTreeNode *node) {
 
-    switch (valueNode->tokenType) {
-        case TOKEN_INT_LITERAL:
-            printf("MOVE LF@%s int@%s\n", varName, valueNode->strValue);
-            break;
+    BinaryTreeNode *varNode = node->right;
+    if (varNode->tokenType == TOKEN_ASSIGNMENT) {
+        generateAssignment(node, "GF");
+        return;
+    }
+    generateDeclaration(varNode, "GF");
+}
 
-        case TOKEN_FLOAT_LITERAL:
-            printf("MOVE LF@%s float@%s\n", varName, valueNode->strValue);
-            break;
+/**
+ * @brief Declares local variables.
+ *
+ * @details Handles local variable declaration in IFJcode24. Generates code for built-in functions, function calls,
+ * or literal assignments.
+ *
+ * @param node Pointer to the binary tree node representing the variable declaration.
+ * @see generateBuildInFuncions(), generateFunctionCall()
+ */
+void generateLocalVarDecl(BinaryTreeNode *node) {
 
-        default:
-            printf("MOVE LF@%s string@%s\n", varName, valueNode->strValue);
-            break;
+    BinaryTreeNode *varNode = node->right;
+    if (varNode->tokenType == TOKEN_ASSIGNMENT) {
+        generateAssignment(node, "LF");
+        return;
     }
+    generateDeclaration(varNode, "LF");
+}
+
+/**
+ * @brief Declares a global constant.
+ *
+ * @details Handles global constant declaration in IFJcode24. Generates code for built-in functions, function calls,
+ * or literal assignments.
+ *
+ * @param node Pointer to the binary tree node representing the constant declaration.
+ * @see generateHeader(), generateBuildInFuncions(), generateFunctionCall()
+ */
+void generateGlobalConstDecl(BinaryTreeNode *node) {
+
+    BinaryTreeNode *varNode = node->right;
+
+    if(varNode->right->right->tokenType == TOKEN_IMPORT) {
+        generateHeader();
+        return;
+    }
+
+    if (varNode->tokenType == TOKEN_ASSIGNMENT) {
+        generateAssignment(node, "GF");
+        return;
+    }
+    generateDeclaration(varNode, "GF");
 }
 
 /**
@@ -264,179 +516,167 @@ void generateLocalConstDecl(BinaryTreeNode *node) {
 
         BinaryTreeNode *varNode = node->right;
         if (varNode->tokenType == TOKEN_ASSIGNMENT) {
-            if (strcmp(varNode->right->strValue, "ifj") == 0) {
-                generateBuildInFuncions(node);
-                return;
-            }
-            if (varNode->right && varNode->right->type == NODE_FUNC_CALL) {
-                generateFunctionCall(node);
-                return;
-            }
-            return;
-        }
-
-        const char *varName = varNode->strValue;
-        printf("CONST LF@%s\n", varName);
-
-    BinaryTreeNode  *valueNode = varNode->right;
-
-        if (valueNode->tokenType == TOKEN_ASSIGNMENT) {
-            valueNode = valueNode->left;
-            switch (valueNode->tokenType) {
-                case TOKEN_INT_LITERAL:
-                    printf("MOVE LF@%s int@%s\n", varName, valueNode->strValue);
-                    break;
-
-                case TOKEN_FLOAT_LITERAL:
-                    printf("MOVE LF@%s float@%s\n", varName, valueNode->strValue);
-                    break;
-
-                default:
-                    printf("MOVE LF@%s string@%s\n", varName, valueNode->strValue);
-                    break;
-            }
-            return;
-        }
-
-        valueNode = varNode->right->right->right->left;
-
-        if (!valueNode) {
-            if (strcmp(varNode->right->right->right->right->strValue, "ifj") == 0) {
-                printf("MOVE LF@%s string@%s\n", varName,
-                    varNode->right->right->right->right->right->right->left->right->strValue);
-                return;
-            } else if (strcmp(varNode->right->right->strValue, "ifj") == 0) {
-                printf("MOVE LF@%s string@%s\n", varName, varNode->right->right->right->right->left->right->strValue);
-                return;
-            }
+            generateAssignment(node, "LF");
             return;
         }
-
-        switch (valueNode->tokenType) {
-            case TOKEN_INT_LITERAL:
-                printf("MOVE LF@%s int@%s\n", varName, valueNode->strValue);
-                break;
-
-            case TOKEN_FLOAT_LITERAL:
-                printf("MOVE LF@%s float@%s\n", varName, valueNode->strValue);
-                break;
-
-            default:
-                printf("MOVE LF@%s string@%s\n", varName, valueNode->strValue);
-                break;
-        }
+        generateDeclaration(varNode, "LF");
     }
 
 /**
- * @brief Generates built-in functions for the given node.
+ * @brief Generates a call of a built-in function.
  *
- * @details Handles the generation of built-in functions such as write, read, type conversion, and string operations.
+ * @details The descriptor of the function was left on the call node by semantic analysis (it is looked
+ * up here only for a tree that did not go through it). The call is inlined
+ * by the descriptor's emit callback (READ, WRITE, STRLEN, CONCAT, INT2FLOAT, GETCHAR, STRI2INT, ...),
+ * no CALL instruction is generated. A result that is not stored anywhere goes to a scratch register.
  *
- * @param node Pointer to the binary tree node representing the function call.
- * @see generateHeader(), generateLocalConstDecl()
+ * @param node Pointer to the "ifj" node of the call (followed by ".", the name and the arguments).
+ * @param dst Operand receiving the result, NULL when the result is not used.
+ * @see builtin_lookup()
  */
-void generateBuildInFuncions(BinaryTreeNode *node) {
-        
-        BinaryTreeNode *writeNode = node->right->right;
+void generateBuildInFuncions(BinaryTreeNode *node, const char *dst) {
 
-        if (strcmp(writeNode->strValue, "write") == 0) {
-            BinaryTreeNode *argNode = writeNode->left->right;
-            printf("WRITE %s\n", argNode->strValue);
-            return;
+        BinaryTreeNode *nameNode = node->right->right;
+        const BuiltinDescriptor *builtin = node->builtin ? node->builtin : builtin_lookup(node_identifier(nameNode));
+        if (!builtin) {
+            handle_error(ERR_UNDEFINED_ID);
         }
 
-        BinaryTreeNode *curretntNode = node->right->right->right->right;
-
-        if (strcmp(curretntNode->strValue, "readi32") == 0) {
-            printf("READ LF/GF@%s int\n", node->strValue);
-            return;
-        } else if (strcmp(curretntNode->strValue, "readf64") == 0) {
-            printf("READ LF/GF@%s float\n", node->strValue);
-            return;
-        } else if (strcmp(curretntNode->strValue, "readstr") == 0) {
-            printf("READ LF/GF@%s string\n", node->strValue);
-            return;
+        char *args[BUILTIN_MAX_PARAMS] = {NULL};
+        int argCount = 0;
+        BinaryTreeNode *argNode = nameNode->left ? nameNode->left->right : NULL;
+        for (; argNode && argNode->tokenType != TOKEN_RPAREN; argNode = argNode->right) {
+            if (argNode->tokenType == TOKEN_COMMA) {
+                continue;
+            }
+            if (argCount == BUILTIN_MAX_PARAMS) {
+                handle_error(ERR_FUNC_PARAM);
+            }
+            args[argCount++] = generateOperand(argNode);
         }
-
-        if (strcmp(curretntNode->strValue, "i2f") == 0) {
-            printf("INT2FLOAT GF@result  LF/GF@%s\n", node->strValue);
-            printf("MOVE LF@%s GF@result\n", node->strValue);
-            return;
+        if (argCount != builtin->arity) {
+            handle_error(ERR_FUNC_PARAM);
         }
 
-
-        if (strcmp(curretntNode->strValue, "f2i") == 0) {
-            printf("FLOAT2INT GF@result  LF/GF@%s\n", node->strValue);
-            printf("MOVE LF@%s GF@result\n", node->strValue);
-            return;
+        char discarded[32];
+        if (!dst && builtin->returnType != TYPE_VOID) {
+            ir_scratch_acquire(compilerContext->program, discarded, sizeof(discarded));
+            dst = discarded;
         }
 
-
-
-        if (strcmp(curretntNode->strValue, "length") == 0) {
-            printf("MOVE GF@result  string@%s\n", curretntNode->left->right->strValue);
-            printf("STRLEN LF@%s GF@result  \n", node->strValue);
-            return;
+        builtin->emit(compilerContext->program, dst, (const char *const *)args);
+        if (dst == discarded) {
+            ir_scratch_release(compilerContext->program, discarded);
         }
 
-
-    if (strcmp(curretntNode->strValue ,"concat") == 0) {
-        printf("CONCAT GF@result  string@%s string@%s\n", curretntNode->left->right->strValue, curretntNode->left->right->right->right->strValue);
-        printf("MOVE LF@%s GF@result  \n", node->strValue);
-        return;
+        for (int i = 0; i < argCount; i++) {
+            free(args[i]);
+        }
     }
 
+/**
+ * @brief Decides from the profile whether the else branch of an if statement is the hot one.
+ *
+ * @details "$name%if_start_N" is reached every time the statement is executed and "$name%if_N" every
+ * time the then branch is taken, the rest of the executions went to the else branch.
+ *
+ * @param labelNumber Number of the if statement in its function.
+ * @return true when the else branch was taken more often than the then branch.
+ */
+static bool isElseBranchHot(int labelNumber) {
 
+    if (!compilerContext->profile) {
+        return false;
     }
+    char label[300];
+    compiler_label(label, sizeof(label), "if_start", labelNumber);
+    long long executed = profile_count(compilerContext->profile, PROFILE_LABEL, label);
+    compiler_label(label, sizeof(label), "if", labelNumber);
+    long long taken = profile_count(compilerContext->profile, PROFILE_LABEL, label);
+    return executed - taken > taken;
+}
 
 /**
  * @brief Generates an if statement.
  *
- * @details Handles the generation of an if statement in the IFJcode24 intermediate code. It evaluates the condition
- * and generates the corresponding labels and code blocks.
+ * @details Handles the generation of an if statement in the IFJcode24 intermediate code. The condition is fused
+ * into the conditional jump (see generateConditionalJump()). The branch placed last falls through to the code
+ * after the statement, the other one ends with a JUMP. With an else branch, the condition jumps to the then
+ * branch placed last, unless the execution profile shows that the else branch is hotter; then the condition
+ * jumps to "$name%if_else_N" and the else branch goes last. Without an else branch, or with an empty one
+ * ("else {}", which IFJ24 requires when there is nothing to do), the condition jumps over the then branch. Labels nothing jumps to ("$name%if_start_N", "$name%if_N" in front of a fall-through) are generated
+ * only for --profile-generate. Their names do not depend on the layout, so a profile stays usable.
  *
  * @param node Pointer to the binary tree node representing the if statement.
  */
 void generateIfStatement(BinaryTreeNode *node) {
 
-        const char *conditionVar = generateExpression(node->right->left->left);
-
-        static int labelCounter = 0;
-        int labelNumber = labelCounter++;
-
-        printf("LABEL $if_start_%d\n", labelNumber);
-        printf("JUMPIFEQ$if_%d LF@%s\n", labelNumber, conditionVar);
-        if (node->left) {
-            generateBody(node->left->right->left);
-            printf("JUMP $if_end_%d\n", labelNumber);
+        BinaryTreeNode *condition = node->right->left->left;
+        BinaryTreeNode *thenBody = node->right->right->left;
+        BinaryTreeNode *elseBody = node->left ? node->left->right->left : NULL;
+        bool hasElse = elseBody && !(elseBody->type == NODE_GENERAL && elseBody->tokenType == TOKEN_EMPTY &&
+                                     !elseBody->right);
+
+        int labelNumber = compilerContext->ifLabelCounter++;
+        char thenLabel[300], elseLabel[300], endLabel[300];
+        compiler_label(thenLabel, sizeof(thenLabel), "if", labelNumber);
+        compiler_label(elseLabel, sizeof(elseLabel), "if_else", labelNumber);
+        compiler_label(endLabel, sizeof(endLabel), "if_end", labelNumber);
+
+        if (compilerContext->instrument) {
+            char startLabel[300];
+            compiler_label(startLabel, sizeof(startLabel), "if_start", labelNumber);
+            EMIT("LABEL %s", startLabel);
         }
 
-        generateBody(node->right->right->left);
+        bool elseHot = hasElse && isElseBranchHot(labelNumber);
+        if (!hasElse || elseHot) {
+            compilerContext->branchesFlipped += elseHot;
+            generateConditionalJump(condition, false, hasElse ? elseLabel : endLabel);
+            if (compilerContext->instrument) {
+                EMIT("LABEL %s", thenLabel);
+            }
+            generateBody(thenBody);
+            if (hasElse) {
+                EMIT("JUMP %s", endLabel);
+                EMIT("LABEL %s", elseLabel);
+                generateBody(elseBody);
+            }
+            EMIT("LABEL %s", endLabel);
+            return;
+        }
 
-        printf("LABEL $if_end_%d\n", labelNumber);
+        generateConditionalJump(condition, true, thenLabel);
+        generateBody(elseBody);
+        EMIT("JUMP %s", endLabel);
+        EMIT("LABEL %s", thenLabel);
+        generateBody(thenBody);
+        EMIT("LABEL %s", endLabel);
     }
 
 /**
  * @brief Generates a while statement.
  *
- * @details Handles the generation of a while statement in the IFJcode24 intermediate code. It evaluates the condition
- * at the beginning of each iteration and generates the loop body and control flow.
+ * @details The loop is rotated into a guarded do-while: the condition is tested once before the loop
+ * (jumping to "$name%while_end_N" when it does not hold) and again after the body, where a conditional jump
+ * returns to "$name%while_start_N". Every iteration then executes a single branch instead of the exit test
+ * and the JUMP back. The condition is generated twice, its temporaries are separate variables.
  *
  * @param node Pointer to the binary tree node representing the while statement.
  */
 void generateWhileStatement(BinaryTreeNode *node) {
 
-        static int labelCounter = 0;
-        int labelNumber = labelCounter++;
-        printf("LABEL $while_start_%d\n", labelNumber);
+        int labelNumber = compilerContext->whileLabelCounter++;
+        char startLabel[300], endLabel[300];
+        compiler_label(startLabel, sizeof(startLabel), "while_start", labelNumber);
+        compiler_label(endLabel, sizeof(endLabel), "while_end", labelNumber);
 
         BinaryTreeNode *conditionNode = node->left->left;
-        const char *conditionVar = generateExpression(conditionNode);
-        
-        printf("JUMPIFNOT  $while_end_%d LF@%s\n", labelNumber, conditionVar);
+        generateConditionalJump(conditionNode, false, endLabel);
+        EMIT("LABEL %s", startLabel);
         generateBody(node->right->left);
-        printf("JUMP  $while_end_%d LF@%s\n", labelNumber, conditionVar);
-        printf("LABEL $while_end_%d\n", labelNumber);
+        generateConditionalJump(conditionNode, true, startLabel);
+        EMIT("LABEL %s", endLabel);
     }
 
 /**
@@ -449,28 +689,102 @@ void generateWhileStatement(BinaryTreeNode *node) {
 void generateFunctionParams(BinaryTreeNode *node) {
 
         BinaryTreeNode *fnNameNode = node->right->right;
-        const char *functionName = fnNameNode->strValue;
+        const char *functionName = node_identifier(fnNameNode);
+        compiler_begin_function(functionName);
 
-        printf("LABEL $%s\n", functionName);
-        printf("CREATEFRAME\n");
-        printf("PUSHFRAME\n");
+        EMIT("LABEL $%s\n", functionName);
+        EMIT("CREATEFRAME\n");
+        EMIT("PUSHFRAME\n");
 
+        // Arguments were pushed in order, the last one is on top of the data stack
+        const char **params = compilerContext->currentFunction.params;
+        int paramCount = 0;
+        beginDeclaredTypes();
         BinaryTreeNode *paramNode = fnNameNode->left;
 
         paramNode = paramNode->right;
         while (paramNode && paramNode->tokenType != TOKEN_RPAREN) {
             if (paramNode->tokenType == TOKEN_IDENTIFIER) {
-                const char *paramName = paramNode->strValue;
-                printf("DEFVAR LF@%s\n", paramName);
+                if (paramCount == FUNCTION_PARAMS_MAX) {
+                    handle_error(ERR_COMPILER_INTERNAL);
+                }
+                params[paramCount++] = paramNode->strValue;
+                recordDeclaredType(paramNode);
+                char target[256];
+                snprintf(target, sizeof(target), "LF@%s", paramNode->strValue);
+                emitDefvar(target, paramNode->slot);
             }
             paramNode = paramNode->right;
         }
+        for (int i = paramCount - 1; i >= 0; i--) {
+            EMIT("POPS LF@%s\n", params[i]);
+        }
+        compilerContext->currentFunction.name = functionName;
+        compilerContext->currentFunction.paramCount = paramCount;
+        compilerContext->currentFunction.tailCalled = false;
+
+        int bodyStart = compilerContext->program->count;
         fnNameNode = node->right->right->right->right;
         generateBody(fnNameNode);
-        if (strcmp(node->right->right->right->strValue, "void") == 0) {
-            printf("POPFRAME\n");
-            printf("RETURN\n");
+        if (node_keyword(node->right->right->right) == KEYWORD_VOID) {
+            EMIT("POPFRAME\n");
+            EMIT("RETURN\n");
+        }
+
+        // Every declaration of the body is executed once, right after the parameters
+        ir_hoist_defvars(compilerContext->program, bodyStart);
+
+        // Self tail calls continue after the declarations, which must not be executed again
+        if (compilerContext->currentFunction.tailCalled) {
+            int entry = bodyStart;
+            while (entry < compilerContext->program->count && compilerContext->program->code[entry].op == IR_DEFVAR) {
+                entry++;
+            }
+            char label[300];
+            snprintf(label, sizeof(label), "$%s%%tail", functionName);
+            ir_insert(compilerContext->program, entry, IR_LABEL, label, NULL, NULL);
+        }
+        compilerContext->currentFunction.name = NULL;
+        compiler_begin_function(NULL);
+    }
+
+/**
+ * @brief Generates "return f(...)".
+ *
+ * @details The value returned by the callee is left on the data stack, which is exactly where the caller
+ * expects the returned value, so the call is followed just by POPFRAME and RETURN. A call of the function
+ * itself is a self tail call: the arguments are pushed and popped into the parameters like in the prologue,
+ * and the function continues from its start without a new frame (label "$name%tail" after the declarations).
+ *
+ * @param callNode Pointer to the function name node of the call.
+ */
+static void generateReturnCall(BinaryTreeNode *callNode) {
+
+        bool selfCall = node_identifier(callNode) == compilerContext->currentFunction.name;
+        BinaryTreeNode *argNode = callNode->left ? callNode->left->right : NULL;
+        int argCount = 0;
+        for (; argNode && argNode->tokenType != TOKEN_RPAREN; argNode = argNode->right) {
+            if (argNode->tokenType == TOKEN_COMMA) {
+                continue;
+            }
+            char *operand = generateOperand(argNode);
+            EMIT("PUSHS %s\n", operand);
+            free(operand);
+            argCount++;
+        }
+
+        if (selfCall && argCount == compilerContext->currentFunction.paramCount) {
+            for (int i = compilerContext->currentFunction.paramCount - 1; i >= 0; i--) {
+                EMIT("POPS LF@%s\n", compilerContext->currentFunction.params[i]);
+            }
+            EMIT("JUMP $%s%%tail\n", compilerContext->currentFunction.name);
+            compilerContext->currentFunction.tailCalled = true;
+            compilerContext->tailCallsEliminated++;
+            return;
         }
+        emitCall(callNode->strValue);
+        EMIT("POPFRAME\n");
+        EMIT("RETURN\n");
     }
 
 /**
@@ -483,81 +797,238 @@ void generateFunctionParams(BinaryTreeNode *node) {
 void generateFunctionEnd(BinaryTreeNode *node) {
 
         BinaryTreeNode *returnNode = node->left;
+        BinaryTreeNode *callNode = node->right;
+
+        if (callNode && callNode->type == NODE_FUNC_CALL) {
+            if (!(callNode->right && callNode->right->tokenType == TOKEN_DOT)) {
+                generateReturnCall(callNode);
+                return;
+            }
+            char result[32];
+            ir_scratch_acquire(compilerContext->program, result, sizeof(result));
+            generateBuildInFuncions(callNode, result);
+            EMIT("PUSHS %s\n", result);
+            ir_scratch_release(compilerContext->program, result);
+            EMIT("POPFRAME\n");
+            EMIT("RETURN\n");
+            return;
+        }
+
+        char *returnValue = generateExpression(returnNode);
+        if (returnValue) {
+            EMIT("PUSHS %s\n", returnValue);
+            free(returnValue);
+        }
+        EMIT("POPFRAME\n");
+        EMIT("RETURN\n");
+    }
+
+/**
+ * @brief Renders a leaf of an expression as an IFJcode24 operand.
+ *
+ * @param node Pointer to the variable or literal node.
+ * @return Newly allocated operand text (e.g. "LF@a", "int@5").
+ */
+static char *generateOperand(BinaryTreeNode *node) {
 
-        const char *returnValue = generateExpression(returnNode);
-        if (!returnValue) {
-            printf("RETURN\n");
-            printf("POPFRAME\n");
+        // Literals come already rendered from the literal pool
+        const char *value = node->literal >= 0 ? literal_pool_operand(node->literal) : node->strValue;
+        const char *format;
+        switch (node->tokenType) {
+            case TOKEN_INT_LITERAL:
+                format = node->literal >= 0 ? "%s" : "int@%s";
+                break;
+            case TOKEN_FLOAT_LITERAL:
+                format = node->literal >= 0 ? "%s" : "float@%s";
+                break;
+            case TOKEN_STRING_LITERAL:
+                if (node->literal < 0) {
+                    return literal_encode(node->strValue);
+                }
+                format = "%s";
+                break;
+            case TOKEN_NULL:
+                format = "nil@nil";
+                break;
+            default:
+                format = "LF@%s";
+                break;
+        }
+
+        char *operand = malloc(strlen(value) + 16);
+        if (!operand) {
+            handle_error(ERR_COMPILER_INTERNAL);
+        }
+        sprintf(operand, format, value);
+        return operand;
+    }
+
+/**
+ * @brief Returns the instruction computing an operation node.
+ *
+ * @param node Pointer to the operation node.
+ * @param negate Set when the result of the instruction has to be negated (!=, <=, >=).
+ * @return Mnemonic of the instruction, NULL for an unknown operator.
+ */
+static const char *operationInstruction(BinaryTreeNode *node, bool *negate) {
+
+        *negate = false;
+        switch (node->tokenType) {
+            case TOKEN_ADDITION:
+                return "ADD";
+            case TOKEN_SUBTRACTION:
+                return "SUB";
+            case TOKEN_MULTIPLY:
+                return "MUL";
+            case TOKEN_DIVISION:
+                return isIntegerDivision(node->left, node->right) ? "IDIV" : "DIV";
+            case TOKEN_EQUAL:
+                return "EQ";
+            case TOKEN_NOT_EQUAL:
+                *negate = true;
+                return "EQ";
+            case TOKEN_LESS_THAN:
+                return "LT";
+            case TOKEN_LESS_EQUAL:
+                *negate = true;
+                return "GT";
+            case TOKEN_GREATER_EQUAL:
+                *negate = true;
+                return "LT";
+            case TOKEN_GREATER_THAN:
+                return "GT";
+            default:
+                return NULL;
+        }
+    }
+
+/**
+ * @brief Declares a new temporary holding the result of an operation node.
+ *
+ * @param node Pointer to the operation node (its slot is used for the temporary).
+ * @return Newly allocated operand of the temporary.
+ */
+static char *newTemporary(BinaryTreeNode *node) {
+
+        char *resultVar = malloc(32);
+        if (!resultVar) {
+            handle_error(ERR_COMPILER_INTERNAL);
+        }
+        sprintf(resultVar, "LF@temp_var_e%d", compilerContext->tempCounter++);
+        emitDefvar(resultVar, node->slot);
+        return resultVar;
+    }
+
+/**
+ * @brief Generates a jump taken when the condition evaluates to the given value.
+ *
+ * @details Equality conditions are fused into JUMPIFEQ / JUMPIFNEQ comparing both operands directly.
+ * Other relations are computed by LT or GT and the jump compares the result with the expected literal,
+ * so the NOT of <= and >= is folded into the jump as well.
+ *
+ * @param condition Pointer to the condition expression.
+ * @param jumpIf Value of the condition for which the jump is taken.
+ * @param label Target label.
+ */
+static void generateConditionalJump(BinaryTreeNode *condition, bool jumpIf, const char *label) {
+
+        char *leftOperand, *rightOperand;
+        if (condition && condition->type == NODE_OP &&
+            (condition->tokenType == TOKEN_EQUAL || condition->tokenType == TOKEN_NOT_EQUAL)) {
+            generateOperands(condition, &leftOperand, &rightOperand);
+            bool equal = (condition->tokenType == TOKEN_EQUAL) == jumpIf;
+            EMIT("%s %s %s %s", equal ? "JUMPIFEQ" : "JUMPIFNEQ", label, leftOperand, rightOperand);
+            free(leftOperand);
+            free(rightOperand);
             return;
         }
 
-        printf("RETURN LF@%s\n", returnValue);
-        printf("POPFRAME\n");
+        bool negate = false;
+        char *value;
+        if (condition && condition->type == NODE_OP && operationInstruction(condition, &negate) &&
+            (condition->tokenType == TOKEN_LESS_THAN || condition->tokenType == TOKEN_LESS_EQUAL ||
+             condition->tokenType == TOKEN_GREATER_THAN || condition->tokenType == TOKEN_GREATER_EQUAL)) {
+            generateOperands(condition, &leftOperand, &rightOperand);
+            value = newTemporary(condition);
+            EMIT("%s %s %s %s", operationInstruction(condition, &negate), value, leftOperand, rightOperand);
+            free(leftOperand);
+            free(rightOperand);
+        } else {
+            value = generateExpression(condition);
+        }
+        EMIT("JUMPIFEQ %s %s bool@%s", label, value, jumpIf != negate ? "true" : "false");
+        free(value);
+    }
+
+/**
+ * @brief Generates both operands of an operation.
+ *
+ * @details IFJ24 converts an integer literal next to an f64 operand to f64, IFJcode24 does not,
+ * so such a literal is emitted as a float literal ("fl * 3" multiplies by float@0x1.8p+1).
+ *
+ * @param node Pointer to the operation node.
+ * @param left Receives the newly allocated left operand.
+ * @param right Receives the newly allocated right operand.
+ */
+static void generateOperands(BinaryTreeNode *node, char **left, char **right) {
+
+        BinaryTreeNode *operands[2] = {node->left, node->right};
+        char **results[2] = {left, right};
+        for (int i = 0; i < 2; i++) {
+            BinaryTreeNode *operand = operands[i];
+            if (operand && operand->tokenType == TOKEN_INT_LITERAL && operand->value.kind == VALUE_INT &&
+                isFloatExpression(operands[1 - i])) {
+                *results[i] = malloc(64);
+                if (!*results[i]) {
+                    handle_error(ERR_COMPILER_INTERNAL);
+                }
+                snprintf(*results[i], 64, "float@%a", (double)operand->value.intValue);
+                continue;
+            }
+            *results[i] = generateExpression(operand);
+        }
     }
 
 /**
  * @brief Generates an expression.
  *
  * @details Evaluates an expression node and generates the corresponding intermediate code for the IFJcode24 language.
- * Supports variables, constants, and operations.
+ * Supports variables, constants, and operations. Every operation stores its result into a new temporary,
+ * duplicates are merged later by optimize_local_cse(). IFJcode24 has no NEQ, LEQ and GEQ instructions,
+ * so these are generated as the negation of EQ, GT and LT.
  *
  * @param node Pointer to the binary tree node representing the expression.
- * @return The name of the variable storing the result of the expression.
+ * @return Newly allocated operand holding the result of the expression (variable or literal),
+ * freed by the caller.
  */
-const char *generateExpression(BinaryTreeNode *node) {
+char *generateExpression(BinaryTreeNode *node) {
 
         if (!node) {
             return NULL;
         }
 
         if (node->type == NODE_VAR || node->type == NODE_CONST) {
-            return node->strValue;
+            return generateOperand(node);
         }
 
         if (node->type == NODE_OP) {
-            const char *leftOperand = generateExpression(node->left);
-            const char *rightOperand = generateExpression(node->right);
-
-            static int tempVarCounter = 0;
-            char *resultVar = malloc(20);
-            sprintf(resultVar, "temp_var_e%d", tempVarCounter++);
-
-            printf("DEFVAR LF@%s\n", resultVar);
-
-            switch (node->tokenType) {
-                case TOKEN_ADDITION:
-                    printf("ADD LF@%s LF@%s LF@%s\n", resultVar, leftOperand, rightOperand);
-                    break;
-                case TOKEN_SUBTRACTION:
-                    printf("SUB LF@%s LF@%s LF@%s\n", resultVar, leftOperand, rightOperand);
-                    break;
-                case TOKEN_MULTIPLY:
-                    printf("MUL LF@%s LF@%s LF@%s\n", resultVar, leftOperand, rightOperand);
-                    break;
-                case TOKEN_DIVISION:
-                    printf("DIV LF@%s LF@%s LF@%s\n", resultVar, leftOperand, rightOperand);
-                    break;
-                case TOKEN_EQUAL:
-                    printf("EQ LF@%s LF@%s LF@%s\n", resultVar, leftOperand, rightOperand);
-                    break;
-                case TOKEN_NOT_EQUAL:
-                    printf("NEQ LF@%s LF@%s LF@%s\n", resultVar, leftOperand, rightOperand);
-                    break;
-                case TOKEN_LESS_THAN:
-                    printf("LT LF@%s LF@%s LF@%s\n", resultVar, leftOperand, rightOperand);
-                    break;
-                case TOKEN_LESS_EQUAL:
-                    printf("LEQ LF@%s LF@%s LF@%s\n", resultVar, leftOperand, rightOperand);
-                    break;
-                case TOKEN_GREATER_EQUAL:
-                    printf("GEQ LF@%s LF@%s LF@%s\n", resultVar, leftOperand, rightOperand);
-                    break;
-                case TOKEN_GREATER_THAN:
-                    printf("GT LF@%s LF@%s LF@%s\n", resultVar, leftOperand, rightOperand);
-                    break;
-                default:
-                    free(resultVar);
-                    return NULL;
+            char *leftOperand, *rightOperand;
+            generateOperands(node, &leftOperand, &rightOperand);
+
+            bool negate = false;
+            const char *instruction = operationInstruction(node, &negate);
+            if (!instruction) {
+                free(leftOperand);
+                free(rightOperand);
+                return NULL;
+            }
+
+            char *resultVar = newTemporary(node);
+            EMIT("%s %s %s %s", instruction, resultVar, leftOperand, rightOperand);
+            free(leftOperand);
+            free(rightOperand);
+            if (negate) {
+                EMIT("NOT %s %s", resultVar, resultVar);
             }
             return resultVar;
         }
@@ -567,25 +1038,30 @@ const char *generateExpression(BinaryTreeNode *node) {
 /**
  * @brief Generates a function call.
  *
- * @details Handles the generation of a function call by pushing function parameters onto the stack,
- * calling the function, and handling the return value.
+ * @details Arguments are pushed onto the data stack in order and the callee pops them into its
+ * parameters. A returned value is left on the data stack; it is popped into the destination,
+ * or the stack is cleared when the result is not used (void functions push nothing).
  *
- * @param node Pointer to the binary tree node representing the function call.
+ * @param node Pointer to the function name node of the call (followed by the argument list).
+ * @param dst Operand receiving the returned value, NULL when the result is not used.
  */
-void generateFunctionCall(BinaryTreeNode *node) {
+void generateFunctionCall(BinaryTreeNode *node, const char *dst) {
 
-        BinaryTreeNode *functionNameNode = node->right->right;
-        const char *functionName = functionNameNode->strValue;
-        BinaryTreeNode *functionParams = functionNameNode->left->right;
-        while (functionParams->tokenType == TOKEN_IDENTIFIER) {
-            printf("PUSH LF@%s\n", functionParams->strValue);
-            functionParams = functionParams->right;
-            if (functionParams->tokenType == TOKEN_COMMA) {
-                functionParams = functionParams->right;
+        BinaryTreeNode *argNode = node->left ? node->left->right : NULL;
+        for (; argNode && argNode->tokenType != TOKEN_RPAREN; argNode = argNode->right) {
+            if (argNode->tokenType == TOKEN_COMMA) {
+                continue;
             }
+            char *operand = generateOperand(argNode);
+            EMIT("PUSHS %s\n", operand);
+            free(operand);
+        }
+        emitCall(node->strValue);
+        if (dst) {
+            EMIT("POPS %s", dst);
+        } else {
+            EMIT("CLEARS");
         }
-        printf("CALL  $%s\n", functionName);
-        printf("POPS  LF@%s\n", node->strValue);
     }
 
 /**
@@ -602,16 +1078,25 @@ void generateBody(BinaryTreeNode *node) {
         }
         switch (node->type) {
             case NODE_VAR:
-                if (strcmp(node->strValue, "return") == 0) {
-                    generateFunctionEnd(node);
-                } else if (strcmp(node->strValue, "while") == 0) {
-                    generateWhileStatement(node);
-                } else if (strcmp(node->strValue, "ifj") == 0) {
-                    generateBuildInFuncions(node);
-                } else if (strcmp(node->strValue, "if") == 0) {
-                    generateIfStatement(node);
-                } else {
-                    generateLocalVarDecl(node);
+                switch (node_keyword(node)) {
+                    case KEYWORD_RETURN:
+                        generateFunctionEnd(node);
+                        break;
+                    case KEYWORD_WHILE:
+                        generateWhileStatement(node);
+                        break;
+                    case KEYWORD_IF:
+                        generateIfStatement(node);
+                        break;
+                    default:
+                        if (node->right && node->right->tokenType == TOKEN_DOT) {
+                            generateBuildInFuncions(node, NULL);
+                        } else if (node->left && node->left->tokenType == TOKEN_LPAREN) {
+                            generateFunctionCall(node, NULL);
+                        } else {
+                            generateLocalVarDecl(node);
+                        }
+                        break;
                 }
                 break;
             case NODE_CONST:
@@ -620,7 +1105,7 @@ void generateBody(BinaryTreeNode *node) {
                 }
                 break;
             case NODE_OP:
-                generateExpression(node);
+                free(generateExpression(node));
                 break;
             case NODE_GENERAL:
                 if (node->tokenType == TOKEN_EMPTY) {
@@ -636,8 +1121,8 @@ void generateBody(BinaryTreeNode *node) {
             default:
                 break;
         }
-        if (node->left && !strcmp(node->strValue, "while") == 0 && !strcmp(node->strValue, "return") == 0 &&
-            !strcmp(node->strValue, "if") == 0) {
+        Keyword keyword = node_keyword(node);
+        if (node->left && keyword != KEYWORD_WHILE && keyword != KEYWORD_RETURN && keyword != KEYWORD_IF) {
             generateBody(node->left);
         }
     }
@@ -648,9 +1133,10 @@ void generateBody(BinaryTreeNode *node) {
  * @details This function processes the type of the binary tree node, handling different cases such as variable declarations,
  * function definitions, constants, control flow structures, and general nodes.
  *
+ * @param ctx Context of the compilation.
  * @param node Pointer to the binary tree node to be processed.
  */
-void processTokenType(BinaryTreeNode *node) {
+void processTokenType(CompilerContext *ctx, BinaryTreeNode *node) {
         if (!node) {
             return; 
         }
@@ -676,17 +1162,17 @@ void processTokenType(BinaryTreeNode *node) {
                 generateWhileStatement(node);
                 break;
             case NODE_OP:
-                generateExpression(node);
+                free(generateExpression(node));
                 break;
             case NODE_GENERAL:
-                if (node->right) processTokenType(node->right);
+                if (node->right) processTokenType(ctx, node->right);
                 break;
             default:
-                printf("Unhandled node type: %s\n", node->strValue ? node->strValue : "NULL");
+                fprintf(compiler_diagnostics(), "Unhandled node type: %s\n", node->strValue ? node->strValue : "NULL");
                 break;
         }
         if (!node->left) {
             return;
         }
-        processTokenType(node->left);
+        processTokenType(ctx, node->left);
     }
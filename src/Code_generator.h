@@ -14,10 +14,61 @@
 #include "ast.h"
 #include "stack.h"
 #include "lexical_analyser.h"
+#include "ir.h"
+#include "optimizer.h"
+#include "profile.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 
+/**
+ * @brief Generates, optimises and prints IFJcode24 code for the whole program.
+ *
+ * @param ctx Context of the compilation.
+ * @param root Root of the abstract syntax tree.
+ * @param out Output stream for the generated code.
+ * @param stats Optimisation counters to fill (may be NULL).
+ */
+void generateCode(CompilerContext *ctx, BinaryTreeNode *root, FILE *out, OptimizerStats *stats);
+
+/**
+ * @brief Generates and optimises IFJcode24 code for the whole program without printing it.
+ *
+ * @param ctx Context of the compilation.
+ * @param root Root of the abstract syntax tree.
+ * @param stats Optimisation counters to fill (may be NULL).
+ * @param executionProfile Profile recorded by --profile-generate, guides branch layout (may be NULL).
+ * @param instrumented Keep the labels counted by --profile-generate even when nothing jumps to them.
+ * @return The generated program, to be freed with ir_free_program().
+ */
+IRProgram *generateProgram(CompilerContext *ctx, BinaryTreeNode *root, OptimizerStats *stats,
+                           const Profile *executionProfile, bool instrumented);
+
+/**
+ * @brief Generates IFJcode24 code for the whole program without optimising it.
+ *
+ * @param ctx Context of the compilation.
+ * @param root Root of the abstract syntax tree.
+ * @return The generated program, to be finished by finishProgram() and freed with ir_free_program().
+ */
+IRProgram *generateUnoptimisedProgram(CompilerContext *ctx, BinaryTreeNode *root);
+
+/**
+ * @brief Frees the unfinished program and the tables the generator keeps in the context.
+ *
+ * @param ctx Context of the compilation.
+ */
+void freeGeneratorState(CompilerContext *ctx);
+
+/**
+ * @brief Declares the scratch registers, optimises the program and annotates its frames.
+ *
+ * @param target Program from generateUnoptimisedProgram().
+ * @param stats Optimisation counters to fill (may be NULL).
+ * @param executionProfile Profile recorded by --profile-generate (may be NULL).
+ */
+void finishProgram(IRProgram *target, OptimizerStats *stats, const Profile *executionProfile);
+
 /**
  * @brief Generates the header for the IFJcode24 output.
  */
@@ -52,11 +103,12 @@ void generateGlobalConstDecl(BinaryTreeNode *node);
 void generateLocalConstDecl(BinaryTreeNode *node);
 
 /**
- * @brief Generates built-in functions for the given node.
+ * @brief Generates an inlined call of a built-in function.
  * 
- * @param node Pointer to the binary tree node representing the function.
+ * @param node Pointer to the "ifj" node of the call.
+ * @param dst Operand receiving the result (NULL when unused).
  */
-void generateBuildInFuncions(BinaryTreeNode *node);
+void generateBuildInFuncions(BinaryTreeNode *node, const char *dst);
 
 /**
  * @brief Generates an if statement.
@@ -90,16 +142,26 @@ void generateFunctionEnd(BinaryTreeNode *node);
  * @brief Generates an expression.
  * 
  * @param node Pointer to the binary tree node representing the expression.
- * @return The name of the variable storing the result of the expression.
+ * @return Newly allocated operand holding the result of the expression, freed by the caller.
+ */
+char *generateExpression(BinaryTreeNode *node);
+
+/**
+ * @brief Generates an expression into the given program (used by the microbenchmarks).
+ *
+ * @param target Program receiving the instructions.
+ * @param node Pointer to the binary tree node representing the expression.
+ * @return Newly allocated operand holding the result of the expression, freed by the caller.
  */
-const char* generateExpression(BinaryTreeNode *node);
+char *generateExpressionInto(IRProgram *target, BinaryTreeNode *node);
 
 /**
  * @brief Generates a function call.
  * 
- * @param node Pointer to the binary tree node representing the function call.
+ * @param node Pointer to the function name node of the call.
+ * @param dst Operand receiving the returned value (NULL when unused).
  */
-void generateFunctionCall(BinaryTreeNode *node);
+void generateFunctionCall(BinaryTreeNode *node, const char *dst);
 
 /**
  * @brief Generates the body of a function or statement block.
@@ -111,8 +173,9 @@ void generateBody(BinaryTreeNode *node);
 /**
  * @brief Processes the token type of a given binary tree node.
  * 
+ * @param ctx Context of the compilation.
  * @param node Pointer to the binary tree node to be processed.
  */
-void processTokenType(BinaryTreeNode *node);
+void processTokenType(CompilerContext *ctx, BinaryTreeNode *node);
 
 #endif
@@ -8,6 +8,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include "ast.h"
+#include "literal_pool.h"
+#include "intern.h"
+#include "time_report.h"
 
 // Copies a string to a newly allocated memory.
 char *copy_str(const char *str)
@@ -18,7 +21,7 @@ char *copy_str(const char *str)
     char *copy = malloc(strlen(str) + 1);
     if (!copy)
     {
-        fprintf(stderr, "Error: Memory allocation failed for string copy.\n");
+        fprintf(compiler_diagnostics(), "Error: Memory allocation failed for string copy.\n");
         exit(1);
     }
     strcpy(copy, str);
@@ -31,29 +34,90 @@ BinaryTreeNode *createBinaryNode(NodeType type, Token_type tokenType, const char
     BinaryTreeNode *node = malloc(sizeof(BinaryTreeNode));
     if (!node)
     {
-        fprintf(stderr, "Error: Memory allocation failed for BinaryTreeNode.\n");
+        fprintf(compiler_diagnostics(), "Error: Memory allocation failed for BinaryTreeNode.\n");
         exit(1);
     }
     node->type = type;
     node->tokenType = tokenType;
     node->strValue = copy_str(value); // Store string value
+    node->slot = -1;                  // Assigned by semantic analysis
+    node->literal = literal_pool_find(tokenType, value);
+    node->builtin = NULL;             // Resolved by semantic analysis
+    time_report_count(COUNTER_AST_NODES, 1);
+    node->value.kind = VALUE_NONE;
+    if (node->literal >= 0 && tokenType == TOKEN_INT_LITERAL)
+    {
+        node->value.kind = VALUE_INT;
+        node->value.intValue = literal_pool_int(node->literal);
+    }
+    else if (node->literal >= 0 && tokenType == TOKEN_FLOAT_LITERAL)
+    {
+        node->value.kind = VALUE_FLOAT;
+        node->value.floatValue = literal_pool_float(node->literal);
+    }
+    else if (tokenType == TOKEN_IDENTIFIER && value)
+    {
+        node->value.kind = VALUE_IDENTIFIER;
+        node->value.identifier = intern(value);
+    }
+    else if (tokenType == TOKEN_KEYWORD && value)
+    {
+        node->value.kind = VALUE_KEYWORD;
+        node->value.keyword = keyword_lookup(value);
+    }
     node->left = NULL;
     node->right = NULL;
     node->parent = NULL;
     return node;
 }
 
+// Returns the keyword of the node, KEYWORD_NONE when the node is not a keyword.
+Keyword node_keyword(const BinaryTreeNode *node)
+{
+    return node && node->value.kind == VALUE_KEYWORD ? node->value.keyword : KEYWORD_NONE;
+}
+
+// Returns the type named by a type keyword node ("i32", "?[]u8", "void"), TYPE_UNKNOWN for other nodes.
+DataType node_data_type(const BinaryTreeNode *node)
+{
+    switch (node_keyword(node))
+    {
+    case KEYWORD_I32:
+        return TYPE_INT;
+    case KEYWORD_I32_NULL:
+        return TYPE_INT_NULL;
+    case KEYWORD_F64:
+        return TYPE_FLOAT;
+    case KEYWORD_F64_NULL:
+        return TYPE_FLOAT_NULL;
+    case KEYWORD_U8_ARRAY:
+        return TYPE_U8_ARRAY;
+    case KEYWORD_U8_ARRAY_NULL:
+        return TYPE_STRING_NULL;
+    case KEYWORD_VOID:
+        return TYPE_VOID;
+    default:
+        return TYPE_UNKNOWN;
+    }
+}
+
+// Returns the interned name of the node (interned on demand for nodes that are not identifiers).
+const char *node_identifier(const BinaryTreeNode *node)
+{
+    return node->value.kind == VALUE_IDENTIFIER ? node->value.identifier : intern(node->strValue);
+}
+
 // Inserts a left child node for the given parent if no left child exists.
 void insertLeft(BinaryTreeNode *parent, NodeType type, Token_type tokenType, const char *value)
 {
     if (!parent)
     {
-        fprintf(stderr, "Error: Parent node is NULL.\n");
+        fprintf(compiler_diagnostics(), "Error: Parent node is NULL.\n");
         return;
     }
     if (parent->left)
     {
-        fprintf(stderr, "Error: Left child already exists.\n");
+        fprintf(compiler_diagnostics(), "Error: Left child already exists.\n");
         return;
     }
     BinaryTreeNode *child = createBinaryNode(type, tokenType, value);
@@ -81,12 +145,12 @@ void insertRight(BinaryTreeNode *parent, NodeType type, Token_type tokenType, co
 {
     if (!parent)
     {
-        fprintf(stderr, "Error: Parent node is NULL.\n");
+        fprintf(compiler_diagnostics(), "Error: Parent node is NULL.\n");
         return;
     }
     if (parent->right)
     {
-        fprintf(stderr, "Error: Right child already exists.\n");
+        fprintf(compiler_diagnostics(), "Error: Right child already exists.\n");
         return;
     }
     BinaryTreeNode *child = createBinaryNode(type, tokenType, value);
@@ -109,20 +173,18 @@ void insertRightMoveLeft(BinaryTreeNode *parent, NodeType type, Token_type token
     moveDownLeft();
 }
 
-// Global variables for tracking current and in-order traversal nodes.
-BinaryTreeNode *currentNode = NULL;
-BinaryTreeNode *curInOrderNode = NULL;
+// The current and in-order traversal nodes are kept in the compiler context.
 
 // Set the current node to the root.
 void setStartNode(BinaryTreeNode *root)
 {
-    currentNode = root;
+    compilerContext->currentNode = root;
 }
 
 // Set the in-order node to the root.
 void setStartNodeInOrder(BinaryTreeNode *root)
 {
-    curInOrderNode = root;
+    compilerContext->curInOrderNode = root;
 }
 
 // Perform in-order traversal and push nodes to the stack.
@@ -147,32 +209,32 @@ bool moveUp(int levels)
     int movedLevels = 0;
     while (levels > 0)
     {
-        if (currentNode && currentNode->parent)
+        if (compilerContext->currentNode && compilerContext->currentNode->parent)
         {
-            currentNode = currentNode->parent;
+            compilerContext->currentNode = compilerContext->currentNode->parent;
             movedLevels++;
             levels--;
         }
         else
         {
-            printf("Error: Cannot move up %d levels. Moved up %d level(s). Actual node: %s\n", levels + movedLevels, movedLevels, currentNode->strValue);
+            fprintf(compiler_diagnostics(), "Error: Cannot move up %d levels. Moved up %d level(s). Actual node: %s\n", levels + movedLevels, movedLevels, compilerContext->currentNode->strValue);
             handle_error(ERR_COMPILER_INTERNAL);
         }
     }
     // Return whether the current node is a right child
-    return currentNode->isRight;
+    return compilerContext->currentNode->isRight;
 }
 
 // Move to the left child of the current node.
 void moveDownLeft()
 {
-    if (currentNode && currentNode->left)
+    if (compilerContext->currentNode && compilerContext->currentNode->left)
     {
-        currentNode = currentNode->left;
+        compilerContext->currentNode = compilerContext->currentNode->left;
     }
     else
     {
-        printf("Error: Cannot move left from the current node.\n");
+        fprintf(compiler_diagnostics(), "Error: Cannot move left from the current node.\n");
         handle_error(ERR_COMPILER_INTERNAL);
     }
 }
@@ -180,13 +242,13 @@ void moveDownLeft()
 // Move to the right child of the current node.
 void moveDownRight()
 {
-    if (currentNode && currentNode->right)
+    if (compilerContext->currentNode && compilerContext->currentNode->right)
     {
-        currentNode = currentNode->right;
+        compilerContext->currentNode = compilerContext->currentNode->right;
     }
     else
     {
-        printf("Error: Cannot move right from the current node. (%s)\n", currentNode->strValue);
+        fprintf(compiler_diagnostics(), "Error: Cannot move right from the current node. (%s)\n", compilerContext->currentNode->strValue);
         handle_error(ERR_COMPILER_INTERNAL);
     }
 }
@@ -229,6 +291,9 @@ void freeBinaryTree(BinaryTreeNode *root)
         free(root->strValue); // Free string value
     }
     free(root); // Free the node itself
+    // Error paths free the tree before handle_error(), compile_to_stream() must not free it again
+    if (compilerContext && compilerContext->root == root)
+        compilerContext->root = NULL;
 }
 
 // Free the entire tree starting from the root node, traversing up to find the root.
@@ -388,6 +453,8 @@ const char *value_type_to_string(DataType type)
         return "void";
     case TYPE_U8_ARRAY:
         return "[]u8";
+    case TYPE_STRING_NULL:
+        return "?[]u8";
     case TYPE_EMPTY:
         return "empty";
     case TYPE_NULL:
@@ -418,6 +485,8 @@ DataType value_string_to_type(const char *typeStr)
         return TYPE_STRING;
     if (strcmp(typeStr, "[]u8") == 0)
         return TYPE_U8_ARRAY;
+    if (strcmp(typeStr, "?[]u8") == 0)
+        return TYPE_STRING_NULL;
     if (strcmp(typeStr, "void") == 0)
         return TYPE_VOID;
     if (strcmp(typeStr, "nonNull") == 0)
@@ -480,5 +549,11 @@ bool are_types_compatible(DataType actual, DataType expected)
         return true;
     if (expected == TYPE_FLOAT_NULL && (actual == TYPE_INT || actual == TYPE_FLOAT || actual == TYPE_INT_NULL || actual == TYPE_NULL))
         return true;
+    // String literals are typed TYPE_STRING, declared strings TYPE_U8_ARRAY
+    if ((expected == TYPE_U8_ARRAY || expected == TYPE_STRING) &&
+        (actual == TYPE_U8_ARRAY || actual == TYPE_STRING || actual == TYPE_STRING_NULL))
+        return true;
+    if (expected == TYPE_STRING_NULL && (actual == TYPE_U8_ARRAY || actual == TYPE_STRING || actual == TYPE_NULL))
+        return true;
     return false;
 }
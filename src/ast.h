@@ -11,6 +11,7 @@
 #include <stdbool.h>
 #include "lexical_analyser.h"
 #include "stack.h"
+#include "context.h"
 
 /**
  * @brief Enumeration of different node types in the AST.
@@ -64,9 +65,40 @@ typedef enum
     TYPE_U8_ARRAY     // 8-bit unsigned integer array (for testing)
 } DataType;
 
+/**
+ * @brief Kinds of the typed value of a node.
+ */
+typedef enum
+{
+    VALUE_NONE,       // Punctuation, operators and other nodes without a value
+    VALUE_INT,        // Integer literal
+    VALUE_FLOAT,      // Float literal
+    VALUE_IDENTIFIER, // Identifier
+    VALUE_KEYWORD     // Keyword
+} NodeValueKind;
+
+/**
+ * @brief Typed value of a node, decoded once when the node is created.
+ */
+typedef struct
+{
+    NodeValueKind kind;
+    union
+    {
+        long long intValue;     // VALUE_INT
+        double floatValue;      // VALUE_FLOAT
+        const char *identifier; // VALUE_IDENTIFIER, interned (equal names have equal pointers)
+        Keyword keyword;        // VALUE_KEYWORD
+    };
+} NodeValue;
+
 /**
  * @brief Structure representing a binary tree node.
  * Each node contains a type, a token type, a string value, child nodes, and a parent node.
+ * Semantic analysis stores the frame slot of variables and expression temporaries in @c slot.
+ * Literals refer to their entry in the literal pool (see literal_pool.h), @c value holds the
+ * decoded literal, interned identifier or keyword, so the analyses need no string comparison.
+ * The call node of a built-in function keeps its descriptor in @c builtin (see builtins.h).
  */
 typedef struct BinaryTreeNode
 {
@@ -74,17 +106,22 @@ typedef struct BinaryTreeNode
     Token_type tokenType; // Token type from the lexer
     char *strValue;       // String representation of the value
     bool isRight;         // Boolean flag for right child node
+    int slot;             // Frame slot of a variable or temporary (-1 when not assigned)
+    int literal;          // Entry of a literal in the literal pool (-1 otherwise)
+    NodeValue value;      // Typed value of the node
+    const struct BuiltinDescriptor *builtin; // Descriptor of a built-in call ("ifj" node), set by semantic analysis
     struct BinaryTreeNode *left;
     struct BinaryTreeNode *right;
     struct BinaryTreeNode *parent;
 } BinaryTreeNode;
 
-// External variables for the current and in-order nodes
-extern BinaryTreeNode *currentNode;
-extern BinaryTreeNode *curInOrderNode;
+// The current and in-order nodes are compilerContext->currentNode and compilerContext->curInOrderNode
 
 // Function declarations for binary tree manipulation
 BinaryTreeNode *createBinaryNode(NodeType type, Token_type tokenType, const char *value);
+Keyword node_keyword(const BinaryTreeNode *node);
+DataType node_data_type(const BinaryTreeNode *node);
+const char *node_identifier(const BinaryTreeNode *node);
 void insertLeft(BinaryTreeNode *parent, NodeType type, Token_type tokenType, const char *value);
 void insertLeftMoveLeft(BinaryTreeNode *parent, NodeType type, Token_type tokenType, const char *value);
 void insertLeftMoveRight(BinaryTreeNode *parent, NodeType type, Token_type tokenType, const char *value);
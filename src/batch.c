@@ -0,0 +1,341 @@
+/**
+ * @file batch.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief Compilation of many programs on a pool of threads (main -j N).
+ *
+ * @details Every program is compiled by ifj_compile() with its own context, the output of
+ * dir/name.ext goes to dir/name.ifjcode (written to a temporary file and renamed, so a failed or
+ * interrupted run never leaves half a program). Failed programs get no output. With a cache
+ * (--cache), unchanged programs are taken from it (cache.c).
+ *
+ * The pool is work stealing: the files are dealt round-robin to one queue per worker, a worker
+ * takes from the back of its own queue and, once it is empty, steals from the front of the
+ * others. A worker that drew long programs is relieved by the others instead of holding up the
+ * end of the batch. Each queue has its own lock, taken once per program; compilation takes far
+ * longer, so the locks are never contended for long.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "cache.h"
+#include "compiler.h"
+#include "error.h"
+
+#define BATCH_OUTPUT_EXTENSION ".ifjcode"
+#define BATCH_DEFAULT_STACK (64 * 1024 * 1024)
+
+/**
+ * @brief Queue of the files of one worker, tasks[head .. tail - 1] are left.
+ */
+typedef struct
+{
+    pthread_mutex_t lock;
+    int *tasks;
+    int head;
+    int tail;
+} WorkQueue;
+
+/**
+ * @brief Outcome of one file.
+ */
+typedef struct
+{
+    int exitCode;
+    double milliseconds;
+    char *message; // First line of the error messages (NULL on success)
+    bool cached;   // Taken from the cache
+} BatchResult;
+
+typedef struct
+{
+    char *const *files;
+    const CompileCache *cache; // NULL without --cache
+    BatchResult *results;
+    WorkQueue *queues;
+    int workers;
+} Batch;
+
+typedef struct
+{
+    Batch *batch;
+    int id;
+} Worker;
+
+static double now_milliseconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+// Next file of the worker: the back of its own queue, then the front of the others
+static int next_task(Batch *batch, int id)
+{
+    for (int i = 0; i < batch->workers; i++)
+    {
+        WorkQueue *queue = &batch->queues[(id + i) % batch->workers];
+        int task = -1;
+        pthread_mutex_lock(&queue->lock);
+        if (queue->head < queue->tail)
+            task = i == 0 ? queue->tasks[--queue->tail] : queue->tasks[queue->head++];
+        pthread_mutex_unlock(&queue->lock);
+        if (task >= 0)
+            return task;
+    }
+    return -1;
+}
+
+/**
+ * @brief Name of the output of a source file, its extension replaced by .ifjcode.
+ */
+static char *output_path(const char *source)
+{
+    const char *slash = strrchr(source, '/');
+    const char *dot = strrchr(source, '.');
+    size_t stem = dot && (!slash || dot > slash + 1) ? (size_t)(dot - source) : strlen(source);
+
+    char *path = malloc(stem + sizeof(BATCH_OUTPUT_EXTENSION));
+    if (!path)
+        handle_error(ERR_COMPILER_INTERNAL);
+    memcpy(path, source, stem);
+    strcpy(path + stem, BATCH_OUTPUT_EXTENSION);
+    return path;
+}
+
+// Writes the program next to the source, through a temporary file renamed at the end
+static bool write_output(const char *source, const char *program, size_t length)
+{
+    char *path = output_path(source);
+    char *temporary = malloc(strlen(path) + sizeof(".tmp"));
+    if (!temporary)
+        handle_error(ERR_COMPILER_INTERNAL);
+    sprintf(temporary, "%s.tmp", path);
+
+    FILE *out = fopen(temporary, "w");
+    bool written = out && fwrite(program, 1, length, out) == length;
+    if (out && fclose(out) != 0)
+        written = false;
+    if (written)
+        written = rename(temporary, path) == 0;
+    if (!written)
+        remove(temporary);
+    free(temporary);
+    free(path);
+    return written;
+}
+
+// The first line of the error messages, the summary has one line per file
+static char *first_line(const char *text, size_t length)
+{
+    size_t end = 0;
+    while (end < length && text[end] != '\n')
+        end++;
+    char *line = malloc(end + 1);
+    if (!line)
+        handle_error(ERR_COMPILER_INTERNAL);
+    memcpy(line, text, end);
+    line[end] = '\0';
+    return line;
+}
+
+static void compile_file(const char *file, const CompileCache *cache, BatchResult *result)
+{
+    double start = now_milliseconds();
+    char *program = NULL, *errors = NULL;
+    size_t programLength = 0, errorsLength = 0;
+    FILE *out = open_memstream(&program, &programLength);
+    FILE *diagnostics = open_memstream(&errors, &errorsLength);
+    FILE *source = fopen(file, "r");
+
+    if (!out || !diagnostics)
+        handle_error(ERR_COMPILER_INTERNAL);
+    if (!source)
+    {
+        fprintf(diagnostics, "Cannot open file %s\n", file);
+        result->exitCode = ERR_COMPILER_INTERNAL;
+    }
+    else
+    {
+        CompilerContext context = {.diagnostics = diagnostics};
+        if (cache)
+        {
+            size_t length;
+            char *text = compiler_read_source(source, &length);
+            result->exitCode = text ? cache_compile(cache, &context, text, length, out, &result->cached)
+                                    : ERR_COMPILER_INTERNAL;
+            free(text);
+        }
+        else
+            result->exitCode = compile_to_stream(&context, source, out);
+        fclose(source);
+    }
+    fclose(out);
+    fclose(diagnostics);
+
+    if (result->exitCode == EXIT_SUCCESS && !write_output(file, program, programLength))
+    {
+        result->exitCode = ERR_COMPILER_INTERNAL;
+        const char *message = "Cannot write the output";
+        result->message = first_line(message, strlen(message));
+    }
+    else if (result->exitCode != EXIT_SUCCESS)
+        result->message = first_line(errors, errorsLength);
+    result->milliseconds = now_milliseconds() - start;
+    free(program);
+    free(errors);
+}
+
+static void *worker_main(void *argument)
+{
+    Worker *worker = argument;
+    Batch *batch = worker->batch;
+    int task;
+    while ((task = next_task(batch, worker->id)) >= 0)
+        compile_file(batch->files[task], batch->cache, &batch->results[task]);
+    return NULL;
+}
+
+// The parser recurses on nested statements, workers get the stack the main thread has
+static size_t worker_stack_size()
+{
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY &&
+        limit.rlim_cur > BATCH_DEFAULT_STACK)
+        return (size_t)limit.rlim_cur;
+    return BATCH_DEFAULT_STACK;
+}
+
+/**
+ * @brief Compiles the files on a pool of threads and prints a summary line for each of them.
+ *
+ * @param files Source files.
+ * @param count Number of files.
+ * @param threads Number of worker threads, 0 for one per online CPU.
+ * @param cache Cache of the results (may be NULL).
+ * @param summary Stream receiving the summary.
+ * @return 0 when every file compiled, otherwise the exit code of the first failed file.
+ */
+int batch_compile(char *const *files, int count, int threads, const CompileCache *cache, FILE *summary)
+{
+    if (threads <= 0)
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > count)
+        threads = count;
+    if (threads < 1)
+        threads = 1;
+
+    Batch batch = {files, cache, calloc((size_t)count, sizeof(BatchResult)),
+                   calloc((size_t)threads, sizeof(WorkQueue)), threads};
+    Worker *workers = malloc((size_t)threads * sizeof(Worker));
+    pthread_t *handles = malloc((size_t)threads * sizeof(pthread_t));
+    if (!batch.results || !batch.queues || !workers || !handles)
+        handle_error(ERR_COMPILER_INTERNAL);
+
+    // Round-robin, every queue is filled back to front so its owner starts with its first file
+    for (int i = 0; i < threads; i++)
+    {
+        WorkQueue *queue = &batch.queues[i];
+        pthread_mutex_init(&queue->lock, NULL);
+        queue->tasks = malloc(((size_t)count / (size_t)threads + 1) * sizeof(int));
+        if (!queue->tasks)
+            handle_error(ERR_COMPILER_INTERNAL);
+        for (int task = i + (count - 1 - i) / threads * threads; task >= i; task -= threads)
+            queue->tasks[queue->tail++] = task;
+    }
+
+    double start = now_milliseconds();
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, worker_stack_size());
+    for (int i = 0; i < threads; i++)
+    {
+        workers[i] = (Worker){&batch, i};
+        if (pthread_create(&handles[i], &attributes, worker_main, &workers[i]) != 0)
+            handle_error(ERR_COMPILER_INTERNAL);
+    }
+    for (int i = 0; i < threads; i++)
+        pthread_join(handles[i], NULL);
+    pthread_attr_destroy(&attributes);
+    double elapsed = now_milliseconds() - start;
+
+    int exitCode = EXIT_SUCCESS;
+    int failed = 0, cached = 0;
+    for (int i = 0; i < count; i++)
+    {
+        BatchResult *result = &batch.results[i];
+        cached += result->cached;
+        if (result->exitCode == EXIT_SUCCESS)
+            fprintf(summary, "%-6s %2d %9.2f ms  %s\n", result->cached ? "cached" : "ok", result->exitCode,
+                    result->milliseconds, files[i]);
+        else
+        {
+            fprintf(summary, "FAILED %2d %9.2f ms  %s: %s\n", result->exitCode, result->milliseconds, files[i],
+                    result->message);
+            if (failed++ == 0)
+                exitCode = result->exitCode;
+        }
+        free(result->message);
+    }
+    fprintf(summary, "%d files, %d compiled, %d failed, %d from the cache in %.2f s on %d threads\n", count,
+            count - failed, failed, cached, elapsed / 1e3, threads);
+
+    for (int i = 0; i < threads; i++)
+    {
+        pthread_mutex_destroy(&batch.queues[i].lock);
+        free(batch.queues[i].tasks);
+    }
+    free(batch.queues);
+    free(batch.results);
+    free(workers);
+    free(handles);
+    return exitCode;
+}
+
+/**
+ * @brief Reads a manifest: one source file per line, empty lines and lines starting with # are skipped.
+ *
+ * @param path File name of the manifest.
+ * @param count Receives the number of files.
+ * @return Array of the file names, NULL when the manifest cannot be read.
+ */
+char **batch_read_manifest(const char *path, int *count)
+{
+    FILE *manifest = fopen(path, "r");
+    if (!manifest)
+        return NULL;
+
+    int capacity = 64;
+    char **files = malloc((size_t)capacity * sizeof(char *));
+    char *line = NULL;
+    size_t lineCapacity = 0;
+    ssize_t length;
+    *count = 0;
+    while ((length = getline(&line, &lineCapacity, manifest)) >= 0)
+    {
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+            line[--length] = '\0';
+        if (length == 0 || line[0] == '#')
+            continue;
+        if (!files)
+            handle_error(ERR_COMPILER_INTERNAL);
+        if (*count == capacity)
+        {
+            capacity *= 2;
+            files = realloc(files, (size_t)capacity * sizeof(char *));
+            if (!files)
+                handle_error(ERR_COMPILER_INTERNAL);
+        }
+        files[(*count)++] = strdup(line);
+    }
+    free(line);
+    fclose(manifest);
+    return files;
+}
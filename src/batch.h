@@ -0,0 +1,17 @@
+/**
+ * @file batch.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief Compilation of many programs on a pool of threads (main -j N).
+ */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+
+#include "cache.h"
+
+char **batch_read_manifest(const char *path, int *count);
+int batch_compile(char *const *files, int count, int threads, const CompileCache *cache, FILE *summary);
+
+#endif
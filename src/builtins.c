@@ -0,0 +1,207 @@
+/**
+ * @file builtins.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Code generator
+ * @brief Descriptor table of the IFJ24 built-in functions (ifj.*).
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "builtins.h"
+#include "intern.h"
+
+// Helper variables of the inlined functions are scratch registers, free again after the call
+static void builtin_release(IRProgram *program, char *const *temps, int count)
+{
+    for (int i = 0; i < count; i++)
+        ir_scratch_release(program, temps[i]);
+}
+
+static void emit_readstr(IRProgram *program, const char *dst, const char *const *args)
+{
+    (void)args;
+    ir_append(program, IR_READ, dst, "string", NULL);
+}
+
+static void emit_readi32(IRProgram *program, const char *dst, const char *const *args)
+{
+    (void)args;
+    ir_append(program, IR_READ, dst, "int", NULL);
+}
+
+static void emit_readf64(IRProgram *program, const char *dst, const char *const *args)
+{
+    (void)args;
+    ir_append(program, IR_READ, dst, "float", NULL);
+}
+
+static void emit_write(IRProgram *program, const char *dst, const char *const *args)
+{
+    (void)dst;
+    ir_append(program, IR_WRITE, args[0], NULL, NULL);
+}
+
+static void emit_i2f(IRProgram *program, const char *dst, const char *const *args)
+{
+    ir_append(program, IR_INT2FLOAT, dst, args[0], NULL);
+}
+
+static void emit_f2i(IRProgram *program, const char *dst, const char *const *args)
+{
+    ir_append(program, IR_FLOAT2INT, dst, args[0], NULL);
+}
+
+static void emit_string(IRProgram *program, const char *dst, const char *const *args)
+{
+    ir_append(program, IR_MOVE, dst, args[0], NULL);
+}
+
+static void emit_length(IRProgram *program, const char *dst, const char *const *args)
+{
+    ir_append(program, IR_STRLEN, dst, args[0], NULL);
+}
+
+static void emit_concat(IRProgram *program, const char *dst, const char *const *args)
+{
+    ir_append(program, IR_CONCAT, dst, args[0], args[1]);
+}
+
+static void emit_chr(IRProgram *program, const char *dst, const char *const *args)
+{
+    ir_append(program, IR_INT2CHAR, dst, args[0], NULL);
+}
+
+/**
+ * @brief ifj.ord(s, i): code of the i-th character, 0 when i is out of range.
+ */
+static void emit_ord(IRProgram *program, const char *dst, const char *const *args)
+{
+    int id = compilerContext->builtinCounter++;
+    char result[32], length[32], cond[32], end[300];
+    ir_scratch_acquire(program, result, sizeof(result));
+    ir_scratch_acquire(program, length, sizeof(length));
+    ir_scratch_acquire(program, cond, sizeof(cond));
+    compiler_label(end, sizeof(end), "ord_end", id);
+
+    ir_append(program, IR_MOVE, result, "int@0", NULL);
+    ir_append(program, IR_STRLEN, length, args[0], NULL);
+    ir_append(program, IR_LT, cond, args[1], "int@0");
+    ir_append(program, IR_JUMPIFEQ, end, cond, "bool@true");
+    ir_append(program, IR_LT, cond, args[1], length);
+    ir_append(program, IR_JUMPIFNEQ, end, cond, "bool@true");
+    ir_append(program, IR_STRI2INT, result, args[0], args[1]);
+    ir_append(program, IR_LABEL, end, NULL, NULL);
+    ir_append(program, IR_MOVE, dst, result, NULL);
+    builtin_release(program, (char *const[]){result, length, cond}, 3);
+}
+
+/**
+ * @brief ifj.strcmp(a, b): -1, 0 or 1 by lexicographic order.
+ */
+static void emit_strcmp(IRProgram *program, const char *dst, const char *const *args)
+{
+    int id = compilerContext->builtinCounter++;
+    char result[32], cond[32], end[300];
+    ir_scratch_acquire(program, result, sizeof(result));
+    ir_scratch_acquire(program, cond, sizeof(cond));
+    compiler_label(end, sizeof(end), "cmp_end", id);
+
+    ir_append(program, IR_MOVE, result, "int@0", NULL);
+    ir_append(program, IR_EQ, cond, args[0], args[1]);
+    ir_append(program, IR_JUMPIFEQ, end, cond, "bool@true");
+    ir_append(program, IR_MOVE, result, "int@1", NULL);
+    ir_append(program, IR_GT, cond, args[0], args[1]);
+    ir_append(program, IR_JUMPIFEQ, end, cond, "bool@true");
+    ir_append(program, IR_MOVE, result, "int@-1", NULL);
+    ir_append(program, IR_LABEL, end, NULL, NULL);
+    ir_append(program, IR_MOVE, dst, result, NULL);
+    builtin_release(program, (char *const[]){result, cond}, 2);
+}
+
+/**
+ * @brief ifj.substring(s, i, j): characters i..j-1, null for invalid bounds.
+ */
+static void emit_substring(IRProgram *program, const char *dst, const char *const *args)
+{
+    int id = compilerContext->builtinCounter++;
+    char result[32], length[32], cond[32], index[32], character[32], loop[300], end[300];
+    ir_scratch_acquire(program, result, sizeof(result));
+    ir_scratch_acquire(program, length, sizeof(length));
+    ir_scratch_acquire(program, cond, sizeof(cond));
+    ir_scratch_acquire(program, index, sizeof(index));
+    ir_scratch_acquire(program, character, sizeof(character));
+    compiler_label(loop, sizeof(loop), "sub_loop", id);
+    compiler_label(end, sizeof(end), "sub_end", id);
+
+    ir_append(program, IR_MOVE, result, "nil@nil", NULL);
+    ir_append(program, IR_STRLEN, length, args[0], NULL);
+    ir_append(program, IR_LT, cond, args[1], "int@0");
+    ir_append(program, IR_JUMPIFEQ, end, cond, "bool@true");
+    ir_append(program, IR_LT, cond, args[2], "int@0");
+    ir_append(program, IR_JUMPIFEQ, end, cond, "bool@true");
+    ir_append(program, IR_GT, cond, args[1], args[2]);
+    ir_append(program, IR_JUMPIFEQ, end, cond, "bool@true");
+    ir_append(program, IR_LT, cond, args[1], length);
+    ir_append(program, IR_JUMPIFNEQ, end, cond, "bool@true");
+    ir_append(program, IR_GT, cond, args[2], length);
+    ir_append(program, IR_JUMPIFEQ, end, cond, "bool@true");
+
+    ir_append(program, IR_MOVE, result, "string@", NULL);
+    ir_append(program, IR_MOVE, index, args[1], NULL);
+    ir_append(program, IR_LABEL, loop, NULL, NULL);
+    ir_append(program, IR_JUMPIFEQ, end, index, args[2]);
+    ir_append(program, IR_GETCHAR, character, args[0], index);
+    ir_append(program, IR_CONCAT, result, result, character);
+    ir_append(program, IR_ADD, index, index, "int@1");
+    ir_append(program, IR_JUMP, loop, NULL, NULL);
+    ir_append(program, IR_LABEL, end, NULL, NULL);
+    ir_append(program, IR_MOVE, dst, result, NULL);
+    builtin_release(program, (char *const[]){result, length, cond, index, character}, 5);
+}
+
+static const BuiltinDescriptor builtins[] = {
+    {"chr", 1, {TYPE_INT}, TYPE_U8_ARRAY, emit_chr},
+    {"concat", 2, {TYPE_U8_ARRAY, TYPE_U8_ARRAY}, TYPE_U8_ARRAY, emit_concat},
+    {"f2i", 1, {TYPE_FLOAT}, TYPE_INT, emit_f2i},
+    {"i2f", 1, {TYPE_INT}, TYPE_FLOAT, emit_i2f},
+    {"length", 1, {TYPE_U8_ARRAY}, TYPE_INT, emit_length},
+    {"ord", 2, {TYPE_U8_ARRAY, TYPE_INT}, TYPE_INT, emit_ord},
+    {"readf64", 0, {TYPE_EMPTY}, TYPE_FLOAT_NULL, emit_readf64},
+    {"readi32", 0, {TYPE_EMPTY}, TYPE_INT_NULL, emit_readi32},
+    {"readstr", 0, {TYPE_EMPTY}, TYPE_STRING_NULL, emit_readstr},
+    {"strcmp", 2, {TYPE_U8_ARRAY, TYPE_U8_ARRAY}, TYPE_INT, emit_strcmp},
+    {"string", 1, {TYPE_U8_ARRAY}, TYPE_U8_ARRAY, emit_string},
+    {"substring", 3, {TYPE_U8_ARRAY, TYPE_INT, TYPE_INT}, TYPE_STRING_NULL, emit_substring},
+    {"write", 1, {TYPE_UNKNOWN}, TYPE_VOID, emit_write},
+};
+
+#define BUILTIN_COUNT ((int)(sizeof(builtins) / sizeof(builtins[0])))
+
+// Interned names of builtins[], valid while the intern table keeps the generation
+static _Thread_local const char *internedNames[BUILTIN_COUNT];
+static _Thread_local unsigned long internedGeneration = 0;
+
+/**
+ * @brief Finds the descriptor of a built-in function.
+ *
+ * @details The names of the table are interned once per generation of the intern table, a lookup
+ * then compares pointers only.
+ *
+ * @param name Interned function name without the "ifj." prefix (see node_identifier()).
+ * @return Descriptor or NULL when no such built-in function exists.
+ */
+const BuiltinDescriptor *builtin_lookup(const char *name)
+{
+    if (internedGeneration != intern_generation())
+    {
+        for (int i = 0; i < BUILTIN_COUNT; i++)
+            internedNames[i] = intern(builtins[i].name);
+        internedGeneration = intern_generation();
+    }
+    for (int i = 0; i < BUILTIN_COUNT; i++)
+    {
+        if (internedNames[i] == name)
+            return &builtins[i];
+    }
+    return NULL;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file builtins.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Code generator
+ * @brief Descriptor table of the IFJ24 built-in functions (ifj.*).
+ *
+ * @details One table describes every built-in function: its arity, parameter types, return type
+ * and the callback that lowers a call into IFJcode24 instructions. Semantic analysis looks the
+ * descriptor up once by the interned name, checks the call against it and leaves it on the call
+ * node (BinaryTreeNode::builtin); the code generator inlines the call through the callback, so no
+ * CALL is emitted for built-in functions.
+ */
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include "ast.h"
+#include "ir.h"
+
+#define BUILTIN_MAX_PARAMS 3
+
+/**
+ * @brief Lowers one call of a built-in function.
+ *
+ * @param program Program the instructions are appended to.
+ * @param dst Operand receiving the result (NULL for void functions).
+ * @param args Operands of the arguments, BuiltinDescriptor::arity of them.
+ */
+typedef void (*BuiltinEmit)(IRProgram *program, const char *dst, const char *const *args);
+
+/**
+ * @brief Description of one built-in function.
+ */
+typedef struct BuiltinDescriptor
+{
+    const char *name;                     // Name without the "ifj." prefix
+    int arity;                            // Number of parameters
+    DataType params[BUILTIN_MAX_PARAMS];  // Parameter types, TYPE_UNKNOWN accepts any term
+    DataType returnType;                  // Type of the result
+    BuiltinEmit emit;                     // Inline lowering of the call
+} BuiltinDescriptor;
+
+const BuiltinDescriptor *builtin_lookup(const char *name);
+
+#endif
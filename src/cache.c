@@ -0,0 +1,385 @@
+/**
+ * @file cache.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief On-disk cache of compilation results addressed by the hash of the source (main --cache).
+ *
+ * @details The key is the SHA-256 of the cache identity (format version, mode and the size and
+ * modification time of the compiler executable, so a rebuilt compiler never reuses old entries)
+ * followed by the source bytes. An entry stores the exit code, the IFJcode24 program and the error
+ * messages; a hit replays them without lexing the source.
+ *
+ * Layout: directory/ab/cdef... for the key abcdef..., one file per entry:
+ * @code
+ * IFJC1 <exit code> <output length> <error length>\n<output bytes><error bytes>
+ * @endcode
+ * Entries are written to a temporary file in the same subdirectory and renamed, so concurrent
+ * compilers (threads or processes) see either no entry or a complete one. The modification time of
+ * an entry is its last use, a hit touches it. After a store, the least recently used entries of the
+ * whole cache are deleted down to the size bound. A store scans only the subdirectory of its entry
+ * while that stays within its share of the bound (maxBytes / 256), so the cost of a store does not
+ * grow with the cache size until the cache nears its bound.
+ *
+ * The code of single functions (incremental.c) is kept in entries of the same format, under keys
+ * of its own, and shares the size bound with the whole programs.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cache.h"
+#include "compiler.h"
+#include "error.h"
+#include "incremental.h"
+#include "sha256.h"
+
+#define CACHE_FORMAT "IFJC1"
+#define CACHE_SUBDIRECTORIES 256
+#define CACHE_HEADER_MAX 80
+#define CACHE_STALE_TEMPORARY_SECONDS 3600
+
+/**
+ * @brief An entry of a subdirectory, candidate for eviction.
+ */
+typedef struct
+{
+    char *path;
+    long long size;
+    struct timespec lastUse;
+} CacheFile;
+
+/**
+ * @brief Opens the cache directory, creating it when it does not exist.
+ *
+ * @param cache Cache to initialise.
+ * @param directory Directory of the cache, its parent must exist.
+ * @param maxBytes Bound of the total size of the entries.
+ * @return False when the directory cannot be created.
+ */
+bool cache_open(CompileCache *cache, const char *directory, long long maxBytes)
+{
+    if (mkdir(directory, 0777) != 0 && errno != EEXIST)
+        return false;
+    cache->directory = malloc(strlen(directory) + 1);
+    if (!cache->directory)
+        handle_error(ERR_COMPILER_INTERNAL);
+    strcpy(cache->directory, directory);
+    cache->maxBytes = maxBytes;
+
+    // The executable identifies the build; without /proc the build time of this file does
+    struct stat executable;
+    if (stat("/proc/self/exe", &executable) == 0)
+        snprintf(cache->identity, sizeof(cache->identity), "%s default %lld %lld.%09ld", CACHE_FORMAT,
+                 (long long)executable.st_size, (long long)executable.st_mtim.tv_sec, executable.st_mtim.tv_nsec);
+    else
+        snprintf(cache->identity, sizeof(cache->identity), "%s default %s %s", CACHE_FORMAT, __DATE__, __TIME__);
+    return true;
+}
+
+void cache_close(CompileCache *cache)
+{
+    free(cache->directory);
+    cache->directory = NULL;
+}
+
+// Path of the entry of the key (or of its subdirectory with entry false)
+static char *entry_path(const CompileCache *cache, const char *key, bool entry)
+{
+    char *path = malloc(strlen(cache->directory) + SHA256_HEX_SIZE + 2);
+    if (!path)
+        handle_error(ERR_COMPILER_INTERNAL);
+    if (entry)
+        sprintf(path, "%s/%.2s/%s", cache->directory, key, key + 2);
+    else
+        sprintf(path, "%s/%.2s", cache->directory, key);
+    return path;
+}
+
+/**
+ * @brief Reads an entry.
+ *
+ * @return False when there is no complete entry, the buffers are then not allocated.
+ */
+static bool read_entry(const char *path, int *exitCode, char **out, size_t *outLength, char **err,
+                       size_t *errLength)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return false;
+
+    char header[CACHE_HEADER_MAX];
+    bool valid = fgets(header, sizeof(header), file) &&
+                 sscanf(header, CACHE_FORMAT " %d %zu %zu", exitCode, outLength, errLength) == 3;
+    *out = valid ? malloc(*outLength + 1) : NULL;
+    *err = valid ? malloc(*errLength + 1) : NULL;
+    valid = valid && *out && *err && fread(*out, 1, *outLength, file) == *outLength &&
+            fread(*err, 1, *errLength, file) == *errLength && getc(file) == EOF;
+    fclose(file);
+    if (!valid)
+    {
+        free(*out);
+        free(*err);
+    }
+    return valid;
+}
+
+static int compare_last_use(const void *a, const void *b)
+{
+    const struct timespec *x = &((const CacheFile *)a)->lastUse;
+    const struct timespec *y = &((const CacheFile *)b)->lastUse;
+    if (x->tv_sec != y->tv_sec)
+        return x->tv_sec < y->tv_sec ? -1 : 1;
+    return (x->tv_nsec > y->tv_nsec) - (x->tv_nsec < y->tv_nsec);
+}
+
+/**
+ * @brief Appends the entries of a subdirectory to the candidates for eviction.
+ *
+ * @details Temporary files left by a compiler that did not finish are deleted after an hour.
+ *
+ * @return Total size of the appended entries.
+ */
+static long long collect_entries(const char *subdirectory, CacheFile **files, int *count, int *capacity)
+{
+    DIR *dir = opendir(subdirectory);
+    if (!dir)
+        return 0;
+
+    long long total = 0;
+    time_t now = time(NULL);
+    struct dirent *item;
+    while ((item = readdir(dir)) != NULL)
+    {
+        bool temporary = strncmp(item->d_name, ".tmp-", 5) == 0;
+        if (item->d_name[0] == '.' && !temporary)
+            continue;
+        char *path = malloc(strlen(subdirectory) + strlen(item->d_name) + 2);
+        if (!path)
+            handle_error(ERR_COMPILER_INTERNAL);
+        sprintf(path, "%s/%s", subdirectory, item->d_name);
+
+        struct stat info;
+        if (stat(path, &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            free(path);
+            continue;
+        }
+        if (temporary)
+        {
+            if (now - info.st_mtim.tv_sec > CACHE_STALE_TEMPORARY_SECONDS)
+                unlink(path);
+            free(path);
+            continue;
+        }
+        if (*count == *capacity)
+        {
+            *capacity = *capacity ? 2 * *capacity : 64;
+            *files = realloc(*files, (size_t)*capacity * sizeof(CacheFile));
+            if (!*files)
+                handle_error(ERR_COMPILER_INTERNAL);
+        }
+        (*files)[(*count)++] = (CacheFile){path, (long long)info.st_size, info.st_mtim};
+        total += (long long)info.st_size;
+    }
+    closedir(dir);
+    return total;
+}
+
+static void free_entries(CacheFile *files, int count)
+{
+    for (int i = 0; i < count; i++)
+        free(files[i].path);
+    free(files);
+}
+
+/**
+ * @brief Deletes the least recently used entries of the cache while it is above its bound.
+ *
+ * @details While the subdirectory of the stored entry is within its share of the bound, the keys
+ * spread evenly and the cache is taken to be within the bound. Otherwise every subdirectory is
+ * scanned. The entry just stored is never deleted, so a program larger than a share is kept for
+ * the next compilation. Another compiler may delete the same files at the same time, failed
+ * deletions are ignored.
+ *
+ * @param cache Opened cache.
+ * @param subdirectory Subdirectory of the stored entry.
+ * @param stored Path of the stored entry.
+ */
+static void evict(const CompileCache *cache, const char *subdirectory, const char *stored)
+{
+    CacheFile *files = NULL;
+    int count = 0, capacity = 0;
+    long long total = collect_entries(subdirectory, &files, &count, &capacity);
+    free_entries(files, count);
+    if (total <= cache->maxBytes / CACHE_SUBDIRECTORIES)
+        return;
+
+    files = NULL;
+    count = capacity = 0;
+    total = 0;
+    DIR *dir = opendir(cache->directory);
+    if (!dir)
+        return;
+    struct dirent *item;
+    while ((item = readdir(dir)) != NULL)
+    {
+        if (item->d_name[0] == '.')
+            continue;
+        char *path = malloc(strlen(cache->directory) + strlen(item->d_name) + 2);
+        if (!path)
+            handle_error(ERR_COMPILER_INTERNAL);
+        sprintf(path, "%s/%s", cache->directory, item->d_name);
+        total += collect_entries(path, &files, &count, &capacity);
+        free(path);
+    }
+    closedir(dir);
+
+    if (total > cache->maxBytes)
+    {
+        qsort(files, (size_t)count, sizeof(CacheFile), compare_last_use);
+        for (int i = 0; i < count && total > cache->maxBytes; i++)
+        {
+            if (strcmp(files[i].path, stored) == 0)
+                continue;
+            unlink(files[i].path);
+            total -= files[i].size;
+        }
+    }
+    free_entries(files, count);
+}
+
+/**
+ * @brief Stores an entry: a temporary file in the subdirectory, renamed to the entry at the end.
+ */
+static void store_entry(const CompileCache *cache, const char *key, int exitCode, const char *out,
+                        size_t outLength, const char *err, size_t errLength)
+{
+    char *subdirectory = entry_path(cache, key, false);
+    char *path = entry_path(cache, key, true);
+    char *temporary = malloc(strlen(subdirectory) + sizeof("/.tmp-XXXXXX"));
+    if (!temporary)
+        handle_error(ERR_COMPILER_INTERNAL);
+    sprintf(temporary, "%s/.tmp-XXXXXX", subdirectory);
+
+    mkdir(subdirectory, 0777);
+    int fd = mkstemp(temporary);
+    FILE *file = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    bool written = file && fprintf(file, CACHE_FORMAT " %d %zu %zu\n", exitCode, outLength, errLength) > 0 &&
+                   fwrite(out, 1, outLength, file) == outLength && fwrite(err, 1, errLength, file) == errLength;
+    if (file)
+        written = fclose(file) == 0 && written;
+    else if (fd >= 0)
+        close(fd);
+    if (fd >= 0)
+    {
+        // mkstemp creates the file readable only by its owner
+        if (!written || chmod(temporary, 0644) != 0 || rename(temporary, path) != 0)
+            unlink(temporary);
+    }
+
+    evict(cache, subdirectory, path);
+    free(temporary);
+    free(path);
+    free(subdirectory);
+}
+
+/**
+ * @brief Compiles a program held in memory, reusing the result of an earlier compilation of the same source.
+ *
+ * @details The program goes to out and the error messages to ctx->diagnostics (stderr when NULL),
+ * on a hit and on a miss alike. A miss reuses the code of the functions that did not change
+ * (see incremental_compile()). Internal errors of the compiler (ERR_COMPILER_INTERNAL) are not cached.
+ *
+ * @param cache Opened cache.
+ * @param ctx Context of the compilation.
+ * @param source Source code of the program.
+ * @param length Length of the source in bytes.
+ * @param out Stream receiving the IFJcode24 program.
+ * @param hit Set to whether the result came from the cache (may be NULL).
+ * @return Exit code of the compiler (0 or the ErrorCode).
+ */
+int cache_compile(const CompileCache *cache, CompilerContext *ctx, const char *source, size_t length, FILE *out,
+                  bool *hit)
+{
+    Sha256 hash;
+    unsigned char digest[SHA256_DIGEST_SIZE];
+    char key[SHA256_HEX_SIZE];
+    sha256_init(&hash);
+    sha256_update(&hash, cache->identity, strlen(cache->identity) + 1);
+    sha256_update(&hash, source, length);
+    sha256_final(&hash, digest);
+    sha256_hex(digest, key);
+
+    FILE *diagnostics = ctx->diagnostics;
+    char *path = entry_path(cache, key, true);
+    char *program, *errors;
+    size_t programLength, errorsLength;
+    int exitCode;
+    bool found = read_entry(path, &exitCode, &program, &programLength, &errors, &errorsLength);
+    if (found)
+    {
+        utimensat(AT_FDCWD, path, NULL, 0); // The entry was used now
+    }
+    else
+    {
+        FILE *programStream = open_memstream(&program, &programLength);
+        FILE *errorsStream = open_memstream(&errors, &errorsLength);
+        if (!programStream || !errorsStream)
+            handle_error(ERR_COMPILER_INTERNAL);
+        ctx->diagnostics = errorsStream;
+        exitCode = incremental_compile(cache, ctx, source, length, programStream);
+        ctx->diagnostics = diagnostics;
+        fclose(programStream);
+        fclose(errorsStream);
+        if (exitCode != ERR_COMPILER_INTERNAL)
+            store_entry(cache, key, exitCode, program, programLength, errors, errorsLength);
+    }
+
+    fwrite(program, 1, programLength, out);
+    fwrite(errors, 1, errorsLength, diagnostics ? diagnostics : stderr);
+    free(program);
+    free(errors);
+    free(path);
+    if (hit)
+        *hit = found;
+    return exitCode;
+}
+
+/**
+ * @brief Reads the data stored under the key by cache_store().
+ *
+ * @param cache Opened cache.
+ * @param key Hexadecimal SHA-256 key, distinct from the keys of whole programs.
+ * @param data Receives the data, owned by the caller.
+ * @param length Receives the length of the data.
+ * @return False when there is no such entry.
+ */
+bool cache_load(const CompileCache *cache, const char *key, char **data, size_t *length)
+{
+    char *path = entry_path(cache, key, true);
+    char *errors;
+    size_t errorsLength;
+    int exitCode;
+    bool found = read_entry(path, &exitCode, data, length, &errors, &errorsLength);
+    if (found)
+    {
+        utimensat(AT_FDCWD, path, NULL, 0);
+        free(errors);
+    }
+    free(path);
+    return found;
+}
+
+/**
+ * @brief Stores data under the key, in the format of a successful compilation without messages.
+ */
+void cache_store(const CompileCache *cache, const char *key, const char *data, size_t length)
+{
+    store_entry(cache, key, EXIT_SUCCESS, data, length, "", 0);
+}
@@ -0,0 +1,36 @@
+/**
+ * @file cache.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief On-disk cache of compilation results addressed by the hash of the source (main --cache).
+ */
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "context.h"
+
+#define CACHE_DEFAULT_MAX_BYTES (256LL * 1024 * 1024)
+#define CACHE_IDENTITY_MAX 128
+
+/**
+ * @brief An opened cache directory, shared read-only by the threads of a batch.
+ */
+typedef struct
+{
+    char *directory;
+    long long maxBytes;                    // Bound of the total size of the entries
+    char identity[CACHE_IDENTITY_MAX];     // Cache format and compiler build, part of every key
+} CompileCache;
+
+bool cache_open(CompileCache *cache, const char *directory, long long maxBytes);
+void cache_close(CompileCache *cache);
+int cache_compile(const CompileCache *cache, CompilerContext *ctx, const char *source, size_t length, FILE *out,
+                  bool *hit);
+bool cache_load(const CompileCache *cache, const char *key, char **data, size_t *length);
+void cache_store(const CompileCache *cache, const char *key, const char *data, size_t length);
+
+#endif
@@ -0,0 +1,169 @@
+/**
+ * @file client.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief Thin client of the compile server (main --server).
+ *
+ * @details Sends one program to the server and behaves like the command line compiler: the
+ * IFJcode24 program goes to the standard output, the error messages to the standard error and
+ * the exit code is the one of the compilation.
+ *
+ * Usage: ifj_client [--socket path] [--path] [--quit] [filename]
+ *  - the socket defaults to $IFJ_SOCKET, then to PROTOCOL_DEFAULT_SOCKET,
+ *  - --path sends only the absolute file name, the server reads the file itself,
+ *  - --quit stops the server,
+ *  - the source is read from the standard input without a file name.
+ */
+#define _XOPEN_SOURCE 700
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "protocol.h"
+
+// Reads the whole stream into a new buffer
+static char *read_stream(FILE *stream, size_t *length)
+{
+    size_t capacity = 4096;
+    char *data = malloc(capacity);
+    *length = 0;
+    while (data)
+    {
+        *length += fread(data + *length, 1, capacity - *length, stream);
+        if (*length < capacity)
+            return ferror(stream) ? (free(data), NULL) : data;
+        char *bigger = realloc(data, capacity * 2);
+        if (!bigger)
+            free(data);
+        data = bigger;
+        capacity *= 2;
+    }
+    return NULL;
+}
+
+static int connect_to(const char *socketPath)
+{
+    struct sockaddr_un address;
+    if (strlen(socketPath) >= sizeof(address.sun_path))
+        return -1;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&address, sizeof(address)) < 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+// Copies length bytes of the answer to the stream
+static bool forward(int fd, size_t length, FILE *stream)
+{
+    char buffer[8192];
+    while (length > 0)
+    {
+        size_t chunk = length < sizeof(buffer) ? length : sizeof(buffer);
+        if (!protocol_read_all(fd, buffer, chunk))
+            return false;
+        fwrite(buffer, 1, chunk, stream);
+        length -= chunk;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *socketPath = getenv("IFJ_SOCKET");
+    const char *fileName = NULL;
+    bool sendPath = false;
+    bool quit = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+            socketPath = argv[++i];
+        else if (strcmp(argv[i], "--path") == 0)
+            sendPath = true;
+        else if (strcmp(argv[i], "--quit") == 0)
+            quit = true;
+        else if (!fileName && argv[i][0] != '-')
+            fileName = argv[i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [--socket path] [--path] [--quit] [filename]\n", argv[0]);
+            return 99;
+        }
+    }
+    if (!socketPath)
+        socketPath = PROTOCOL_DEFAULT_SOCKET;
+    if (sendPath && !fileName)
+    {
+        fprintf(stderr, "--path needs a file name\n");
+        return 99;
+    }
+
+    const char *kind = quit ? "QUIT" : sendPath ? "PATH" : "SOURCE";
+    char *body = NULL;
+    size_t length = 0;
+    if (sendPath)
+    {
+        // The server runs in another directory
+        body = realpath(fileName, NULL);
+        if (!body)
+        {
+            fprintf(stderr, "Cannot open file %s\n", fileName);
+            return 99;
+        }
+        length = strlen(body);
+    }
+    else if (!quit)
+    {
+        FILE *file = fileName ? fopen(fileName, "r") : stdin;
+        if (!file)
+        {
+            fprintf(stderr, "Cannot open file %s\n", fileName);
+            return 99;
+        }
+        body = read_stream(file, &length);
+        if (file != stdin)
+            fclose(file);
+        if (!body)
+        {
+            fprintf(stderr, "Cannot read the source\n");
+            return 99;
+        }
+    }
+
+    int fd = connect_to(socketPath);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Cannot connect to the compile server at %s\n", socketPath);
+        free(body);
+        return 99;
+    }
+
+    char header[PROTOCOL_HEADER_MAX];
+    int exitCode = 99;
+    size_t outLength, errLength;
+    snprintf(header, sizeof(header), "%s %zu\n", kind, length);
+    if (!protocol_write_all(fd, header, strlen(header)) || !protocol_write_all(fd, body, length) ||
+        !protocol_read_line(fd, header, sizeof(header)) ||
+        sscanf(header, "%d %zu %zu", &exitCode, &outLength, &errLength) != 3 ||
+        !forward(fd, outLength, stdout) || !forward(fd, errLength, stderr))
+    {
+        fprintf(stderr, "Connection to the compile server at %s failed\n", socketPath);
+        exitCode = 99;
+    }
+
+    close(fd);
+    free(body);
+    return exitCode;
+}
@@ -0,0 +1,231 @@
+/**
+ * @file compiler.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief The compilation pipeline: syntactic and semantic analysis and code generation.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <setjmp.h>
+#include <stdlib.h>
+
+#include "compiler.h"
+#include "syntactic_analysis.h"
+#include "semantic.h"
+#include "symtable.h"
+#include "Code_generator.h"
+#include "literal_pool.h"
+#include "intern.h"
+#include "time_report.h"
+#include "token_pipeline.h"
+
+// Syntactic and semantic analysis of the source, the tree is left in ctx->root
+static void analyse(CompilerContext *ctx, FILE *source)
+{
+    compilerContext = ctx;
+    ctx->root = createBinaryNode(NODE_GENERAL, TOKEN_EMPTY, "");
+    setStartNode(ctx->root);
+
+    // // Syntactic analysis
+    time_report_switch(PHASE_PARSE);
+    lexer_begin(source);
+    ctx->tokens = ctx->pipelinedLexer ? token_pipeline_start(source) : NULL;
+    bool parsed = FIRST(ctx, source);
+    if (ctx->tokens)
+    {
+        token_pipeline_stop(ctx->tokens);
+        ctx->tokens = NULL;
+    }
+    parser_free_tokens(ctx);
+    if (!parsed)
+    {
+        fprintf(compiler_diagnostics(), "%s", " --- WRONG END --- \n");
+        handle_error(ERR_SYNTAX);
+    }
+
+    // The lexer runs inside the parser, both end here
+    time_report_finish_phase(PHASE_PARSE);
+    time_report_finish_phase(PHASE_LEX);
+
+    time_report_switch(PHASE_SEMANTIC);
+    ctx->symbols = initialize_symbol_stack();
+    ProcessTree(ctx, ctx->root, ctx->symbols);
+    free_symbol_stack(ctx->symbols);
+    time_report_finish_phase(PHASE_SEMANTIC);
+}
+
+/**
+ * @brief Compiles one source to the optimised intermediate code.
+ *
+ * @details The phases are timed for --time-report. The tree and the symbol table are kept in the
+ * compiler context while they exist, so an error handler can free them. The literal pool and the
+ * interned names stay filled until the caller frees them (the program does not refer to them).
+ * Errors are reported by handle_error(). ctx becomes the current context of the thread.
+ *
+ * @param ctx Context of the compilation, cleared by the caller.
+ * @param source Source code of the program.
+ * @param stats Optimisation counters to fill (may be NULL).
+ * @param profile Profile recorded by --profile-generate (may be NULL).
+ * @param instrumented Generate also the labels counted by --profile-generate.
+ * @return The program, owned by the caller.
+ */
+IRProgram *compile_program(CompilerContext *ctx, FILE *source, OptimizerStats *stats, const Profile *profile,
+                           bool instrumented)
+{
+    analyse(ctx, source);
+
+    time_report_switch(PHASE_CODEGEN);
+    OptimizerStats local;
+    IRProgram *program = generateProgram(ctx, ctx->root, &local, profile, instrumented);
+    time_report_finish_phase(PHASE_CODEGEN);
+    time_report_count(COUNTER_INSTRUCTIONS, local.instructionsBefore);
+
+    freeBinaryTree(ctx->root);
+    if (stats)
+        *stats = local;
+    return program;
+}
+
+/**
+ * @brief Runs a compilation with an error handler, see compile_to_stream().
+ *
+ * @param unoptimised Receives the unoptimised program instead of printing the program to out
+ * (NULL to print it). It is NULL after an error.
+ */
+static int compile_recovering(CompilerContext *ctx, FILE *source, FILE *out, IRProgram **unoptimised)
+{
+    jmp_buf handler;
+    int exitCode = EXIT_SUCCESS;
+    FILE *diagnostics = ctx->diagnostics;
+    bool pipelinedLexer = ctx->pipelinedLexer;
+
+    compiler_context_reset(ctx);
+    ctx->diagnostics = diagnostics;
+    ctx->pipelinedLexer = pipelinedLexer;
+    ctx->errorHandler = &handler;
+    if (unoptimised)
+        *unoptimised = NULL;
+    if (setjmp(handler) == 0)
+    {
+        if (unoptimised)
+        {
+            analyse(ctx, source);
+            *unoptimised = generateUnoptimisedProgram(ctx, ctx->root);
+            freeBinaryTree(ctx->root);
+        }
+        else
+        {
+            IRProgram *program = compile_program(ctx, source, NULL, NULL, false);
+            ir_print(program, out);
+            ir_free_program(program);
+        }
+    }
+    else
+    {
+        exitCode = ctx->errorCode;
+        if (ctx->tokens)
+            token_pipeline_stop(ctx->tokens);
+        parser_free_tokens(ctx);
+        if (ctx->symbols)
+            free_symbol_stack(ctx->symbols);
+        if (ctx->root)
+            freeBinaryTree(ctx->root);
+        freeGeneratorState(ctx);
+    }
+    literal_pool_free();
+    intern_free();
+    semantic_free();
+    compiler_context_reset(ctx);
+    ctx->diagnostics = diagnostics;
+    ctx->pipelinedLexer = pipelinedLexer;
+    compilerContext = NULL;
+    return exitCode;
+}
+
+/**
+ * @brief Compiles the source to IFJcode24 without ending the process on an error.
+ *
+ * @details Clears the context first, so every call gives the output of a separate run of the
+ * compiler; only ctx->diagnostics and ctx->pipelinedLexer are kept. An error of the compilation
+ * returns here from handle_error(); what the compilation allocated in the tree, the symbol table,
+ * the pools and the lexer thread is freed.
+ *
+ * @param ctx Context of the compilation, error messages go to ctx->diagnostics (stderr when NULL).
+ * @param source Source code of the program.
+ * @param out Stream receiving the IFJcode24 program.
+ * @return Exit code of the compiler (0 or the ErrorCode).
+ */
+int compile_to_stream(CompilerContext *ctx, FILE *source, FILE *out)
+{
+    return compile_recovering(ctx, source, out, NULL);
+}
+
+/**
+ * @brief Compiles the source to the unoptimised program without ending the process on an error.
+ *
+ * @details Like compile_to_stream(), but the program is returned before finishProgram(), for the
+ * incremental compilation (incremental.c).
+ *
+ * @param ctx Context of the compilation, error messages go to ctx->diagnostics (stderr when NULL).
+ * @param source Source code of the program.
+ * @param program Receives the program, owned by the caller (NULL after an error).
+ * @return Exit code of the compiler (0 or the ErrorCode).
+ */
+int compile_unoptimised(CompilerContext *ctx, FILE *source, IRProgram **program)
+{
+    return compile_recovering(ctx, source, NULL, program);
+}
+
+/**
+ * @brief Compiles a program held in memory.
+ *
+ * @details The library entry point of the compiler. The compilation uses only ctx and tables of
+ * the calling thread, so threads with their own contexts can compile at the same time.
+ *
+ * @param ctx Context of the compilation, error messages go to ctx->diagnostics (stderr when NULL).
+ * @param source Source code of the program.
+ * @param length Length of the source in bytes.
+ * @param out Stream receiving the IFJcode24 program.
+ * @return Exit code of the compiler (0 or the ErrorCode), ERR_COMPILER_INTERNAL when the source
+ * cannot be opened as a stream.
+ */
+int ifj_compile(CompilerContext *ctx, const char *source, size_t length, FILE *out)
+{
+    // fmemopen does not take an empty buffer
+    FILE *stream = length > 0 ? fmemopen((void *)source, length, "r") : fopen("/dev/null", "r");
+    if (!stream)
+        return ERR_COMPILER_INTERNAL;
+    int exitCode = compile_to_stream(ctx, stream, out);
+    fclose(stream);
+    return exitCode;
+}
+
+/**
+ * @brief Reads the whole source into memory (for ifj_compile() and the cache).
+ *
+ * @param stream Source code of the program.
+ * @param length Receives the length of the source in bytes.
+ * @return The source, owned by the caller, or NULL when the stream cannot be read.
+ */
+char *compiler_read_source(FILE *stream, size_t *length)
+{
+    size_t capacity = 4096;
+    char *source = malloc(capacity);
+    *length = 0;
+    while (source)
+    {
+        *length += fread(source + *length, 1, capacity - *length, stream);
+        if (*length < capacity)
+            break;
+        char *larger = realloc(source, 2 * capacity);
+        if (!larger)
+            free(source);
+        source = larger;
+        capacity *= 2;
+    }
+    if (source && ferror(stream))
+    {
+        free(source);
+        source = NULL;
+    }
+    return source;
+}
@@ -0,0 +1,26 @@
+/**
+ * @file compiler.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief The compilation pipeline: syntactic and semantic analysis and code generation.
+ */
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "ir.h"
+#include "optimizer.h"
+#include "profile.h"
+#include "context.h"
+
+IRProgram *compile_program(CompilerContext *ctx, FILE *source, OptimizerStats *stats, const Profile *profile,
+                           bool instrumented);
+int compile_to_stream(CompilerContext *ctx, FILE *source, FILE *out);
+int compile_unoptimised(CompilerContext *ctx, FILE *source, IRProgram **program);
+int ifj_compile(CompilerContext *ctx, const char *source, size_t length, FILE *out);
+char *compiler_read_source(FILE *stream, size_t *length);
+
+#endif
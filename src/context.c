@@ -0,0 +1,61 @@
+/**
+ * @file context.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief State of one compilation.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "context.h"
+
+/**
+ * @brief Context of the compilation running in this thread, NULL outside of one.
+ */
+_Thread_local CompilerContext *compilerContext = NULL;
+
+/**
+ * @brief Clears the context for a new compilation.
+ */
+void compiler_context_reset(CompilerContext *context)
+{
+    memset(context, 0, sizeof(CompilerContext));
+}
+
+/**
+ * @brief Returns the stream for the error messages of the compilation.
+ */
+FILE *compiler_diagnostics()
+{
+    return compilerContext && compilerContext->diagnostics ? compilerContext->diagnostics : stderr;
+}
+
+/**
+ * @brief Starts the generation of a function in the current context.
+ *
+ * @details The labels and temporaries of a function are numbered from zero and its labels carry
+ * its name, so the code of a function does not depend on the functions generated before it
+ * (the incremental compilation reuses it, see incremental.c).
+ *
+ * @param name Name of the function, NULL after its end.
+ */
+void compiler_begin_function(const char *name)
+{
+    compilerContext->functionName = name;
+    compilerContext->ifLabelCounter = 0;
+    compilerContext->whileLabelCounter = 0;
+    compilerContext->callSiteCounter = 0;
+    compilerContext->tempCounter = 0;
+    compilerContext->builtinCounter = 0;
+}
+
+/**
+ * @brief Formats the label of a construct of the current function, "$name%kind_number".
+ *
+ * @details '%' cannot appear in an identifier, so the label never collides with a function.
+ */
+void compiler_label(char *buffer, size_t size, const char *kind, int number)
+{
+    const char *function = compilerContext->functionName ? compilerContext->functionName : "";
+    snprintf(buffer, size, "$%s%%%s_%d", function, kind, number);
+}
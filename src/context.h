@@ -0,0 +1,95 @@
+/**
+ * @file context.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief State of one compilation.
+ *
+ * @details Everything a compilation changes and the next one must start without (the position of the
+ * parser in the tree, the nesting counters of the parser, the label and temporary counters of the
+ * generator, the program it appends to and the types of its variables) lives in a CompilerContext.
+ * compiler_context_reset() starts a new compilation, so one process can compile many programs (see
+ * --server) with the output of separate runs.
+ *
+ * The parser gets the context as a parameter. The entry points (FIRST(), ProcessTree(),
+ * generateProgram()) also make it the current context of their thread, compilerContext, which the
+ * helpers below them use. Tables that live for a single phase or a single compilation (literal pool,
+ * interned names) are thread-local, so every thread can run its own compilation (see ifj_compile()).
+ */
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+struct BinaryTreeNode;
+struct DeclaredType;
+struct IRProgram;
+struct Profile;
+struct SymbolStack;
+struct TokenPipeline;
+
+#define FUNCTION_PARAMS_MAX 256
+
+/**
+ * @brief Per-compilation state of the compiler.
+ */
+typedef struct CompilerContext
+{
+    // Syntactic analysis
+    struct BinaryTreeNode *currentNode;    // Node the parser inserts at
+    struct BinaryTreeNode *curInOrderNode; // Start of the in-order traversal
+    int infestNum;                         // Levels to move up after a statement
+    int scopeNum;                          // Nesting of the scopes
+    bool pipelinedLexer;                   // Lex on a thread of its own (--pipeline, token_pipeline.c)
+    struct TokenPipeline *tokens;          // Tokens of that thread while the parser runs, NULL otherwise
+    char **tokenStrings;                   // Strings of the tokens taken by the parser, see parser_free_tokens()
+    int tokenStringCount;
+    int tokenStringCapacity;
+
+    // Counters of the generated names, all but the last one count within the current function
+    const char *functionName; // Function being generated, its labels are $name%kind_N
+    int ifLabelCounter;       // $name%if_N
+    int whileLabelCounter;    // $name%while_start_N
+    int callSiteCounter;      // $name%call_N, labels of the call sites counted by --profile-generate
+    int tempCounter;          // LF@temp_var_eN
+    int builtinCounter;       // Labels of the expanded builtins
+    int inductionCounter;     // Induction variables of the optimiser
+
+    // Code generation (Code_generator.c)
+    struct IRProgram *program;     // Program the generator appends instructions to
+    const struct Profile *profile; // Profile guiding the layout of branches (NULL without --profile-use)
+    bool instrument;               // Generate also the labels counted by --profile-generate
+    int branchesFlipped;
+    int tailCallsEliminated;
+    struct
+    {
+        const char *name;
+        const char *params[FUNCTION_PARAMS_MAX];
+        int paramCount;
+        bool tailCalled; // A self tail call jumps to "$name%tail"
+    } currentFunction;   // Function being generated, used to turn self tail calls into jumps
+    struct DeclaredType *declaredTypes; // Types of the variables of the current function
+    int declaredTypesSize;
+    int declaredTypeCount;          // Entries of the current function
+    unsigned declaredTypesFunction; // Number of the current function, carried by its entries
+
+    // Trees owned by the compilation, freed when an error ends it
+    struct BinaryTreeNode *root;
+    struct SymbolStack *symbols;
+
+    // Error reporting: messages go to diagnostics (stderr when NULL), with an error handler set,
+    // handle_error() jumps to it with the code in errorCode instead of ending the process
+    FILE *diagnostics;
+    jmp_buf *errorHandler;
+    int errorCode;
+} CompilerContext;
+
+extern _Thread_local CompilerContext *compilerContext;
+
+void compiler_context_reset(CompilerContext *context);
+FILE *compiler_diagnostics();
+void compiler_begin_function(const char *name);
+void compiler_label(char *buffer, size_t size, const char *kind, int number);
+
+#endif
@@ -0,0 +1,543 @@
+/**
+ * @file incremental.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief Incremental compilation: the code of unchanged functions is taken from the cache.
+ *
+ * @details The lexer splits the source into its top-level functions. The key of a function is the
+ * hash of the cache identity, of its tokens (white space and comments do not count) and of the
+ * signatures of the user functions it calls. The unoptimised code of a function depends on nothing
+ * else (its labels and temporaries are numbered per function, see generateUnoptimisedProgram()),
+ * so a function with the same key has the same code.
+ *
+ * Every function with its code in the cache is replaced by a stub: the signature of the function
+ * with a body that only returns a value of its type. The stubbed source is compiled as usual, so the
+ * changed functions are analysed against the signatures of all the others; a function calling one
+ * whose signature changed has a new key and is compiled again. The code of the stubs is then
+ * replaced by the cached code and the program is finished by finishProgram(), which gives the
+ * program of a full compilation. A source the splitting does not understand, an error or any
+ * message of the stubbed compilation fall back to the full compilation, which also reports the
+ * errors exactly.
+ *
+ * The cached code of a function is the text of its instructions, a DEFVAR carries its frame slot
+ * in a comment:
+ * @code
+ * DEFVAR LF@x # 3
+ * @endcode
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "incremental.h"
+#include "compiler.h"
+#include "Code_generator.h"
+#include "lexical_analyser.h"
+#include "literal_pool.h"
+#include "intern.h"
+#include "sha256.h"
+
+#define INCREMENTAL_KEY_KIND "function"
+
+/**
+ * @brief A top-level function of the source.
+ */
+typedef struct
+{
+    char *name;
+    long start;       // Offset after the top-level token in front of the function
+    long bodyStart;   // Offset after the opening brace of the body
+    long end;         // Offset after the closing brace of the body
+    const char *stub; // Statement of the stub body, NULL when the function cannot be stubbed
+    unsigned char tokens[SHA256_DIGEST_SIZE];    // Hash of the tokens of the function
+    unsigned char signature[SHA256_DIGEST_SIZE]; // Hash of the tokens in front of the body
+    char **callees;                              // Names of the functions called in the body
+    int calleeCount;
+    int calleeCapacity;
+    char key[SHA256_HEX_SIZE];
+    char *code; // Cached code, NULL when the function is compiled
+    size_t codeLength;
+} SourceFunction;
+
+/**
+ * @brief The functions of the source, in the order of the source.
+ */
+typedef struct
+{
+    SourceFunction *functions;
+    int count;
+    int capacity;
+} SourceFunctions;
+
+static char *copy_text(const char *text)
+{
+    char *copy = malloc(strlen(text) + 1);
+    if (!copy)
+        handle_error(ERR_COMPILER_INTERNAL);
+    strcpy(copy, text);
+    return copy;
+}
+
+static void add_callee(SourceFunction *function, const char *name)
+{
+    if (function->calleeCount == function->calleeCapacity)
+    {
+        function->calleeCapacity = function->calleeCapacity ? 2 * function->calleeCapacity : 8;
+        function->callees = realloc(function->callees, (size_t)function->calleeCapacity * sizeof(char *));
+        if (!function->callees)
+            handle_error(ERR_COMPILER_INTERNAL);
+    }
+    function->callees[function->calleeCount++] = copy_text(name);
+}
+
+static SourceFunction *add_function(SourceFunctions *functions, long start)
+{
+    if (functions->count == functions->capacity)
+    {
+        functions->capacity = functions->capacity ? 2 * functions->capacity : 16;
+        functions->functions = realloc(functions->functions, (size_t)functions->capacity * sizeof(SourceFunction));
+        if (!functions->functions)
+            handle_error(ERR_COMPILER_INTERNAL);
+    }
+    SourceFunction *function = &functions->functions[functions->count++];
+    memset(function, 0, sizeof(SourceFunction));
+    function->start = start;
+    return function;
+}
+
+static void free_functions(SourceFunctions *functions)
+{
+    for (int i = 0; i < functions->count; i++)
+    {
+        SourceFunction *function = &functions->functions[i];
+        for (int c = 0; c < function->calleeCount; c++)
+            free(function->callees[c]);
+        free(function->callees);
+        free(function->name);
+        free(function->code);
+    }
+    free(functions->functions);
+}
+
+// Hashes the type and the text of a token
+static void hash_token(Sha256 *hash, const Token *token)
+{
+    unsigned char type = (unsigned char)token->type;
+    sha256_update(hash, &type, 1);
+    sha256_update(hash, token->value.valueString.str, strlen(token->value.valueString.str) + 1);
+}
+
+// Statement of a stub body returning a value of the type, NULL when there is no such statement
+static const char *stub_statement(Keyword returnType)
+{
+    switch (returnType)
+    {
+    case KEYWORD_VOID:
+        return "return;";
+    case KEYWORD_I32:
+        return "return 0;";
+    case KEYWORD_F64:
+        return "return 0.0;";
+    case KEYWORD_I32_NULL:
+    case KEYWORD_F64_NULL:
+        return "return null;";
+    default:
+        return NULL;
+    }
+}
+
+/**
+ * @brief Reads the tokens of the source and records its top-level functions.
+ *
+ * @details Everything in front of the first "pub" is the prolog, after it only functions may
+ * follow. A call is an identifier followed by "(" and not preceded by "." (the built-ins are
+ * "ifj.name(").
+ *
+ * @return False when the source has no functions or something else than a function follows them.
+ */
+static bool scan_functions(FILE *stream, SourceFunctions *functions)
+{
+    SourceFunction *current = NULL;
+    Sha256 tokens, signature;
+    Keyword returnType = KEYWORD_NONE;
+    Keyword previousKeyword = KEYWORD_NONE;
+    Token_type previous = TOKEN_EOF, beforePrevious = TOKEN_EOF;
+    char *previousIdentifier = NULL;
+    long previousEnd = 0;
+    int depth = 0;
+    bool valid = true;
+
+    while (valid)
+    {
+        Token token = get_token(stream);
+        long position = lexer_position();
+        Token_type type = token.type;
+        if (type == TOKEN_EOF || type == TOKEN_EOL || type == TOKEN_COMMENT)
+        {
+            dynamic_string_free(&token.value.valueString);
+            if (type == TOKEN_EOF)
+                break;
+            continue;
+        }
+
+        if (!current && type == TOKEN_KEYWORD && token.keyword_val == KEYWORD_PUB)
+        {
+            current = add_function(functions, previousEnd);
+            sha256_init(&tokens);
+            sha256_init(&signature);
+            returnType = KEYWORD_NONE;
+            depth = 0;
+        }
+        else if (!current && functions->count > 0)
+        {
+            valid = false;
+        }
+
+        if (current)
+        {
+            hash_token(&tokens, &token);
+            if (depth == 0)
+            {
+                // The last keyword in front of the body is the return type
+                hash_token(&signature, &token);
+                if (type == TOKEN_IDENTIFIER && previousKeyword == KEYWORD_FN && !current->name)
+                    current->name = copy_text(token.value.valueString.str);
+                if (type == TOKEN_KEYWORD)
+                    returnType = token.keyword_val;
+                if (type == TOKEN_CURLYL_BRACKET)
+                {
+                    depth = 1;
+                    current->bodyStart = position;
+                }
+            }
+            else if (type == TOKEN_CURLYL_BRACKET)
+            {
+                depth++;
+            }
+            else if (type == TOKEN_CURLYR_BRACKET && --depth == 0)
+            {
+                current->end = position;
+                current->stub = current->name ? stub_statement(returnType) : NULL;
+                sha256_final(&tokens, current->tokens);
+                sha256_final(&signature, current->signature);
+                current = NULL;
+            }
+            else if (type == TOKEN_LPAREN && previous == TOKEN_IDENTIFIER && beforePrevious != TOKEN_DOT)
+            {
+                add_callee(current, previousIdentifier);
+            }
+        }
+
+        free(previousIdentifier);
+        previousIdentifier = type == TOKEN_IDENTIFIER ? copy_text(token.value.valueString.str) : NULL;
+        previousKeyword = type == TOKEN_KEYWORD ? token.keyword_val : KEYWORD_NONE;
+        beforePrevious = previous;
+        previous = type;
+        previousEnd = position;
+        dynamic_string_free(&token.value.valueString);
+    }
+
+    free(previousIdentifier);
+    return valid && !current && functions->count > 0;
+}
+
+/**
+ * @brief Splits the source into its top-level functions.
+ *
+ * @details A lexical error ends the splitting, the full compilation then reports it. The literals
+ * the lexer put into the literal pool are freed.
+ *
+ * @return False when the source cannot be compiled incrementally.
+ */
+static bool split_source(CompilerContext *ctx, const char *source, size_t length, SourceFunctions *functions)
+{
+    FILE *stream = fmemopen((void *)source, length, "r");
+    if (!stream)
+        return false;
+
+    jmp_buf handler;
+    bool valid;
+    compilerContext = ctx;
+    ctx->errorHandler = &handler;
+    lexer_begin(stream);
+    if (setjmp(handler) == 0)
+        valid = scan_functions(stream, functions);
+    else
+        valid = false;
+    ctx->errorHandler = NULL;
+    compilerContext = NULL;
+    literal_pool_free();
+    intern_free();
+    fclose(stream);
+    return valid;
+}
+
+static int compare_names(const void *a, const void *b)
+{
+    return strcmp((*(const SourceFunction *const *)a)->name, (*(const SourceFunction *const *)b)->name);
+}
+
+/**
+ * @brief Computes the keys of the functions and loads the cached code of those that can be stubbed.
+ *
+ * @details The callees are looked up by name in a sorted copy of the function list. A call of an
+ * unknown function is hashed as well, defining the function later changes the key.
+ */
+static void load_functions(const CompileCache *cache, SourceFunctions *functions)
+{
+    SourceFunction **sorted = malloc((size_t)functions->count * sizeof(SourceFunction *));
+    if (!sorted)
+        handle_error(ERR_COMPILER_INTERNAL);
+    int named = 0;
+    for (int i = 0; i < functions->count; i++)
+    {
+        if (functions->functions[i].name)
+            sorted[named++] = &functions->functions[i];
+    }
+    qsort(sorted, (size_t)named, sizeof(SourceFunction *), compare_names);
+
+    static const unsigned char unknown[SHA256_DIGEST_SIZE] = {0};
+    for (int i = 0; i < functions->count; i++)
+    {
+        SourceFunction *function = &functions->functions[i];
+        if (!function->stub)
+            continue;
+
+        Sha256 hash;
+        unsigned char digest[SHA256_DIGEST_SIZE];
+        sha256_init(&hash);
+        sha256_update(&hash, cache->identity, strlen(cache->identity) + 1);
+        sha256_update(&hash, INCREMENTAL_KEY_KIND, sizeof(INCREMENTAL_KEY_KIND));
+        sha256_update(&hash, function->tokens, SHA256_DIGEST_SIZE);
+        for (int c = 0; c < function->calleeCount; c++)
+        {
+            SourceFunction probe = {.name = function->callees[c]};
+            SourceFunction *key = &probe;
+            SourceFunction **callee = bsearch(&key, sorted, (size_t)named, sizeof(SourceFunction *), compare_names);
+            sha256_update(&hash, function->callees[c], strlen(function->callees[c]) + 1);
+            sha256_update(&hash, callee ? (*callee)->signature : unknown, SHA256_DIGEST_SIZE);
+        }
+        sha256_final(&hash, digest);
+        sha256_hex(digest, function->key);
+
+        if (!cache_load(cache, function->key, &function->code, &function->codeLength))
+            function->code = NULL;
+    }
+    free(sorted);
+}
+
+/**
+ * @brief Builds the source with the cached functions replaced by stubs.
+ *
+ * @details A stub keeps the lines of the body, so the rest of the source stays on its lines.
+ *
+ * @param length Receives the length of the stubbed source.
+ * @return The stubbed source, owned by the caller.
+ */
+static char *stub_source(const char *source, size_t sourceLength, const SourceFunctions *functions, size_t *length)
+{
+    char *stubbed;
+    FILE *stream = open_memstream(&stubbed, length);
+    if (!stream)
+        handle_error(ERR_COMPILER_INTERNAL);
+
+    long copied = 0;
+    for (int i = 0; i < functions->count; i++)
+    {
+        const SourceFunction *function = &functions->functions[i];
+        if (!function->code)
+            continue;
+        fwrite(source + copied, 1, (size_t)(function->bodyStart - copied), stream);
+        fprintf(stream, " %s ", function->stub);
+        for (long at = function->bodyStart; at < function->end; at++)
+        {
+            if (source[at] == '\n')
+                fputc('\n', stream);
+        }
+        fputc('}', stream);
+        copied = function->end;
+    }
+    fwrite(source + copied, 1, sourceLength - (size_t)copied, stream);
+    fclose(stream);
+    return stubbed;
+}
+
+// Writes the instructions from..to-1 in the format of the cached code
+static void write_code(const IRProgram *program, int from, int to, FILE *out)
+{
+    for (int i = from; i < to; i++)
+    {
+        const IRInstruction *instr = &program->code[i];
+        if (instr->op == IR_NOP)
+            continue;
+        ir_print_instruction(instr, out);
+        if (instr->op == IR_DEFVAR && instr->slot >= 0)
+            fprintf(out, " # %d", instr->slot);
+        fputc('\n', out);
+    }
+}
+
+// Appends the instructions of code written by write_code() to the program, the code is modified
+static void read_code(IRProgram *program, char *code, size_t length)
+{
+    char *line = code;
+    for (size_t at = 0; at < length; at++)
+    {
+        if (code[at] != '\n')
+            continue;
+        code[at] = '\0';
+        int count = program->count;
+        ir_emit_line(program, line);
+        const char *slot = strchr(line, '#');
+        if (program->count > count && program->code[count].op == IR_DEFVAR && slot)
+            program->code[count].slot = atoi(slot + 1);
+        line = code + at + 1;
+    }
+}
+
+// Number of scratch registers the program uses, the lowest free one is always taken
+static int count_scratch(const IRProgram *program)
+{
+    int count = 0;
+    for (int i = 0; i < program->count; i++)
+    {
+        for (int a = 0; a < program->code[i].argc; a++)
+        {
+            int reg;
+            const char *arg = program->code[i].args[a];
+            if (arg && sscanf(arg, "GF@%%r%d", &reg) == 1 && reg >= count)
+                count = reg + 1;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Puts together the unoptimised program from the stubbed compilation and the cached code.
+ *
+ * @details The code of the compiled functions is stored in the cache. Functions are generated in
+ * the order of the source, the k-th function of the program is the k-th function of the source.
+ *
+ * @return The program, or NULL when the functions of the program do not match the source.
+ */
+static IRProgram *splice(const CompileCache *cache, const SourceFunctions *functions, const IRProgram *stubbed)
+{
+    char *text;
+    size_t textLength;
+    FILE *stream = open_memstream(&text, &textLength);
+    if (!stream)
+        handle_error(ERR_COMPILER_INTERNAL);
+
+    int next = 0;
+    bool matches = true;
+    for (int start = 0; start < stubbed->count && matches;)
+    {
+        int end = ir_function_end(stubbed, start);
+        if (!ir_is_function_entry(stubbed, start))
+        {
+            write_code(stubbed, start, end, stream);
+            start = end;
+            continue;
+        }
+
+        const SourceFunction *function = next < functions->count ? &functions->functions[next++] : NULL;
+        matches = function && function->name && strcmp(stubbed->code[start].args[0] + 1, function->name) == 0;
+        if (matches && function->code)
+        {
+            fwrite(function->code, 1, function->codeLength, stream);
+        }
+        else if (matches)
+        {
+            char *code;
+            size_t codeLength;
+            FILE *codeStream = open_memstream(&code, &codeLength);
+            if (!codeStream)
+                handle_error(ERR_COMPILER_INTERNAL);
+            write_code(stubbed, start, end, codeStream);
+            fclose(codeStream);
+            if (function->stub)
+                cache_store(cache, function->key, code, codeLength);
+            fwrite(code, 1, codeLength, stream);
+            free(code);
+        }
+        start = end;
+    }
+    fclose(stream);
+
+    IRProgram *program = NULL;
+    if (matches && next == functions->count)
+    {
+        program = ir_create_program();
+        read_code(program, text, textLength);
+        program->scratchCount = count_scratch(program);
+    }
+    free(text);
+    return program;
+}
+
+/**
+ * @brief Compiles a program held in memory, reusing the cached code of its unchanged functions.
+ *
+ * @details The output equals the output of ifj_compile(), which is used whenever the source cannot
+ * be compiled incrementally. The code of the functions compiled now is stored in the cache.
+ *
+ * @param cache Opened cache.
+ * @param ctx Context of the compilation, error messages go to ctx->diagnostics (stderr when NULL).
+ * @param source Source code of the program.
+ * @param length Length of the source in bytes.
+ * @param out Stream receiving the IFJcode24 program.
+ * @return Exit code of the compiler (0 or the ErrorCode).
+ */
+int incremental_compile(const CompileCache *cache, CompilerContext *ctx, const char *source, size_t length,
+                        FILE *out)
+{
+    // Messages of the splitting and of the stubbed compilation are not shown, any of them falls back
+    char *messages;
+    size_t messagesLength;
+    FILE *diagnostics = ctx->diagnostics;
+    FILE *quiet = open_memstream(&messages, &messagesLength);
+    if (!quiet)
+        handle_error(ERR_COMPILER_INTERNAL);
+    ctx->diagnostics = quiet;
+
+    SourceFunctions functions = {NULL, 0, 0};
+    IRProgram *program = NULL;
+    if (split_source(ctx, source, length, &functions))
+    {
+        load_functions(cache, &functions);
+        size_t stubbedLength;
+        char *stubbed = stub_source(source, length, &functions, &stubbedLength);
+        FILE *stream = fmemopen(stubbed, stubbedLength, "r");
+        IRProgram *unoptimised = NULL;
+        int exitCode = stream ? compile_unoptimised(ctx, stream, &unoptimised) : ERR_COMPILER_INTERNAL;
+        if (stream)
+            fclose(stream);
+        fflush(quiet);
+        if (exitCode == EXIT_SUCCESS && messagesLength == 0)
+            program = splice(cache, &functions, unoptimised);
+        if (unoptimised)
+            ir_free_program(unoptimised);
+        free(stubbed);
+    }
+    fclose(quiet);
+    free(messages);
+    free_functions(&functions);
+    ctx->diagnostics = diagnostics;
+
+    if (!program)
+        return ifj_compile(ctx, source, length, out);
+
+    // The optimiser numbers its variables in the context, from zero like in a full compilation
+    bool pipelinedLexer = ctx->pipelinedLexer;
+    compiler_context_reset(ctx);
+    ctx->diagnostics = diagnostics;
+    ctx->pipelinedLexer = pipelinedLexer;
+    compilerContext = ctx;
+    finishProgram(program, NULL, NULL);
+    ir_print(program, out);
+    ir_free_program(program);
+    compilerContext = NULL;
+    return EXIT_SUCCESS;
+}
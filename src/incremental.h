@@ -0,0 +1,19 @@
+/**
+ * @file incremental.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief Incremental compilation: the code of unchanged functions is taken from the cache.
+ */
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "cache.h"
+#include "context.h"
+
+int incremental_compile(const CompileCache *cache, CompilerContext *ctx, const char *source, size_t length,
+                        FILE *out);
+
+#endif
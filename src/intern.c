@@ -0,0 +1,99 @@
+/**
+ * @file intern.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Abstract syntax tree
+ * @brief Table of interned identifiers.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "intern.h"
+#include "error.h"
+
+#define INTERN_INITIAL_SIZE 256
+
+// Open addressing table of the interned strings, kept at most half full, one per thread
+static _Thread_local char **table = NULL;
+static _Thread_local int tableSize = 0;
+static _Thread_local int internedCount = 0;
+static _Thread_local unsigned long generation = 1; // Changes with every intern_free()
+
+// djb2
+static unsigned long intern_hash(const char *text)
+{
+    unsigned long hash = 5381;
+    for (const unsigned char *c = (const unsigned char *)text; *c; c++)
+        hash = hash * 33 + *c;
+    return hash;
+}
+
+static int intern_slot(char **entries, int size, const char *text)
+{
+    int slot = (int)(intern_hash(text) & (unsigned long)(size - 1));
+    while (entries[slot] != NULL && strcmp(entries[slot], text) != 0)
+        slot = (slot + 1) & (size - 1);
+    return slot;
+}
+
+static void intern_grow()
+{
+    int newSize = tableSize ? tableSize * 2 : INTERN_INITIAL_SIZE;
+    char **newTable = calloc(newSize, sizeof(char *));
+    if (!newTable)
+        handle_error(ERR_COMPILER_INTERNAL);
+    for (int i = 0; i < tableSize; i++)
+    {
+        if (table[i] != NULL)
+            newTable[intern_slot(newTable, newSize, table[i])] = table[i];
+    }
+    free(table);
+    table = newTable;
+    tableSize = newSize;
+}
+
+/**
+ * @brief Returns the interned copy of the string.
+ *
+ * @param text String to intern.
+ * @return The single copy of the string, valid until intern_free().
+ */
+const char *intern(const char *text)
+{
+    if (2 * (internedCount + 1) > tableSize)
+        intern_grow();
+
+    int slot = intern_slot(table, tableSize, text);
+    if (table[slot] == NULL)
+    {
+        table[slot] = malloc(strlen(text) + 1);
+        if (!table[slot])
+            handle_error(ERR_COMPILER_INTERNAL);
+        strcpy(table[slot], text);
+        internedCount++;
+    }
+    return table[slot];
+}
+
+/**
+ * @brief Returns the generation of the table.
+ *
+ * @details The generation changes when intern_free() drops the interned strings, so a cache of
+ * interned pointers knows when it has to intern its names again.
+ */
+unsigned long intern_generation()
+{
+    return generation;
+}
+
+/**
+ * @brief Frees all interned strings.
+ */
+void intern_free()
+{
+    for (int i = 0; i < tableSize; i++)
+        free(table[i]);
+    free(table);
+    table = NULL;
+    tableSize = internedCount = 0;
+    generation++;
+}
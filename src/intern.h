@@ -0,0 +1,18 @@
+/**
+ * @file intern.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Abstract syntax tree
+ * @brief Table of interned identifiers.
+ *
+ * @details Every distinct identifier is stored once, so two interned names are equal exactly when
+ * their pointers are equal. AST nodes of identifiers keep the interned name (see NodeValue),
+ * the analyses compare names by pointer instead of strcmp().
+ */
+#ifndef INTERN_H
+#define INTERN_H
+
+const char *intern(const char *text);
+unsigned long intern_generation();
+void intern_free();
+
+#endif
@@ -0,0 +1,766 @@
+/**
+ * @file ir.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Code generator
+ * @brief Intermediate representation of the generated IFJcode24 program.
+ */
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ir.h"
+#include "error.h"
+
+#define IR_INITIAL_CAPACITY 256
+#define IR_LINE_BUFFER 512
+
+// Mnemonics indexed by IROpcode
+static const char *opcodeNames[IR_OPCODE_COUNT] = {
+    [IR_NOP] = "",
+    [IR_HEADER] = ".IFJcode24",
+    [IR_COMMENT] = "#",
+    [IR_UNKNOWN] = "",
+    [IR_MOVE] = "MOVE",
+    [IR_CREATEFRAME] = "CREATEFRAME",
+    [IR_PUSHFRAME] = "PUSHFRAME",
+    [IR_POPFRAME] = "POPFRAME",
+    [IR_DEFVAR] = "DEFVAR",
+    [IR_CALL] = "CALL",
+    [IR_RETURN] = "RETURN",
+    [IR_PUSHS] = "PUSHS",
+    [IR_POPS] = "POPS",
+    [IR_CLEARS] = "CLEARS",
+    [IR_ADD] = "ADD",
+    [IR_SUB] = "SUB",
+    [IR_MUL] = "MUL",
+    [IR_DIV] = "DIV",
+    [IR_IDIV] = "IDIV",
+    [IR_ADDS] = "ADDS",
+    [IR_SUBS] = "SUBS",
+    [IR_MULS] = "MULS",
+    [IR_DIVS] = "DIVS",
+    [IR_IDIVS] = "IDIVS",
+    [IR_LT] = "LT",
+    [IR_GT] = "GT",
+    [IR_EQ] = "EQ",
+    [IR_LTS] = "LTS",
+    [IR_GTS] = "GTS",
+    [IR_EQS] = "EQS",
+    [IR_AND] = "AND",
+    [IR_OR] = "OR",
+    [IR_NOT] = "NOT",
+    [IR_ANDS] = "ANDS",
+    [IR_ORS] = "ORS",
+    [IR_NOTS] = "NOTS",
+    [IR_INT2FLOAT] = "INT2FLOAT",
+    [IR_FLOAT2INT] = "FLOAT2INT",
+    [IR_INT2CHAR] = "INT2CHAR",
+    [IR_STRI2INT] = "STRI2INT",
+    [IR_INT2FLOATS] = "INT2FLOATS",
+    [IR_FLOAT2INTS] = "FLOAT2INTS",
+    [IR_INT2CHARS] = "INT2CHARS",
+    [IR_STRI2INTS] = "STRI2INTS",
+    [IR_READ] = "READ",
+    [IR_WRITE] = "WRITE",
+    [IR_CONCAT] = "CONCAT",
+    [IR_STRLEN] = "STRLEN",
+    [IR_GETCHAR] = "GETCHAR",
+    [IR_SETCHAR] = "SETCHAR",
+    [IR_TYPE] = "TYPE",
+    [IR_LABEL] = "LABEL",
+    [IR_JUMP] = "JUMP",
+    [IR_JUMPIFEQ] = "JUMPIFEQ",
+    [IR_JUMPIFNEQ] = "JUMPIFNEQ",
+    [IR_JUMPIFEQS] = "JUMPIFEQS",
+    [IR_JUMPIFNEQS] = "JUMPIFNEQS",
+    [IR_EXIT] = "EXIT",
+    [IR_BREAK] = "BREAK",
+    [IR_DPRINT] = "DPRINT",
+};
+
+// Copies operand text into memory owned by the program.
+static char *ir_copy(const char *str)
+{
+    if (!str)
+        return NULL;
+    size_t len = strlen(str);
+    char *copy = malloc(len + 1);
+    if (!copy)
+        handle_error(ERR_COMPILER_INTERNAL);
+    memcpy(copy, str, len + 1);
+    return copy;
+}
+
+// Case-insensitive comparison, IFJcode24 mnemonics are not case sensitive.
+static bool ir_name_equals(const char *a, const char *b)
+{
+    while (*a && *b)
+    {
+        if (toupper((unsigned char)*a) != toupper((unsigned char)*b))
+            return false;
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+/**
+ * @brief Allocates an empty program.
+ * @return Pointer to the new program.
+ */
+IRProgram *ir_create_program()
+{
+    IRProgram *program = malloc(sizeof(IRProgram));
+    if (!program)
+        handle_error(ERR_COMPILER_INTERNAL);
+    program->code = malloc(sizeof(IRInstruction) * IR_INITIAL_CAPACITY);
+    if (!program->code)
+        handle_error(ERR_COMPILER_INTERNAL);
+    program->count = 0;
+    program->capacity = IR_INITIAL_CAPACITY;
+    for (int i = 0; i < IR_SCRATCH_MAX; i++)
+        program->scratchLive[i] = false;
+    program->scratchCount = 0;
+    return program;
+}
+
+/**
+ * @brief Frees the program together with all operand strings.
+ * @param program Program to free.
+ */
+void ir_free_program(IRProgram *program)
+{
+    if (!program)
+        return;
+    for (int i = 0; i < program->count; i++)
+        ir_remove(&program->code[i]);
+    free(program->code);
+    free(program);
+}
+
+// Makes room for one more instruction
+static void ir_reserve(IRProgram *program)
+{
+    if (program->count < program->capacity)
+        return;
+    int newCapacity = program->capacity * 2;
+    IRInstruction *newCode = realloc(program->code, sizeof(IRInstruction) * newCapacity);
+    if (!newCode)
+        handle_error(ERR_COMPILER_INTERNAL);
+    program->code = newCode;
+    program->capacity = newCapacity;
+}
+
+/**
+ * @brief Appends a structured instruction.
+ *
+ * @param program Target program.
+ * @param op Opcode of the instruction.
+ * @param arg1 First operand or NULL.
+ * @param arg2 Second operand or NULL.
+ * @param arg3 Third operand or NULL.
+ */
+void ir_append(IRProgram *program, IROpcode op, const char *arg1, const char *arg2, const char *arg3)
+{
+    ir_reserve(program);
+    IRInstruction *instr = &program->code[program->count++];
+    const char *args[IR_MAX_ARGS] = {arg1, arg2, arg3};
+    instr->op = op;
+    instr->argc = 0;
+    instr->text = NULL;
+    instr->slot = -1;
+    for (int i = 0; i < IR_MAX_ARGS; i++)
+    {
+        instr->args[i] = ir_copy(args[i]);
+        if (args[i])
+            instr->argc = i + 1;
+    }
+}
+
+/**
+ * @brief Parses one line of IFJcode24 and appends it to the program.
+ *
+ * @details Operands of IFJcode24 never contain white space (it is escaped in string
+ * literals), so the line is split on spaces and tabs. Everything after '#' is a comment.
+ *
+ * @param program Target program.
+ * @param line Text of the instruction.
+ */
+void ir_emit_line(IRProgram *program, const char *line)
+{
+    char buffer[IR_LINE_BUFFER];
+    char *work = buffer;
+    size_t len = strlen(line);
+    if (len >= sizeof(buffer))
+    {
+        work = malloc(len + 1);
+        if (!work)
+            handle_error(ERR_COMPILER_INTERNAL);
+    }
+    memcpy(work, line, len + 1);
+
+    char *fields[IR_MAX_ARGS + 1] = {NULL, NULL, NULL, NULL};
+    int fieldCount = 0;
+    char *cursor = work;
+    while (*cursor && fieldCount <= IR_MAX_ARGS)
+    {
+        while (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r')
+            cursor++;
+        if (*cursor == '\0' || *cursor == '#')
+            break;
+        fields[fieldCount++] = cursor;
+        while (*cursor && *cursor != ' ' && *cursor != '\t' && *cursor != '\n' && *cursor != '\r')
+            cursor++;
+        if (*cursor)
+            *cursor++ = '\0';
+    }
+
+    if (fieldCount == 0)
+    {
+        // Empty line or a comment only
+        const char *comment = strchr(line, '#');
+        if (comment)
+        {
+            ir_append(program, IR_COMMENT, NULL, NULL, NULL);
+            program->code[program->count - 1].text = ir_copy(comment);
+        }
+    }
+    else
+    {
+        IROpcode op = ir_opcode_from_name(fields[0]);
+        if (op == IR_UNKNOWN)
+        {
+            ir_append(program, IR_UNKNOWN, NULL, NULL, NULL);
+            program->code[program->count - 1].text = ir_copy(line);
+        }
+        else
+        {
+            ir_append(program, op, fields[1], fields[2], fields[3]);
+        }
+    }
+
+    if (work != buffer)
+        free(work);
+}
+
+/**
+ * @brief Reads a whole IFJcode24 program from the stream.
+ *
+ * @param in Stream with the program text.
+ * @return New program with one instruction per line.
+ */
+IRProgram *ir_read(FILE *in)
+{
+    IRProgram *program = ir_create_program();
+    size_t capacity = IR_LINE_BUFFER, len = 0;
+    char *line = malloc(capacity);
+    if (!line)
+        handle_error(ERR_COMPILER_INTERNAL);
+
+    int c;
+    while ((c = fgetc(in)) != EOF)
+    {
+        if (c == '\n')
+        {
+            line[len] = '\0';
+            ir_emit_line(program, line);
+            len = 0;
+            continue;
+        }
+        if (len + 1 == capacity)
+        {
+            capacity *= 2;
+            char *bigger = realloc(line, capacity);
+            if (!bigger)
+                handle_error(ERR_COMPILER_INTERNAL);
+            line = bigger;
+        }
+        line[len++] = (char)c;
+    }
+    if (len > 0)
+    {
+        line[len] = '\0';
+        ir_emit_line(program, line);
+    }
+    free(line);
+    return program;
+}
+
+/**
+ * @brief printf-like wrapper around ir_emit_line().
+ *
+ * @param program Target program.
+ * @param fmt Format of the instruction line.
+ */
+void ir_emit(IRProgram *program, const char *fmt, ...)
+{
+    char buffer[IR_LINE_BUFFER];
+    va_list args;
+
+    va_start(args, fmt);
+    int needed = vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    if (needed < 0)
+        handle_error(ERR_COMPILER_INTERNAL);
+
+    if ((size_t)needed < sizeof(buffer))
+    {
+        ir_emit_line(program, buffer);
+        return;
+    }
+
+    char *line = malloc((size_t)needed + 1);
+    if (!line)
+        handle_error(ERR_COMPILER_INTERNAL);
+    va_start(args, fmt);
+    vsnprintf(line, (size_t)needed + 1, fmt, args);
+    va_end(args);
+    ir_emit_line(program, line);
+    free(line);
+}
+
+/**
+ * @brief Returns the mnemonic of the opcode.
+ */
+const char *ir_opcode_name(IROpcode op)
+{
+    if (op < 0 || op >= IR_OPCODE_COUNT)
+        return "";
+    return opcodeNames[op];
+}
+
+/**
+ * @brief Finds the opcode for the mnemonic.
+ * @return Opcode or IR_UNKNOWN.
+ */
+IROpcode ir_opcode_from_name(const char *name)
+{
+    if (strcmp(name, ".IFJcode24") == 0)
+        return IR_HEADER;
+    for (int op = IR_MOVE; op < IR_OPCODE_COUNT; op++)
+    {
+        if (toupper((unsigned char)name[0]) == opcodeNames[op][0] && ir_name_equals(name, opcodeNames[op]))
+            return (IROpcode)op;
+    }
+    return IR_UNKNOWN;
+}
+
+/**
+ * @brief Checks whether the instruction stores a result into its first operand.
+ */
+bool ir_writes_first_arg(IROpcode op)
+{
+    switch (op)
+    {
+    case IR_MOVE:
+    case IR_POPS:
+    case IR_ADD:
+    case IR_SUB:
+    case IR_MUL:
+    case IR_DIV:
+    case IR_IDIV:
+    case IR_LT:
+    case IR_GT:
+    case IR_EQ:
+    case IR_AND:
+    case IR_OR:
+    case IR_NOT:
+    case IR_INT2FLOAT:
+    case IR_FLOAT2INT:
+    case IR_INT2CHAR:
+    case IR_STRI2INT:
+    case IR_READ:
+    case IR_CONCAT:
+    case IR_STRLEN:
+    case IR_GETCHAR:
+    case IR_SETCHAR:
+    case IR_TYPE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Checks whether the instruction ends (or starts) a basic block.
+ *
+ * @details Frame instructions are boundaries too, because they change what
+ * LF@ and TF@ operands refer to.
+ */
+bool ir_ends_block(IROpcode op)
+{
+    switch (op)
+    {
+    case IR_LABEL:
+    case IR_JUMP:
+    case IR_JUMPIFEQ:
+    case IR_JUMPIFNEQ:
+    case IR_JUMPIFEQS:
+    case IR_JUMPIFNEQS:
+    case IR_CALL:
+    case IR_RETURN:
+    case IR_EXIT:
+    case IR_CREATEFRAME:
+    case IR_PUSHFRAME:
+    case IR_POPFRAME:
+    case IR_UNKNOWN:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Replaces one operand of the instruction.
+ */
+void ir_set_arg(IRInstruction *instr, int index, const char *value)
+{
+    free(instr->args[index]);
+    instr->args[index] = ir_copy(value);
+    if (value && index >= instr->argc)
+        instr->argc = index + 1;
+}
+
+/**
+ * @brief Rewrites the instruction in place.
+ *
+ * @details Operands may point into the instruction itself, they are copied before the old ones are released.
+ */
+void ir_replace(IRInstruction *instr, IROpcode op, const char *arg1, const char *arg2, const char *arg3)
+{
+    char *args[IR_MAX_ARGS] = {ir_copy(arg1), ir_copy(arg2), ir_copy(arg3)};
+    ir_remove(instr);
+    instr->op = op;
+    for (int i = 0; i < IR_MAX_ARGS; i++)
+    {
+        instr->args[i] = args[i];
+        if (args[i])
+            instr->argc = i + 1;
+    }
+}
+
+/**
+ * @brief Inserts a new instruction before the given index.
+ *
+ * @details Pointers to instructions of the program are invalidated.
+ */
+void ir_insert(IRProgram *program, int index, IROpcode op, const char *arg1, const char *arg2, const char *arg3)
+{
+    ir_append(program, op, arg1, arg2, arg3);
+    IRInstruction inserted = program->code[program->count - 1];
+    memmove(&program->code[index + 1], &program->code[index], sizeof(IRInstruction) * (program->count - 1 - index));
+    program->code[index] = inserted;
+}
+
+/**
+ * @brief Turns the instruction into IR_NOP and releases its operands.
+ */
+void ir_remove(IRInstruction *instr)
+{
+    for (int i = 0; i < IR_MAX_ARGS; i++)
+    {
+        free(instr->args[i]);
+        instr->args[i] = NULL;
+    }
+    free(instr->text);
+    instr->text = NULL;
+    instr->argc = 0;
+    instr->slot = -1;
+    instr->op = IR_NOP;
+}
+
+// DJB2 hash of a variable name
+static unsigned long ir_hash(const char *text)
+{
+    unsigned long hash = 5381;
+    for (const unsigned char *c = (const unsigned char *)text; *c; c++)
+        hash = hash * 33 + *c;
+    return hash;
+}
+
+/**
+ * @brief Moves all DEFVAR instructions from the given index to the start of that range.
+ *
+ * @details IFJcode24 forbids defining a variable twice in one frame, so declarations generated
+ * inside loops (or in sibling blocks using the same name) must be executed only once per call.
+ * The relative order of the other instructions is kept, repeated declarations are dropped.
+ * The declared names are kept in an open-addressing set, so the cost is linear in the body.
+ *
+ * @param program Program to modify.
+ * @param from Index of the first instruction of the function body.
+ */
+void ir_hoist_defvars(IRProgram *program, int from)
+{
+    int count = program->count - from;
+    if (count <= 0)
+        return;
+
+    // At most half full, the body has at most count declarations
+    int size = 16;
+    while (size < 2 * count)
+        size *= 2;
+    IRInstruction *body = malloc(sizeof(IRInstruction) * count);
+    const char **declared = calloc((size_t)size, sizeof(const char *));
+    if (!body || !declared)
+        handle_error(ERR_COMPILER_INTERNAL);
+
+    int out = from;
+    int rest = 0;
+    for (int i = from; i < program->count; i++)
+    {
+        IRInstruction *instr = &program->code[i];
+        if (instr->op != IR_DEFVAR)
+        {
+            body[rest++] = *instr;
+            continue;
+        }
+
+        int slot = (int)(ir_hash(instr->args[0]) & (unsigned long)(size - 1));
+        while (declared[slot] && strcmp(declared[slot], instr->args[0]) != 0)
+            slot = (slot + 1) & (size - 1);
+        if (declared[slot])
+        {
+            ir_remove(instr);
+            continue;
+        }
+        declared[slot] = instr->args[0];
+        program->code[out++] = *instr;
+    }
+
+    memcpy(&program->code[out], body, sizeof(IRInstruction) * rest);
+    program->count = out + rest;
+    free(declared);
+    free(body);
+}
+
+/**
+ * @brief Tells whether a function starts at the index (LABEL, CREATEFRAME, PUSHFRAME).
+ */
+bool ir_is_function_entry(const IRProgram *program, int index)
+{
+    return index + 2 < program->count && program->code[index].op == IR_LABEL &&
+           program->code[index + 1].op == IR_CREATEFRAME && program->code[index + 2].op == IR_PUSHFRAME;
+}
+
+/**
+ * @brief Finds the end of the part of the program starting at the index.
+ *
+ * @details The program is split at the function entries: the code in front of the first function
+ * is one part, every function is another. Local frame variables of different parts are unrelated
+ * even when their names are equal.
+ *
+ * @return Index of the next function entry, or the end of the program.
+ */
+int ir_function_end(const IRProgram *program, int start)
+{
+    int end = start + 1;
+    while (end < program->count && !ir_is_function_entry(program, end))
+        end++;
+    return end < program->count ? end : program->count;
+}
+
+// Moves the instruction to the end of the program (its operands change owner).
+static void ir_append_moved(IRProgram *program, IRInstruction instr)
+{
+    ir_reserve(program);
+    program->code[program->count++] = instr;
+}
+
+// Appends a comment line.
+static void ir_append_comment(IRProgram *program, const char *text)
+{
+    ir_append(program, IR_COMMENT, NULL, NULL, NULL);
+    program->code[program->count - 1].text = ir_copy(text);
+}
+
+/**
+ * @brief Writes the name to slot map of every function as a comment block after its label.
+ *
+ * @details The block lists the local frame variables by their slot:
+ * @code
+ * # @frame $name <number of slots>
+ * # @slot <index> LF@<variable>
+ * # @end
+ * @endcode
+ * Slots come from semantic analysis (parameters, variables and expression temporaries),
+ * variables introduced by the optimiser get the slots after them. Slots of variables removed
+ * by the optimiser stay unused, so the indices of the others do not change. The block is
+ * a comment, so the program stays valid IFJcode24. The annotated program is built in a new
+ * array in one pass, inserting the blocks in place would move the rest of the program each time.
+ *
+ * @param program Program to annotate (after all optimisation passes).
+ */
+void ir_annotate_frame_slots(IRProgram *program)
+{
+    IRProgram annotated = *program;
+    annotated.count = 0;
+    annotated.code = malloc(sizeof(IRInstruction) * annotated.capacity);
+    if (!annotated.code)
+        handle_error(ERR_COMPILER_INTERNAL);
+
+    for (int start = 0; start < program->count;)
+    {
+        if (!ir_is_function_entry(program, start))
+        {
+            ir_append_moved(&annotated, program->code[start++]);
+            continue;
+        }
+        int end = ir_function_end(program, start);
+
+        // Frame size given by the assigned slots, the rest is appended after them
+        int frameSize = 0;
+        int defvars = 0;
+        for (int i = start; i < end; i++)
+        {
+            IRInstruction *instr = &program->code[i];
+            if (instr->op != IR_DEFVAR || strncmp(instr->args[0], "LF@", 3) != 0)
+                continue;
+            defvars++;
+            if (instr->slot >= frameSize)
+                frameSize = instr->slot + 1;
+        }
+        const char **names = calloc(frameSize + defvars + 1, sizeof(char *));
+        if (!names)
+            handle_error(ERR_COMPILER_INTERNAL);
+        for (int i = start; i < end; i++)
+        {
+            IRInstruction *instr = &program->code[i];
+            if (instr->op != IR_DEFVAR || strncmp(instr->args[0], "LF@", 3) != 0)
+                continue;
+            if (instr->slot < 0 || names[instr->slot] != NULL)
+                instr->slot = frameSize++;
+            names[instr->slot] = instr->args[0];
+        }
+
+        char line[IR_LINE_BUFFER];
+        ir_append_moved(&annotated, program->code[start]);
+        snprintf(line, sizeof(line), "# @frame %s %d", program->code[start].args[0], frameSize);
+        ir_append_comment(&annotated, line);
+        for (int slot = 0; slot < frameSize; slot++)
+        {
+            if (names[slot] == NULL)
+                continue;
+            snprintf(line, sizeof(line), "# @slot %d %s", slot, names[slot]);
+            ir_append_comment(&annotated, line);
+        }
+        ir_append_comment(&annotated, "# @end");
+        free(names);
+        for (int i = start + 1; i < end; i++)
+            ir_append_moved(&annotated, program->code[i]);
+        start = end;
+    }
+
+    free(program->code);
+    *program = annotated;
+}
+
+/**
+ * @brief Takes the lowest free scratch register.
+ *
+ * @details The register stays live until ir_scratch_release(), so helpers of unrelated
+ * computations that are live at the same time never share a register, while helpers
+ * of consecutive computations do.
+ *
+ * @param program Program the register belongs to.
+ * @param buffer Receives the operand of the register (e.g. "GF@%r0").
+ * @param size Size of the buffer.
+ */
+void ir_scratch_acquire(IRProgram *program, char *buffer, size_t size)
+{
+    int reg = 0;
+    while (reg < IR_SCRATCH_MAX && program->scratchLive[reg])
+        reg++;
+    if (reg == IR_SCRATCH_MAX)
+        handle_error(ERR_COMPILER_INTERNAL);
+
+    program->scratchLive[reg] = true;
+    if (reg >= program->scratchCount)
+        program->scratchCount = reg + 1;
+    snprintf(buffer, size, "GF@%%r%d", reg);
+}
+
+/**
+ * @brief Returns the scratch register to the pool, its value is dead from now on.
+ */
+void ir_scratch_release(IRProgram *program, const char *reg)
+{
+    int index;
+    if (sscanf(reg, "GF@%%r%d", &index) == 1 && index >= 0 && index < IR_SCRATCH_MAX)
+        program->scratchLive[index] = false;
+}
+
+/**
+ * @brief Declares the used scratch registers right after the header.
+ */
+void ir_declare_scratch(IRProgram *program)
+{
+    int at = 0;
+    while (at < program->count && program->code[at].op != IR_HEADER)
+        at++;
+    at = at < program->count ? at + 1 : 0;
+
+    for (int reg = 0; reg < program->scratchCount; reg++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "GF@%%r%d", reg);
+        ir_insert(program, at + reg, IR_DEFVAR, name, NULL, NULL);
+    }
+}
+
+/**
+ * @brief Drops all IR_NOP instructions from the program.
+ */
+void ir_compact(IRProgram *program)
+{
+    int out = 0;
+    for (int i = 0; i < program->count; i++)
+    {
+        if (program->code[i].op != IR_NOP)
+            program->code[out++] = program->code[i];
+    }
+    program->count = out;
+}
+
+/**
+ * @brief Prints one instruction in the IFJcode24 text form, without the end of the line.
+ *
+ * @details IR_NOP prints nothing.
+ */
+void ir_print_instruction(const IRInstruction *instr, FILE *out)
+{
+    switch (instr->op)
+    {
+    case IR_NOP:
+        return;
+    case IR_COMMENT:
+    case IR_UNKNOWN:
+        fputs(instr->text, out);
+        return;
+    default:
+        break;
+    }
+    fputs(opcodeNames[instr->op], out);
+    for (int a = 0; a < instr->argc; a++)
+    {
+        fputc(' ', out);
+        fputs(instr->args[a] ? instr->args[a] : "", out);
+    }
+}
+
+/**
+ * @brief Prints the program in the IFJcode24 text form.
+ *
+ * @param program Program to print.
+ * @param out Output stream.
+ */
+void ir_print(const IRProgram *program, FILE *out)
+{
+    for (int i = 0; i < program->count; i++)
+    {
+        if (program->code[i].op == IR_NOP)
+            continue;
+        ir_print_instruction(&program->code[i], out);
+        fputc('\n', out);
+    }
+}
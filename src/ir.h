@@ -0,0 +1,172 @@
+/**
+ * @file ir.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Code generator
+ * @brief Intermediate representation of the generated IFJcode24 program.
+ *
+ * @details The code generator does not print instructions directly, it appends them
+ * to an IRProgram. Optimisation passes work over this list and the program is printed
+ * only after all of them finished.
+ */
+#ifndef IR_H
+#define IR_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ * @brief Opcodes of IFJcode24 instructions (plus a few pseudo instructions).
+ *
+ * Order of the real instructions follows the IFJcode24 specification.
+ */
+typedef enum
+{
+    IR_NOP,       // Removed instruction (skipped when printing)
+    IR_HEADER,    // .IFJcode24
+    IR_COMMENT,   // # comment line
+    IR_UNKNOWN,   // Instruction with unrecognised mnemonic (printed as is)
+
+    // Frames, function calls
+    IR_MOVE,
+    IR_CREATEFRAME,
+    IR_PUSHFRAME,
+    IR_POPFRAME,
+    IR_DEFVAR,
+    IR_CALL,
+    IR_RETURN,
+
+    // Data stack
+    IR_PUSHS,
+    IR_POPS,
+    IR_CLEARS,
+
+    // Arithmetic, relational, boolean and conversion instructions
+    IR_ADD,
+    IR_SUB,
+    IR_MUL,
+    IR_DIV,
+    IR_IDIV,
+    IR_ADDS,
+    IR_SUBS,
+    IR_MULS,
+    IR_DIVS,
+    IR_IDIVS,
+    IR_LT,
+    IR_GT,
+    IR_EQ,
+    IR_LTS,
+    IR_GTS,
+    IR_EQS,
+    IR_AND,
+    IR_OR,
+    IR_NOT,
+    IR_ANDS,
+    IR_ORS,
+    IR_NOTS,
+    IR_INT2FLOAT,
+    IR_FLOAT2INT,
+    IR_INT2CHAR,
+    IR_STRI2INT,
+    IR_INT2FLOATS,
+    IR_FLOAT2INTS,
+    IR_INT2CHARS,
+    IR_STRI2INTS,
+
+    // Input / output
+    IR_READ,
+    IR_WRITE,
+
+    // Strings
+    IR_CONCAT,
+    IR_STRLEN,
+    IR_GETCHAR,
+    IR_SETCHAR,
+
+    // Types
+    IR_TYPE,
+
+    // Program flow
+    IR_LABEL,
+    IR_JUMP,
+    IR_JUMPIFEQ,
+    IR_JUMPIFNEQ,
+    IR_JUMPIFEQS,
+    IR_JUMPIFNEQS,
+    IR_EXIT,
+
+    // Debugging
+    IR_BREAK,
+    IR_DPRINT,
+
+    IR_OPCODE_COUNT
+} IROpcode;
+
+#define IR_MAX_ARGS 3
+#define IR_SCRATCH_MAX 16
+
+/**
+ * @brief One instruction of the program.
+ *
+ * Operands are kept in their printed IFJcode24 form (e.g. "LF@a", "int@5", "$label").
+ * For IR_COMMENT and IR_UNKNOWN the whole line is stored in @c text.
+ * A DEFVAR of a frame variable carries the slot assigned by semantic analysis (-1 when unknown).
+ */
+typedef struct
+{
+    IROpcode op;
+    int argc;
+    char *args[IR_MAX_ARGS];
+    char *text;
+    int slot;
+} IRInstruction;
+
+/**
+ * @brief Growable array of instructions.
+ *
+ * Scratch registers GF@%r0 ... are helper variables of the generator that never hold a value
+ * across a CALL or a statement, so they are declared once in the global frame instead of
+ * in every frame. @c scratchLive marks the registers in use, @c scratchCount is the number
+ * of registers ever used.
+ */
+typedef struct IRProgram
+{
+    IRInstruction *code;
+    int count;
+    int capacity;
+    bool scratchLive[IR_SCRATCH_MAX];
+    int scratchCount;
+} IRProgram;
+
+// Program construction
+IRProgram *ir_create_program();
+void ir_free_program(IRProgram *program);
+void ir_append(IRProgram *program, IROpcode op, const char *arg1, const char *arg2, const char *arg3);
+void ir_emit_line(IRProgram *program, const char *line);
+void ir_emit(IRProgram *program, const char *fmt, ...);
+IRProgram *ir_read(FILE *in);
+
+// Helpers used by the optimisation passes
+const char *ir_opcode_name(IROpcode op);
+IROpcode ir_opcode_from_name(const char *name);
+bool ir_writes_first_arg(IROpcode op);
+bool ir_ends_block(IROpcode op);
+void ir_set_arg(IRInstruction *instr, int index, const char *value);
+void ir_replace(IRInstruction *instr, IROpcode op, const char *arg1, const char *arg2, const char *arg3);
+void ir_insert(IRProgram *program, int index, IROpcode op, const char *arg1, const char *arg2, const char *arg3);
+void ir_remove(IRInstruction *instr);
+void ir_compact(IRProgram *program);
+void ir_hoist_defvars(IRProgram *program, int from);
+bool ir_is_function_entry(const IRProgram *program, int index);
+int ir_function_end(const IRProgram *program, int start);
+void ir_annotate_frame_slots(IRProgram *program);
+
+// Scratch registers
+void ir_scratch_acquire(IRProgram *program, char *buffer, size_t size);
+void ir_scratch_release(IRProgram *program, const char *reg);
+void ir_declare_scratch(IRProgram *program);
+
+// Output
+void ir_print_instruction(const IRInstruction *instr, FILE *out);
+void ir_print(const IRProgram *program, FILE *out);
+
+#endif
@@ -0,0 +1,237 @@
+/**
+ * @file lexer_scan.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Lexical Analysis
+ * @brief Scanning of character runs for the lexer, 16 or 32 characters at a time.
+ */
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "lexer_scan.h"
+
+#if !defined(LEXER_SCALAR_SCAN) && (defined(__AVX2__) || defined(__SSE2__))
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+typedef __m256i Block;
+#define BLOCK_SIZE 32
+#define BLOCK_ALL 0xffffffffu
+
+static inline Block block_load(const char *text)
+{
+    return _mm256_loadu_si256((const __m256i *)text);
+}
+
+static inline Block block_set(char c)
+{
+    return _mm256_set1_epi8(c);
+}
+
+static inline Block block_eq(Block block, char c)
+{
+    return _mm256_cmpeq_epi8(block, block_set(c));
+}
+
+// Characters below c, compared as signed
+static inline Block block_below(Block block, char c)
+{
+    return _mm256_cmpgt_epi8(block_set(c), block);
+}
+
+// Characters above c, compared as signed
+static inline Block block_above(Block block, char c)
+{
+    return _mm256_cmpgt_epi8(block, block_set(c));
+}
+
+static inline Block block_or(Block a, Block b)
+{
+    return _mm256_or_si256(a, b);
+}
+
+static inline Block block_and(Block a, Block b)
+{
+    return _mm256_and_si256(a, b);
+}
+
+static inline unsigned block_mask(Block block)
+{
+    return (unsigned)_mm256_movemask_epi8(block);
+}
+#else
+#include <emmintrin.h>
+
+typedef __m128i Block;
+#define BLOCK_SIZE 16
+#define BLOCK_ALL 0xffffu
+
+static inline Block block_load(const char *text)
+{
+    return _mm_loadu_si128((const __m128i *)text);
+}
+
+static inline Block block_set(char c)
+{
+    return _mm_set1_epi8(c);
+}
+
+static inline Block block_eq(Block block, char c)
+{
+    return _mm_cmpeq_epi8(block, block_set(c));
+}
+
+// Characters below c, compared as signed
+static inline Block block_below(Block block, char c)
+{
+    return _mm_cmplt_epi8(block, block_set(c));
+}
+
+// Characters above c, compared as signed
+static inline Block block_above(Block block, char c)
+{
+    return _mm_cmpgt_epi8(block, block_set(c));
+}
+
+static inline Block block_or(Block a, Block b)
+{
+    return _mm_or_si128(a, b);
+}
+
+static inline Block block_and(Block a, Block b)
+{
+    return _mm_and_si128(a, b);
+}
+
+static inline unsigned block_mask(Block block)
+{
+    return (unsigned)_mm_movemask_epi8(block);
+}
+#endif
+
+// Bit i is set when character i of the block ends the run
+typedef unsigned (*StopMask)(Block block);
+
+static inline unsigned stop_blanks(Block block)
+{
+    return ~block_mask(block_or(block_eq(block, ' '), block_eq(block, '\t'))) & BLOCK_ALL;
+}
+
+static inline unsigned stop_comment(Block block)
+{
+    return block_mask(block_or(block_eq(block, '\n'), block_eq(block, (char)EOF)));
+}
+
+static inline Block block_digits(Block block)
+{
+    return block_and(block_above(block, '0' - 1), block_below(block, '9' + 1));
+}
+
+static inline unsigned stop_word(Block block)
+{
+    // Setting bit 5 turns the upper case letters into lower case ones and no other character into a letter
+    Block lower = block_or(block, block_set(0x20));
+    Block letters = block_and(block_above(lower, 'a' - 1), block_below(lower, 'z' + 1));
+    Block marks = block_or(block_eq(block, '_'), block_or(block_eq(block, '['), block_eq(block, ']')));
+    return ~block_mask(block_or(letters, block_or(block_digits(block), marks))) & BLOCK_ALL;
+}
+
+static inline unsigned stop_digits(Block block)
+{
+    return ~block_mask(block_digits(block)) & BLOCK_ALL;
+}
+
+static inline unsigned stop_string(Block block)
+{
+    return block_mask(block_or(block_below(block, 32), block_or(block_eq(block, '"'), block_eq(block, '\\'))));
+}
+
+// Length of the run, the blocks past the text are only read (see LEXER_SCAN_PADDING)
+static inline size_t scan_blocks(const char *text, size_t length, StopMask stop)
+{
+    for (size_t i = 0; i < length; i += BLOCK_SIZE)
+    {
+        unsigned mask = stop(block_load(text + i));
+        if (mask)
+        {
+            size_t end = i + (size_t)__builtin_ctz(mask);
+            return end < length ? end : length;
+        }
+    }
+    return length;
+}
+
+size_t scan_blanks(const char *text, size_t length)
+{
+    return scan_blocks(text, length, stop_blanks);
+}
+
+size_t scan_comment(const char *text, size_t length)
+{
+    return scan_blocks(text, length, stop_comment);
+}
+
+size_t scan_word(const char *text, size_t length)
+{
+    return scan_blocks(text, length, stop_word);
+}
+
+size_t scan_digits(const char *text, size_t length)
+{
+    return scan_blocks(text, length, stop_digits);
+}
+
+size_t scan_string(const char *text, size_t length)
+{
+    return scan_blocks(text, length, stop_string);
+}
+
+#else
+
+static bool is_word(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '[' ||
+           c == ']';
+}
+
+size_t scan_blanks(const char *text, size_t length)
+{
+    size_t i = 0;
+    while (i < length && (text[i] == ' ' || text[i] == '\t'))
+        i++;
+    return i;
+}
+
+size_t scan_comment(const char *text, size_t length)
+{
+    size_t i = 0;
+    while (i < length && text[i] != '\n' && text[i] != (char)EOF)
+        i++;
+    return i;
+}
+
+size_t scan_word(const char *text, size_t length)
+{
+    size_t i = 0;
+    while (i < length && is_word(text[i]))
+        i++;
+    return i;
+}
+
+size_t scan_digits(const char *text, size_t length)
+{
+    size_t i = 0;
+    while (i < length && text[i] >= '0' && text[i] <= '9')
+        i++;
+    return i;
+}
+
+size_t scan_string(const char *text, size_t length)
+{
+    size_t i = 0;
+    while (i < length && text[i] >= 32 && text[i] != '"' && text[i] != '\\')
+        i++;
+    return i;
+}
+
+#endif
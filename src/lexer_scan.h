@@ -0,0 +1,31 @@
+/**
+ * @file lexer_scan.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Lexical Analysis
+ * @brief Scanning of character runs for the lexer, 16 or 32 characters at a time.
+ *
+ * @details Each function returns the length of the run at the start of text, at most length. The
+ * runs are the ones the lexer consumes character by character otherwise: blanks in front of a
+ * token, the rest of a comment, the characters of an identifier or keyword, digits and the plain
+ * characters of a string literal. The characters are compared as the lexer compares its char
+ * (signed), so bytes from 0x80 up end every run but a comment, and 0xff, which the lexer takes for
+ * EOF, ends a comment too.
+ *
+ * With SSE2 (every x86-64) or AVX2 (make LEXER_SIMD=avx2) the functions compare a whole block at
+ * once, LEXER_SIMD=scalar selects the plain loops. The blocks may be read past text + length, the
+ * caller has to keep LEXER_SCAN_PADDING readable bytes after the text.
+ */
+#ifndef LEXER_SCAN_H
+#define LEXER_SCAN_H
+
+#include <stddef.h>
+
+#define LEXER_SCAN_PADDING 32
+
+size_t scan_blanks(const char *text, size_t length);
+size_t scan_comment(const char *text, size_t length);
+size_t scan_word(const char *text, size_t length);
+size_t scan_digits(const char *text, size_t length);
+size_t scan_string(const char *text, size_t length);
+
+#endif
@@ -5,8 +5,13 @@
  * @brief Implementation of the lexical analyser, including token processing and utility functions.
  */
 
+#include <limits.h>
+
 #include "lexical_analyser.h"
 #include "newstring.h"
+#include "literal_pool.h"
+#include "time_report.h"
+#include "lexer_scan.h"
 
 /**
  * @def KEYWORD_COUNT
@@ -53,16 +58,23 @@ const char *keywords[KEYWORD_COUNT] = {
  * @see Keyword
  */
 bool is_keyword(Token *token)
+{
+    Keyword keyword = keyword_lookup(token->value.valueString.str);
+    if (keyword == KEYWORD_NONE)
+        return false; // It is not a keyword
+
+    token->keyword_val = keyword; // Set the keyword value
+    return true;                  // It is a keyword
+}
+
+Keyword keyword_lookup(const char *text)
 {
     for (int i = 0; i < KEYWORD_COUNT; i++)
     {
-        if (strcmp(token->value.valueString.str, keywords[i]) == 0)
-        {
-            token->keyword_val = (Keyword)i; // Set the keyword value
-            return true;                     // It is a keyword
-        }
+        if (strcmp(text, keywords[i]) == 0)
+            return (Keyword)i;
     }
-    return false; // It is not a keyword
+    return KEYWORD_NONE;
 }
 
 /**
@@ -224,7 +236,185 @@ void validate_identifier(const char *str)
 }
 
 /**
- * @brief Retrieves the next token from the input file.
+ * @brief Value of a number literal, accumulated digit by digit while the literal is scanned.
+ */
+typedef struct
+{
+    unsigned long long mantissa; // Significant digits
+    int digits;                  // Number of digits in the mantissa
+    int scale;                   // Power of ten of the last digit of the mantissa
+    int exponent;                // Value of the exponent part, without the sign
+    bool negativeExponent;       // The exponent part starts with '-'
+    bool truncated;              // Digits did not fit into the mantissa
+} NumberScan;
+
+// More digits may overflow the mantissa
+#define NUMBER_MAX_DIGITS 19
+
+// Powers of ten represented exactly by a double
+static const double exactPowersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                          1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                          1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+static void number_add_digit(NumberScan *number, char c, bool fraction)
+{
+    if (number->digits == 0 && c == '0') // Leading zeros are not significant
+    {
+        if (fraction)
+            number->scale--;
+        return;
+    }
+    if (number->digits < NUMBER_MAX_DIGITS)
+    {
+        number->mantissa = number->mantissa * 10 + (unsigned long long)(c - '0');
+        number->digits++;
+        if (fraction)
+            number->scale--;
+        return;
+    }
+    number->truncated = true;
+    if (!fraction)
+        number->scale++;
+}
+
+static void number_add_exponent_digit(NumberScan *number, char c)
+{
+    if (number->exponent < 100000) // Far beyond the range of double already
+        number->exponent = number->exponent * 10 + (c - '0');
+}
+
+/**
+ * @brief Computes the value of a scanned float literal.
+ *
+ * @details Fast path (Clinger): a mantissa of at most 2^53 and a power of ten of at most 10^22 are
+ * both exact doubles, so a single multiplication or division rounds the result correctly. Other
+ * literals (long mantissas, large exponents) are converted by strtod().
+ *
+ * @param number Digits accumulated by the lexer.
+ * @param text Text of the literal, used by the slow path.
+ * @return The correctly rounded value.
+ */
+static double number_float_value(const NumberScan *number, const char *text)
+{
+    int exponent = number->scale + (number->negativeExponent ? -number->exponent : number->exponent);
+    if (!number->truncated && number->mantissa <= (1ULL << 53))
+    {
+        if (number->mantissa == 0)
+            return 0.0;
+        if (exponent >= 0 && exponent <= 22)
+            return (double)number->mantissa * exactPowersOfTen[exponent];
+        if (exponent < 0 && exponent >= -22)
+            return (double)number->mantissa / exactPowersOfTen[-exponent];
+    }
+    return strtod(text, NULL);
+}
+
+/**
+ * @brief Computes the value of a scanned integer literal (saturated like strtoll()).
+ */
+static long long number_int_value(const NumberScan *number, const char *text)
+{
+    if (!number->truncated && number->mantissa <= (unsigned long long)LLONG_MAX)
+        return (long long)number->mantissa;
+    return strtoll(text, NULL, 10);
+}
+
+// Characters read from the stream at a time
+#define LEXER_BUFFER_SIZE 65536
+
+/**
+ * @brief Input of the lexer, the stream is read in blocks.
+ *
+ * @details The characters of a block are taken one by one like from getc(), and the runs inside
+ * a block (blanks, comments, identifiers, digits, plain characters of strings) at once with the
+ * scanners of lexer_scan.c. The padding keeps the blocks they read past the end of the buffer
+ * inside of it.
+ */
+typedef struct
+{
+    FILE *file;      // Stream the buffer is filled from, the one get_token() was given
+    long offset;     // Position of buffer[0] in the stream
+    size_t position; // Next character
+    size_t length;   // Characters in the buffer
+    char buffer[LEXER_BUFFER_SIZE + LEXER_SCAN_PADDING];
+} LexerInput;
+
+static _Thread_local LexerInput input;
+
+/**
+ * @brief Starts lexing the stream from its current position.
+ *
+ * @details The lexer reads ahead of the token it returns and keeps the characters read ahead until
+ * this is called again, whatever stream get_token() is given. Every parse of a source has to start
+ * here, a stream is not told from another by its address (a new stream may reuse the address of a
+ * closed one).
+ *
+ * @param file The stream, nothing else may read it until its last token.
+ */
+void lexer_begin(FILE *file)
+{
+    long offset = file ? ftell(file) : 0;
+    input.file = file;
+    input.offset = offset > 0 ? offset : 0;
+    input.position = 0;
+    input.length = 0;
+}
+
+/**
+ * @brief Returns the position in the stream started by lexer_begin() after the last token, ftell()
+ * of the unbuffered lexer.
+ */
+long lexer_position()
+{
+    return input.offset + (long)input.position;
+}
+
+// Reads the next block, false at the end of the stream
+static bool input_fill()
+{
+    input.offset += (long)input.length;
+    input.position = 0;
+    input.length = fread(input.buffer, 1, LEXER_BUFFER_SIZE, input.file);
+    return input.length > 0;
+}
+
+// Next character like getc()
+static inline int input_getc()
+{
+    if (input.position == input.length && !input_fill())
+        return EOF;
+    return (unsigned char)input.buffer[input.position++];
+}
+
+// Returns the character just read like ungetc(), EOF (and the character 0xff, read as EOF) is not returned
+static inline void input_ungetc(int c)
+{
+    if (c != EOF)
+        input.position--;
+}
+
+/**
+ * @brief Takes the run of characters at the input position and appends it to the token.
+ *
+ * @details The run ends at the end of the block, the caller continues with the next character.
+ *
+ * @param text Text of the token.
+ * @param scan Scanner of the run (lexer_scan.h).
+ * @param length Receives the length of the run.
+ * @return Start of the run in the buffer.
+ */
+static const char *input_take_run(Dynamic_string *text, size_t (*scan)(const char *, size_t), size_t *length)
+{
+    const char *run = input.buffer + input.position;
+    *length = scan(run, input.length - input.position);
+    if (!dynamic_string_add_text(text, run, *length))
+        handle_error(ERR_COMPILER_INTERNAL);
+    input.position += *length;
+    return run;
+}
+
+/**
+ * @brief Scans the next token from the input file.
  * @details This function implements a finite state machine (FSM) to parse the input file character by character,
  * constructing tokens based on the defined states. It handles various token types, including identifiers,
  * keywords, literals, operators, and punctuation.
@@ -236,7 +426,7 @@ void validate_identifier(const char *str)
  * @see Token
  * @see State
  */
-Token get_token(FILE *file)
+static Token scan_token(FILE *file)
 {
 
     Token token; // Initialize token
@@ -248,6 +438,7 @@ Token get_token(FILE *file)
         return token;           // Return EOF token
     }
     state = sStart;
+    input.file = file; // The buffer is dropped only by lexer_begin()
 
     if (!dynamic_string_init(&token.value.valueString)) // Initialize dynamic string
     {
@@ -256,17 +447,19 @@ Token get_token(FILE *file)
 
     char c;               // Character variable for reading input
     bool invalid = false; // Flag for invalid tokens
+    NumberScan number = {0};  // Value of a number literal
 
     while (1)
     {
         token.keyword_val = 0; // Reset keyword value
-        c = (char)getc(file);
+        c = (char)input_getc();
 
         switch (state) // State machine
         {
         case sStart:                   // Initial state
             if (c == ' ' || c == '\t') // Ignore whitespace
             {
+                input.position += scan_blanks(input.buffer + input.position, input.length - input.position);
                 state = sStart; // Stay in start state
             }
             else if (c == EOF)
@@ -293,7 +486,7 @@ Token get_token(FILE *file)
             {
                 dynamic_string_add_char(&token.value.valueString, c);
 
-                char next_c = (char)getc(file);
+                char next_c = (char)input_getc();
 
                 // If the next character is a letter or a digit, treat it as part of an identifier
                 if (isalnum(next_c))
@@ -320,6 +513,7 @@ Token get_token(FILE *file)
             {
                 state = sIntLiteral; // Start reading an integer literal
                 dynamic_string_add_char(&token.value.valueString, c);
+                number_add_digit(&number, c, false);
             }
             else if (c == '\"') // Start of string literal
             {
@@ -358,16 +552,16 @@ Token get_token(FILE *file)
             {
                 dynamic_string_add_char(&token.value.valueString, c);
 
-                c = (char)getc(file); // Read next char
+                c = (char)input_getc(); // Read next char
                 if (c == ']')
                 {
                     state = sIdentifierorKeyword;
-                    ungetc(c, file);
+                    input_ungetc(c);
                 }
                 else
                 {
                     token.type = TOKEN_LEFT_BRACKET;
-                    ungetc(c, file);
+                    input_ungetc(c);
                     return token;
                 }
             }
@@ -486,10 +680,12 @@ Token get_token(FILE *file)
                     break;
                 }
                 dynamic_string_add_char(&token.value.valueString, c);
-                c = (char)getc(file);
+                size_t run;
+                input_take_run(&token.value.valueString, scan_word, &run); // The rest of the run at once
+                c = (char)input_getc();
             }
 
-            ungetc(c, file);
+            input_ungetc(c);
 
             if (is_keyword(&token))
             {
@@ -537,6 +733,11 @@ Token get_token(FILE *file)
             if (isdigit(c))
             {
                 dynamic_string_add_char(&token.value.valueString, c);
+                number_add_digit(&number, c, false);
+                size_t run;
+                const char *digits = input_take_run(&token.value.valueString, scan_digits, &run);
+                for (size_t i = 0; i < run; i++)
+                    number_add_digit(&number, digits[i], false);
                 state = sIntLiteral;
             }
             else if (c == '.')
@@ -552,8 +753,10 @@ Token get_token(FILE *file)
             else
             {
                 token.type = TOKEN_INT_LITERAL;
+                literal_pool_add_int(token.value.valueString.str,
+                                     number_int_value(&number, token.value.valueString.str));
                 state = sStart;
-                ungetc(c, file);
+                input_ungetc(c);
                 return token;
             }
         }
@@ -563,6 +766,7 @@ Token get_token(FILE *file)
             if (isdigit(c))
             {
                 dynamic_string_add_char(&token.value.valueString, c);
+                number_add_digit(&number, c, true);
                 state = sFloatLiteral;
             }
             else
@@ -577,6 +781,11 @@ Token get_token(FILE *file)
             if (isdigit(c))
             {
                 dynamic_string_add_char(&token.value.valueString, c);
+                number_add_digit(&number, c, true);
+                size_t run;
+                const char *digits = input_take_run(&token.value.valueString, scan_digits, &run);
+                for (size_t i = 0; i < run; i++)
+                    number_add_digit(&number, digits[i], true);
                 state = sFloatLiteral;
             }
             else if (c == 'e' || c == 'E')
@@ -587,7 +796,9 @@ Token get_token(FILE *file)
             else
             {
                 token.type = TOKEN_FLOAT_LITERAL;
-                ungetc(c, file);
+                literal_pool_add_float(token.value.valueString.str,
+                                       number_float_value(&number, token.value.valueString.str));
+                input_ungetc(c);
                 return token;
             }
         }
@@ -597,11 +808,13 @@ Token get_token(FILE *file)
             if (c == '+' || c == '-')
             {
                 dynamic_string_add_char(&token.value.valueString, c);
+                number.negativeExponent = c == '-';
                 state = sExponentSign;
             }
             else if (isdigit(c))
             {
                 dynamic_string_add_char(&token.value.valueString, c);
+                number_add_exponent_digit(&number, c);
                 state = sExponent;
             }
             else
@@ -616,6 +829,7 @@ Token get_token(FILE *file)
             if (isdigit(c))
             {
                 dynamic_string_add_char(&token.value.valueString, c);
+                number_add_exponent_digit(&number, c);
                 state = sExponent;
             }
             else
@@ -630,16 +844,22 @@ Token get_token(FILE *file)
             if (isdigit(c))
             {
                 dynamic_string_add_char(&token.value.valueString, c);
+                number_add_exponent_digit(&number, c);
+                size_t run;
+                const char *digits = input_take_run(&token.value.valueString, scan_digits, &run);
+                for (size_t i = 0; i < run; i++)
+                    number_add_exponent_digit(&number, digits[i]);
                 state = sExponent;
             }
             else
             {
-                // Attempt to parse the number, checking for integer or float
-                double calculatedNum = strtod(token.value.valueString.str, NULL);
+                // Compute the number, checking for integer or float
+                double calculatedNum = number_float_value(&number, token.value.valueString.str);
                 dynamic_string_clear(&token.value.valueString);
 
-                // Check if it's a valid integer (i.e., no fractional part)
-                if (calculatedNum == (long long)calculatedNum)
+                // Check if it's a valid integer (i.e., no fractional part), the cast is defined only
+                // within the range of long long
+                if (calculatedNum >= -0x1p63 && calculatedNum < 0x1p63 && calculatedNum == (long long)calculatedNum)
                 {
                     // If the number is an integer (even with an exponent), treat it as an integer
                     long long intVal = (long long)calculatedNum;
@@ -649,6 +869,7 @@ Token get_token(FILE *file)
                         handle_error(ERR_LEX);
                     }
                     token.type = TOKEN_INT_LITERAL;
+                    literal_pool_add_int(token.value.valueString.str, intVal);
                 }
                 else
                 {
@@ -659,9 +880,10 @@ Token get_token(FILE *file)
                         handle_error(ERR_LEX);
                     }
                     token.type = TOKEN_FLOAT_LITERAL;
+                    literal_pool_add_float(token.value.valueString.str, calculatedNum);
                 }
 
-                ungetc(c, file);
+                input_ungetc(c);
                 return token;
             }
         }
@@ -675,6 +897,7 @@ Token get_token(FILE *file)
             else if (c == '"') // End of string literal
             {
                 token.type = TOKEN_STRING_LITERAL;
+                literal_pool_add_string(token.value.valueString.str); // Rendered once per distinct literal
                 return token;
             }
             else if (c < 32) // Check for invalid characters in string
@@ -685,6 +908,8 @@ Token get_token(FILE *file)
             else // Add character to string literal
             {
                 dynamic_string_add_char(&token.value.valueString, c); // Add character to token
+                size_t run;
+                input_take_run(&token.value.valueString, scan_string, &run); // Up to the next '"', '\\' or control character
             }
         }
         break;
@@ -711,8 +936,8 @@ Token get_token(FILE *file)
             {
                 // Converting \xdd from hex to real numer
                 char hex[3];
-                hex[0] = (char)getc(file);
-                hex[1] = (char)getc(file);
+                hex[0] = (char)input_getc();
+                hex[1] = (char)input_getc();
                 hex[2] = '\0';
 
                 if (isxdigit(hex[0]) && isxdigit(hex[1]))
@@ -745,7 +970,7 @@ Token get_token(FILE *file)
             }
             else
             {
-                ungetc(c, file);             // Put back the character if it's not '/'
+                input_ungetc(c);             // Put back the character if it's not '/'
                 token.type = TOKEN_DIVISION; // Token is just '/' (division)
                 return token;
             }
@@ -756,7 +981,9 @@ Token get_token(FILE *file)
             while (c != '\n' && c != EOF) // Consume until end of line
             {
                 dynamic_string_add_char(&token.value.valueString, c);
-                c = (char)getc(file);
+                size_t run;
+                input_take_run(&token.value.valueString, scan_comment, &run); // Up to the end of the line or of the block
+                c = (char)input_getc();
             }
             state = sStart; // Return to starting state after comment
             token.type = TOKEN_COMMENT;
@@ -773,7 +1000,7 @@ Token get_token(FILE *file)
             }
             else
             {
-                ungetc(c, file);               // Put back the character if it's not '='
+                input_ungetc(c);               // Put back the character if it's not '='
                 token.type = TOKEN_ASSIGNMENT; // Token is just '=' (assignment)
             }
             state = sStart; // Return to the starting state
@@ -789,7 +1016,7 @@ Token get_token(FILE *file)
             }
             else
             {
-                ungetc(c, file);                // Put back the character if it's not '='
+                input_ungetc(c);                // Put back the character if it's not '='
                 token.type = TOKEN_EXCLAMATION; // Token is just '!'
             }
             return token;
@@ -805,7 +1032,7 @@ Token get_token(FILE *file)
             }
             else
             {
-                ungetc(c, file);              // Put back the character if it's not '='
+                input_ungetc(c);              // Put back the character if it's not '='
                 token.type = TOKEN_LESS_THAN; // Token is just '<'
             }
             state = sStart; // Return to the starting state
@@ -821,7 +1048,7 @@ Token get_token(FILE *file)
             }
             else
             {
-                ungetc(c, file);                 // Put back the character if it's not '='
+                input_ungetc(c);                 // Put back the character if it's not '='
                 token.type = TOKEN_GREATER_THAN; // Token is just '>'
             }
             state = sStart; // Return to the starting state
@@ -837,7 +1064,7 @@ Token get_token(FILE *file)
             }
             else
             {
-                ungetc(c, file);
+                input_ungetc(c);
                 if (strcmp(token.value.valueString.str, "@import") == 0)
                     token.type = TOKEN_IMPORT;
                 else
@@ -858,3 +1085,22 @@ Token get_token(FILE *file)
     dynamic_string_free(&token.value.valueString);
     return token;
 }
+
+/**
+ * @brief Returns the next token, see scan_token().
+ * @details With --time-report the time spent in the lexer is charged to the lex phase.
+ *
+ * @param file A pointer to the file being analyzed.
+ * @return The next token extracted from the file.
+ */
+Token get_token(FILE *file)
+{
+    time_report_count(COUNTER_TOKENS, 1);
+    if (!timeReportActive)
+        return scan_token(file);
+
+    CompilerPhase outer = time_report_switch(PHASE_LEX);
+    Token token = scan_token(file);
+    time_report_switch(outer);
+    return token;
+}
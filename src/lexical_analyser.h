@@ -239,6 +239,11 @@ typedef enum
  */
 typedef enum
 {
+    /**
+     * @brief Not a keyword.
+     */
+    KEYWORD_NONE = -1,
+
     /**
      * @brief Represents the `if` keyword.
      *
@@ -458,6 +463,13 @@ typedef struct
  */
 const char *token_type_to_string(Token_type type);
 
+/**
+ * @brief Finds the keyword spelled by a string.
+ * @param text The string to look up.
+ * @return The keyword, or KEYWORD_NONE.
+ */
+Keyword keyword_lookup(const char *text);
+
 /**
  * @brief Prints the details of a token.
  * @param token The token to print.
@@ -471,6 +483,19 @@ void print_token(Token token);
  */
 Token get_token(FILE *file);
 
+/**
+ * @brief Starts lexing the stream from its current position, drops the characters read ahead.
+ * @details Has to be called before the first token of every parse.
+ * @param file The stream to read from.
+ */
+void lexer_begin(FILE *file);
+
+/**
+ * @brief Returns the position in the stream started by lexer_begin() after the last token.
+ * @return The position, like ftell() without the characters read ahead.
+ */
+long lexer_position();
+
 /**
  * @brief Converts a token type to its corresponding string representation.
  *
@@ -0,0 +1,270 @@
+/**
+ * @file literal_pool.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Lexical Analysis
+ * @brief Constant pool of the int, float and string literals of the program.
+ */
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "literal_pool.h"
+#include "error.h"
+
+#define LITERAL_POOL_INITIAL_CAPACITY 64
+
+typedef struct
+{
+    Token_type type;     // TOKEN_INT_LITERAL, TOKEN_FLOAT_LITERAL or TOKEN_STRING_LITERAL
+    char *text;          // Token text (decoded value of a string), the operand of a float entry
+    char *operand;       // IFJcode24 operand, NULL for the text of a float
+    int entry;           // Entry the text stands for, the literal itself except for the text of a float
+    long long intValue;  // Value of an int literal
+    double floatValue;   // Value of a float literal
+    unsigned long hash;  // Hash of the type and the text
+} Literal;
+
+// Entries in the order of addition, the table maps hashes to entry indices (-1 when empty).
+// Float literals are keyed by their value: the entry of a float has its operand as the text, and
+// every token text of a float ("1.5", "1.50") is a literal of its own pointing to that entry.
+// Every thread has its own pool for its own compilation.
+static _Thread_local Literal *literals = NULL;
+static _Thread_local int literalCount = 0;
+static _Thread_local int literalCapacity = 0;
+static _Thread_local int *table = NULL;
+static _Thread_local int tableSize = 0;
+
+// djb2 seeded by the type, equal texts of different types are different literals
+static unsigned long literal_hash(Token_type type, const char *text)
+{
+    unsigned long hash = 5381 + (unsigned long)type;
+    for (const unsigned char *c = (const unsigned char *)text; *c; c++)
+        hash = hash * 33 + *c;
+    return hash;
+}
+
+// Slot of the literal in the table, or of the empty slot where it belongs
+static int literal_slot(Token_type type, const char *text, unsigned long hash)
+{
+    int slot = (int)(hash & (unsigned long)(tableSize - 1));
+    while (table[slot] != -1)
+    {
+        const Literal *literal = &literals[table[slot]];
+        if (literal->hash == hash && literal->type == type && strcmp(literal->text, text) == 0)
+            break;
+        slot = (slot + 1) & (tableSize - 1);
+    }
+    return slot;
+}
+
+// Keeps the table at most half full
+static void literal_pool_grow()
+{
+    if (literalCount == literalCapacity)
+    {
+        int newCapacity = literalCapacity ? literalCapacity * 2 : LITERAL_POOL_INITIAL_CAPACITY;
+        Literal *newLiterals = realloc(literals, sizeof(Literal) * newCapacity);
+        if (!newLiterals)
+            handle_error(ERR_COMPILER_INTERNAL);
+        literals = newLiterals;
+        literalCapacity = newCapacity;
+    }
+    if (2 * (literalCount + 1) <= tableSize)
+        return;
+
+    free(table);
+    tableSize = tableSize ? tableSize * 2 : 2 * LITERAL_POOL_INITIAL_CAPACITY;
+    table = malloc(sizeof(int) * tableSize);
+    if (!table)
+        handle_error(ERR_COMPILER_INTERNAL);
+    for (int i = 0; i < tableSize; i++)
+        table[i] = -1;
+    for (int i = 0; i < literalCount; i++)
+        table[literal_slot(literals[i].type, literals[i].text, literals[i].hash)] = i;
+}
+
+/**
+ * @brief Encodes a string as an IFJcode24 operand.
+ *
+ * @details Characters 0 - 32, '#' and '\\' are written as an escape sequence \\ddd with the decimal code,
+ * the other characters are copied.
+ *
+ * @param decoded Value of the string.
+ * @return Newly allocated operand "string@...".
+ */
+char *literal_encode(const char *decoded)
+{
+    size_t length = strlen("string@");
+    for (const unsigned char *c = (const unsigned char *)decoded; *c; c++)
+        length += (*c <= 32 || *c == '#' || *c == '\\') ? 4 : 1;
+
+    char *operand = malloc(length + 1);
+    if (!operand)
+        handle_error(ERR_COMPILER_INTERNAL);
+
+    char *out = operand + sprintf(operand, "string@");
+    for (const unsigned char *c = (const unsigned char *)decoded; *c; c++)
+    {
+        if (*c <= 32 || *c == '#' || *c == '\\')
+            out += sprintf(out, "\\%03d", *c);
+        else
+            *out++ = (char)*c;
+    }
+    *out = '\0';
+    return operand;
+}
+
+// Adds the literal unless its text is already known, the operand is rendered by the caller only for new texts
+static int literal_pool_insert(Token_type type, const char *text, const char *operand, long long intValue,
+                               double floatValue)
+{
+    literal_pool_grow();
+
+    unsigned long hash = literal_hash(type, text);
+    int slot = literal_slot(type, text, hash);
+    if (table[slot] != -1)
+        return literals[table[slot]].entry;
+
+    Literal *literal = &literals[literalCount];
+    literal->type = type;
+    literal->text = malloc(strlen(text) + 1);
+    if (!literal->text)
+        handle_error(ERR_COMPILER_INTERNAL);
+    strcpy(literal->text, text);
+    literal->operand = NULL;
+    literal->entry = literalCount;
+    literal->intValue = intValue;
+    literal->floatValue = floatValue;
+    literal->hash = hash;
+
+    if (type == TOKEN_STRING_LITERAL)
+        literal->operand = literal_encode(text);
+    else if (operand)
+    {
+        literal->operand = malloc(strlen(operand) + 1);
+        if (!literal->operand)
+            handle_error(ERR_COMPILER_INTERNAL);
+        strcpy(literal->operand, operand);
+    }
+    table[slot] = literalCount;
+    return literalCount++;
+}
+
+/**
+ * @brief Adds a string literal, identical literals share one entry.
+ *
+ * @param decoded Value of the literal with the escape sequences already decoded.
+ * @return Index of the entry.
+ */
+int literal_pool_add_string(const char *decoded)
+{
+    return literal_pool_insert(TOKEN_STRING_LITERAL, decoded, NULL, 0, 0.0);
+}
+
+/**
+ * @brief Adds an int literal with the value computed by the lexer.
+ *
+ * @param text Text of the token.
+ * @param value Value of the literal.
+ * @return Index of the entry.
+ */
+int literal_pool_add_int(const char *text, long long value)
+{
+    int entry = literal_pool_find(TOKEN_INT_LITERAL, text);
+    if (entry != -1)
+        return entry;
+
+    char operand[32];
+    snprintf(operand, sizeof(operand), "int@%lld", value);
+    return literal_pool_insert(TOKEN_INT_LITERAL, text, operand, value, (double)value);
+}
+
+// Value of a float as an int, truncated, out of range values saturate (a plain cast is undefined there)
+static long long float_to_int(double value)
+{
+    if (value >= 0x1p63)
+        return LLONG_MAX;
+    if (value < -0x1p63)
+        return LLONG_MIN;
+    return value == value ? (long long)value : 0;
+}
+
+/**
+ * @brief Adds a float literal with the value computed by the lexer.
+ *
+ * @details Texts of the same value ("1.5", "1.50", "15e-1") share one entry, keyed by the
+ * rendered operand.
+ *
+ * @param text Text of the token.
+ * @param value Value of the literal.
+ * @return Index of the entry.
+ */
+int literal_pool_add_float(const char *text, double value)
+{
+    int entry = literal_pool_find(TOKEN_FLOAT_LITERAL, text);
+    if (entry != -1)
+        return entry;
+
+    char operand[64];
+    snprintf(operand, sizeof(operand), "float@%a", value);
+    entry = literal_pool_insert(TOKEN_FLOAT_LITERAL, operand, operand, float_to_int(value), value);
+    int alias = literal_pool_insert(TOKEN_FLOAT_LITERAL, text, NULL, 0, 0.0);
+    literals[alias].entry = entry;
+    return entry;
+}
+
+/**
+ * @brief Looks up the entry of a literal.
+ *
+ * @return Index of the entry, or -1 when the literal was never added (or the type is not a literal).
+ */
+int literal_pool_find(Token_type type, const char *text)
+{
+    if (!table || !text ||
+        (type != TOKEN_INT_LITERAL && type != TOKEN_FLOAT_LITERAL && type != TOKEN_STRING_LITERAL))
+        return -1;
+    int literal = table[literal_slot(type, text, literal_hash(type, text))];
+    return literal == -1 ? -1 : literals[literal].entry;
+}
+
+/**
+ * @brief Returns the IFJcode24 operand of the entry.
+ */
+const char *literal_pool_operand(int index)
+{
+    return literals[index].operand;
+}
+
+/**
+ * @brief Returns the value of an int literal (a float literal is truncated and saturated, a string gives 0).
+ */
+long long literal_pool_int(int index)
+{
+    return literals[index].intValue;
+}
+
+/**
+ * @brief Returns the value of a float literal (an int literal is converted, a string gives 0).
+ */
+double literal_pool_float(int index)
+{
+    return literals[index].floatValue;
+}
+
+/**
+ * @brief Frees all entries, the pool can be filled again afterwards.
+ */
+void literal_pool_free()
+{
+    for (int i = 0; i < literalCount; i++)
+    {
+        free(literals[i].text);
+        free(literals[i].operand);
+    }
+    free(literals);
+    free(table);
+    literals = NULL;
+    table = NULL;
+    literalCount = literalCapacity = tableSize = 0;
+}
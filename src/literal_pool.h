@@ -0,0 +1,31 @@
+/**
+ * @file literal_pool.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Lexical Analysis
+ * @brief Constant pool of the int, float and string literals of the program.
+ *
+ * @details The lexer adds every literal it reads, numbers with the value it computed while
+ * scanning them. The pool keeps each distinct literal once (floats of the same value, e.g. 1.5
+ * and 1.50, are one literal), together with its value and its IFJcode24 operand rendered when
+ * the literal is added: "int@" with the decimal value, "float@" in the exact %a form and
+ * "string@" with white space, '#', '\\' and control characters written as \\ddd. AST nodes of
+ * literals refer to their entry by index, so semantic analysis reads the value and the code
+ * generator copies the rendered operand instead of parsing or formatting the text again.
+ */
+#ifndef LITERAL_POOL_H
+#define LITERAL_POOL_H
+
+#include "lexical_analyser.h"
+
+int literal_pool_add_string(const char *decoded);
+int literal_pool_add_int(const char *text, long long value);
+int literal_pool_add_float(const char *text, double value);
+int literal_pool_find(Token_type type, const char *text);
+const char *literal_pool_operand(int index);
+long long literal_pool_int(int index);
+double literal_pool_float(int index);
+void literal_pool_free();
+
+char *literal_encode(const char *decoded);
+
+#endif
@@ -4,49 +4,249 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "lexical_analyser.h"
-#include "syntactic_analysis.h"
-#include <error.h>
-#include "ast.h"
+#include "compiler.h"
+#include "vm.h"
+#include "server.h"
+#include "batch.h"
+#include "cache.h"
+#include "literal_pool.h"
+#include "intern.h"
 #include "semantic.h"
-#include "symtable.h"
-#include "Code_generator.h"
+#include "time_report.h"
+
+/**
+ * @brief Executes the program in the built-in interpreter and reports the counters.
+ *
+ * @param program Program to run, freed afterwards.
+ * @param profilePath File receiving the execution profile (NULL when not profiling).
+ * @return Exit code of the program, or the error code of the interpreter.
+ */
+static int runProgram(IRProgram *program, const char *profilePath)
+{
+    VMStats vmStats;
+    Profile *profile = profilePath ? profile_create() : NULL;
+    int result = vm_run(program, stdin, stdout, &vmStats, profile);
+    ir_free_program(program);
+
+    if (profile)
+    {
+        bool saved = profile_save(profile, profilePath);
+        profile_free(profile);
+        if (!saved)
+        {
+            fprintf(stderr, "Cannot write profile %s\n", profilePath);
+            return ERR_FILE;
+        }
+    }
+
+    vm_print_stats(&vmStats, stderr);
+    if (result != VM_OK)
+    {
+        fprintf(stderr, "vm: runtime error %d\n", result);
+        return result;
+    }
+    return vmStats.exitCode;
+}
+
+/**
+ * @brief Parses a size in bytes with an optional K, M or G suffix.
+ *
+ * @return False when the text is not a positive size.
+ */
+static bool parseSize(const char *text, long long *bytes)
+{
+    char *end;
+    long long value = strtoll(text, &end, 10);
+    int shift = *end == 'K' ? 10 : *end == 'M' ? 20 : *end == 'G' ? 30 : 0;
+    if (end == text || value <= 0 || (shift ? end[1] : end[0]) != '\0')
+        return false;
+    *bytes = value << shift;
+    return true;
+}
 
 int main(int argc, char **argv)
 {
-    FILE *file;
-    BinaryTreeNode *root = createBinaryNode(NODE_GENERAL, TOKEN_EMPTY, "");
-    setStartNode(root);
+    FILE *file = stdin;
+    const char *fileName = NULL;
+    char **files = malloc((size_t)argc * sizeof(char *)); // Source files of a batch
+    int fileCount = 0;
+    int jobs = -1;                      // Threads of a batch (-j N, 0 for one per CPU), -1 without -j
+    const char *manifest = NULL;        // File listing the sources of a batch
+    bool optReport = false;
+    bool run = false;       // Execute the generated code in the built-in interpreter
+    bool interpret = false; // Input is IFJcode24, execute it
+    const char *profileGenerate = NULL; // Run the program and save its profile here
+    const char *profileUse = NULL;      // Optimise with the profile from this file
+    int timeReport = 0;                 // Per-phase report: 1 as a table, 2 as JSON
+    const char *serverSocket = NULL;    // Serve compile requests on this socket (server.c)
+    const char *cacheDirectory = getenv("IFJ_CACHE_DIR"); // Cache of the results (cache.c)
+    long long cacheSize = CACHE_DEFAULT_MAX_BYTES;
+    bool pipeline = false; // Lex on a thread of its own (token_pipeline.c)
+
+    // Options first, then an optional source file (stdin is used without it)
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--opt-report") == 0)
+            optReport = true;
+        else if (strcmp(argv[i], "--run") == 0)
+            run = true;
+        else if (strcmp(argv[i], "--interpret") == 0)
+            interpret = true;
+        else if (strcmp(argv[i], "--profile-generate") == 0 && i + 1 < argc)
+            profileGenerate = argv[++i];
+        else if (strcmp(argv[i], "--profile-use") == 0 && i + 1 < argc)
+            profileUse = argv[++i];
+        else if (strcmp(argv[i], "--pipeline") == 0)
+            pipeline = true;
+        else if (strcmp(argv[i], "--time-report") == 0)
+            timeReport = 1;
+        else if (strcmp(argv[i], "--time-report=json") == 0)
+            timeReport = 2;
+        else if (strcmp(argv[i], "--server") == 0 && i + 1 < argc)
+            serverSocket = argv[++i];
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc && isdigit((unsigned char)argv[i + 1][0]))
+            jobs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--manifest") == 0 && i + 1 < argc)
+            manifest = argv[++i];
+        else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+            cacheDirectory = argv[++i];
+        else if (strcmp(argv[i], "--no-cache") == 0)
+            cacheDirectory = NULL;
+        else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc && parseSize(argv[i + 1], &cacheSize))
+            i++;
+        else if (files && argv[i][0] != '-')
+            files[fileCount++] = argv[i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [--opt-report] [--time-report[=json]] [--pipeline] [--run | --interpret] "
+                            "[--profile-generate file] [--profile-use file] "
+                            "[--cache dir [--cache-size bytes[K|M|G]] | --no-cache] [filename]\n"
+                            "       %s -j N [--cache dir] [--manifest file] [filename...]\n"
+                            "       %s --server socket\n", argv[0], argv[0], argv[0]);
+            return 99;
+        }
+    }
+    if (!files)
+        return ERR_COMPILER_INTERNAL;
+
+    if (serverSocket)
+        return server_run(serverSocket);
 
-    // Check if file was entered as an argument
-    if (argc < 2)
-        file = stdin;
-    if (argc == 2)
-        file = fopen(argv[1], "r");
-    else
+    // Only plain compilation is cached, the other modes do more than print the program
+    CompileCache cache;
+    bool cached = cacheDirectory && !(run || interpret || optReport || timeReport || profileGenerate || profileUse);
+    if (cached && !cache_open(&cache, cacheDirectory, cacheSize))
     {
-        fprintf(stderr, "Usage: %s <filename>\n", argv[0]);
-        return 99;
+        fprintf(stderr, "Cannot open cache %s, compiling without it\n", cacheDirectory);
+        cached = false;
     }
 
-    // // Syntactic analysis
-    if (!FIRST(file))
+    // Many files: compile them in parallel, dir/name.ext to dir/name.ifjcode (batch.c)
+    if (jobs >= 0 || manifest || fileCount > 1)
     {
-        fprintf(stderr, "%s", " --- WRONG END --- \n");
-        // WRONG
-        fclose(file);
-        handle_error(ERR_SYNTAX);
+        if (run || interpret || optReport || timeReport || profileGenerate || profileUse)
+        {
+            fprintf(stderr, "A batch (-j, --manifest) is only compiled\n");
+            return 99;
+        }
+        if (manifest)
+        {
+            free(files);
+            files = batch_read_manifest(manifest, &fileCount);
+            if (!files)
+            {
+                fprintf(stderr, "Cannot open file %s\n", manifest);
+                return 99;
+            }
+        }
+        int result = batch_compile(files, fileCount, jobs < 0 ? 0 : jobs, cached ? &cache : NULL, stdout);
+        if (cached)
+            cache_close(&cache);
+        if (manifest)
+        {
+            for (int i = 0; i < fileCount; i++)
+                free(files[i]);
+        }
+        free(files);
+        return result;
     }
+    if (fileCount == 1)
+        fileName = files[0];
+    free(files);
 
-    //printBinaryTree(root);
+    if (fileName)
+    {
+        file = fopen(fileName, "r");
+        if (!file)
+        {
+            fprintf(stderr, "Cannot open file %s\n", fileName);
+            return 99;
+        }
+    }
+
+    // A hit prints the stored result without lexing the source
+    if (cached)
+    {
+        size_t length;
+        char *source = compiler_read_source(file, &length);
+        if (file != stdin)
+            fclose(file);
+        if (!source)
+            return ERR_FILE;
+        CompilerContext context = {.pipelinedLexer = pipeline};
+        int result = cache_compile(&cache, &context, source, length, stdout, NULL);
+        free(source);
+        cache_close(&cache);
+        return result;
+    }
+
+    if (interpret)
+    {
+        IRProgram *program = ir_read(file);
+        if (file != stdin)
+            fclose(file);
+        return runProgram(program, profileGenerate);
+    }
 
-    SymbolStack *stack = initialize_symbol_stack();
-    ProcessTree(root, stack);
-    free_symbol_stack(stack);
+    // Profile of an earlier --profile-generate run
+    Profile *profile = NULL;
+    if (profileUse)
+    {
+        profile = profile_load(profileUse);
+        if (!profile)
+        {
+            fprintf(stderr, "Cannot read profile %s\n", profileUse);
+            return ERR_FILE;
+        }
+    }
 
-    // generator skusky
-    processTokenType(root);
+    if (timeReport)
+        time_report_start();
 
+    CompilerContext context = {.pipelinedLexer = pipeline};
+    OptimizerStats stats;
+    IRProgram *program = compile_program(&context, file, &stats, profile, profileGenerate != NULL);
+    if (timeReport == 1)
+        time_report_print(stderr);
+    else if (timeReport == 2)
+        time_report_print_json(stderr);
+    literal_pool_free();
+    intern_free();
+    semantic_free();
+    if (optReport)
+    {
+        print_optimizer_stats(&stats, stderr);
+        if (profile)
+            profile_print_hot_calls(profile, stderr, 5);
+    }
+    profile_free(profile);
     fclose(file);
+
+    // Profiling needs the program to be executed
+    if (run || profileGenerate)
+        return runProgram(program, profileGenerate);
+
+    ir_print(program, stdout);
+    ir_free_program(program);
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,35 @@
+/**
+ * @file malloc_wrap.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief Allocation counting for --time-report.
+ *
+ * @details The compiler is linked with -Wl,--wrap=malloc (and calloc, realloc), so the calls
+ * from its own object files come here and are charged to the current phase. Allocations made
+ * inside the C library (stdio buffers) are not counted.
+ */
+#include <stdlib.h>
+
+#include "time_report.h"
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    time_report_allocation(size);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    time_report_allocation(count * size);
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size)
+{
+    time_report_allocation(size);
+    return __real_realloc(pointer, size);
+}
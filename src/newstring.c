@@ -5,6 +5,7 @@
  * @brief This file contains functions for working with string literal
  */
 #include "newstring.h"
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -55,6 +56,28 @@ bool dynamic_string_add_char(Dynamic_string *s, char c)
     return true;              // Successfully added the character
 }
 
+// Add length characters of text to the dynamic string, the size grows at least twice (long comments)
+bool dynamic_string_add_text(Dynamic_string *s, const char *text, size_t length)
+{
+    if (s->length + length >= s->alloc_size)
+    {
+        size_t new_size = 2 * s->alloc_size + DYNAMIC_STRING_LEN_INC;
+        if (new_size < s->length + length + 1)
+            new_size = s->length + length + 1;
+        char *new_str = (char *)realloc(s->str, new_size);
+        if (new_str == NULL)
+        {
+            return false; // Memory reallocation failed
+        }
+        s->str = new_str;
+        s->alloc_size = new_size;
+    }
+    memcpy(s->str + s->length, text, length);
+    s->length += length;
+    s->str[s->length] = '\0';
+    return true;
+}
+
 // Function to convert double to Dynamic_string
 bool add_double_to_dynamic_string(Dynamic_string *s, double value)
 {
@@ -63,16 +86,16 @@ bool add_double_to_dynamic_string(Dynamic_string *s, double value)
     // Convert the double to string using %.15g for maximum precision and shortest representation
     snprintf(buffer, sizeof(buffer), "%.15g", value);
 
-    // Check if the value has a fractional part
-    if (value == (int)value)
+    // Check if the value has a fractional part (the cast is defined only within the range of int)
+    if (value >= INT_MIN && value <= INT_MAX && value == (int)value)
     {
         // If it's an integer, remove the decimal point
         snprintf(buffer, sizeof(buffer), "%.0f", value);
     }
     else
     {
-        // Otherwise, use the standard formatting
-        snprintf(buffer, sizeof(buffer), "%.6f", value); // Or %.15g for shorter representation
+        // Otherwise, use enough digits to read back the same double
+        snprintf(buffer, sizeof(buffer), "%.17g", value);
     }
 
     // Add each character of the string to the dynamic string
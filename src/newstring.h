@@ -26,6 +26,7 @@ typedef struct
 bool dynamic_string_init(Dynamic_string *s);
 void dynamic_string_free(Dynamic_string *s);
 bool dynamic_string_add_char(Dynamic_string *s, char c);
+bool dynamic_string_add_text(Dynamic_string *s, const char *text, size_t length);
 bool add_double_to_dynamic_string(Dynamic_string *s, double value);
 void dynamic_string_clear(Dynamic_string *s);
 char dynamic_string_first_char(const Dynamic_string *s);
@@ -0,0 +1,931 @@
+/**
+ * @file optimizer.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Code generator
+ * @brief Optimisation passes over the intermediate representation.
+ */
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "optimizer.h"
+#include "error.h"
+#include "context.h"
+
+#define NAME_MAP_INITIAL 64
+
+/**
+ * @brief Open addressing map from variable names to a counter and an optional name.
+ */
+typedef struct
+{
+    const char *key;
+    const char *value;
+    int count;
+} NameEntry;
+
+typedef struct
+{
+    NameEntry *entries;
+    int capacity;
+    int used;
+} NameMap;
+
+/**
+ * @brief Value number table entry: result of @c op applied to @c a and @c b lives in @c dst.
+ */
+typedef struct
+{
+    IROpcode op;
+    const char *a;
+    const char *b;
+    const char *dst;
+} ValueEntry;
+
+typedef struct
+{
+    ValueEntry *entries;
+    int count;
+    int capacity;
+} ValueTable;
+
+// FNV-1a hash of the variable name
+static unsigned long name_hash(const char *str)
+{
+    unsigned long hash = 2166136261u;
+    while (*str)
+    {
+        hash ^= (unsigned char)*str++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void name_map_init(NameMap *map)
+{
+    map->capacity = NAME_MAP_INITIAL;
+    map->used = 0;
+    map->entries = calloc(map->capacity, sizeof(NameEntry));
+    if (!map->entries)
+        handle_error(ERR_COMPILER_INTERNAL);
+}
+
+static void name_map_free(NameMap *map)
+{
+    free(map->entries);
+    map->entries = NULL;
+    map->capacity = map->used = 0;
+}
+
+// Returns the slot of the key, inserting it when it is missing.
+static NameEntry *name_map_get(NameMap *map, const char *key, bool insert)
+{
+    if (insert && (map->used + 1) * 2 > map->capacity)
+    {
+        NameMap grown;
+        grown.capacity = map->capacity * 2;
+        grown.used = 0;
+        grown.entries = calloc(grown.capacity, sizeof(NameEntry));
+        if (!grown.entries)
+            handle_error(ERR_COMPILER_INTERNAL);
+        for (int i = 0; i < map->capacity; i++)
+        {
+            if (map->entries[i].key)
+                *name_map_get(&grown, map->entries[i].key, true) = map->entries[i];
+        }
+        free(map->entries);
+        *map = grown;
+    }
+
+    unsigned long index = name_hash(key) & (unsigned long)(map->capacity - 1);
+    while (map->entries[index].key)
+    {
+        if (strcmp(map->entries[index].key, key) == 0)
+            return &map->entries[index];
+        index = (index + 1) & (unsigned long)(map->capacity - 1);
+    }
+    if (!insert)
+        return NULL;
+    map->entries[index].key = key;
+    map->used++;
+    return &map->entries[index];
+}
+
+// Pure instructions of the form OP dst a [b] whose result depends only on the operands.
+static bool is_pure_computation(IROpcode op)
+{
+    switch (op)
+    {
+    case IR_ADD:
+    case IR_SUB:
+    case IR_MUL:
+    case IR_DIV:
+    case IR_IDIV:
+    case IR_LT:
+    case IR_GT:
+    case IR_EQ:
+    case IR_AND:
+    case IR_OR:
+    case IR_NOT:
+    case IR_INT2FLOAT:
+    case IR_FLOAT2INT:
+    case IR_INT2CHAR:
+    case IR_STRI2INT:
+    case IR_CONCAT:
+    case IR_STRLEN:
+    case IR_GETCHAR:
+    case IR_TYPE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool is_commutative(IROpcode op)
+{
+    return op == IR_ADD || op == IR_MUL || op == IR_EQ || op == IR_AND || op == IR_OR;
+}
+
+static bool same_operand(const char *a, const char *b)
+{
+    if (!a || !b)
+        return a == b;
+    return strcmp(a, b) == 0;
+}
+
+// Drops every value that was computed from (or stored into) the variable.
+static void value_table_kill(ValueTable *table, const char *var)
+{
+    int out = 0;
+    for (int i = 0; i < table->count; i++)
+    {
+        ValueEntry *entry = &table->entries[i];
+        if (same_operand(entry->a, var) || same_operand(entry->b, var) || same_operand(entry->dst, var))
+            continue;
+        table->entries[out++] = *entry;
+    }
+    table->count = out;
+}
+
+static void value_table_add(ValueTable *table, IROpcode op, const char *a, const char *b, const char *dst)
+{
+    if (table->count == table->capacity)
+    {
+        table->capacity = table->capacity ? table->capacity * 2 : 16;
+        ValueEntry *grown = realloc(table->entries, sizeof(ValueEntry) * table->capacity);
+        if (!grown)
+            handle_error(ERR_COMPILER_INTERNAL);
+        table->entries = grown;
+    }
+    table->entries[table->count++] = (ValueEntry){op, a, b, dst};
+}
+
+static ValueEntry *value_table_find(ValueTable *table, IROpcode op, const char *a, const char *b)
+{
+    for (int i = table->count - 1; i >= 0; i--)
+    {
+        ValueEntry *entry = &table->entries[i];
+        if (entry->op == op && same_operand(entry->a, a) && same_operand(entry->b, b))
+            return entry;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Local value numbering over basic blocks.
+ *
+ * @details Inside one basic block every pure computation is keyed by its opcode and
+ * operands (ordered for commutative operators). When the same key is computed again into
+ * a variable that is assigned exactly once in its function, the instruction is turned into
+ * IR_NOP and all later reads of that variable are redirected to the first result. The DEFVAR
+ * of the redirected variable is removed as well. Values are invalidated when any of their
+ * operands is written and the table is cleared at block boundaries.
+ *
+ * @param program Program to optimise.
+ * @param from Index of the first instruction of the function (see ir_function_end()).
+ * @param to Index after its last instruction.
+ * @return Number of removed instructions.
+ */
+static int local_cse_function(IRProgram *program, int from, int to)
+{
+    NameMap defs;   // variable -> number of instructions writing it
+    NameMap alias;  // removed variable -> variable holding the same value
+    ValueTable table = {NULL, 0, 0};
+    int removed = 0;
+
+    name_map_init(&defs);
+    name_map_init(&alias);
+
+    for (int i = from; i < to; i++)
+    {
+        IRInstruction *instr = &program->code[i];
+        if (ir_writes_first_arg(instr->op) && instr->args[0])
+            name_map_get(&defs, instr->args[0], true)->count++;
+    }
+
+    for (int i = from; i < to; i++)
+    {
+        IRInstruction *instr = &program->code[i];
+        bool writes = ir_writes_first_arg(instr->op);
+
+        // Redirect reads of removed variables
+        if (alias.used > 0 && instr->op != IR_DEFVAR)
+        {
+            for (int a = (writes && instr->op != IR_SETCHAR) ? 1 : 0; a < instr->argc; a++)
+            {
+                NameEntry *entry = instr->args[a] ? name_map_get(&alias, instr->args[a], false) : NULL;
+                if (entry && entry->value)
+                    ir_set_arg(instr, a, entry->value);
+            }
+        }
+
+        if (ir_ends_block(instr->op))
+        {
+            table.count = 0;
+            continue;
+        }
+
+        if (!writes || !instr->args[0])
+            continue;
+
+        const char *dst = instr->args[0];
+        const char *a = instr->args[1];
+        const char *b = instr->args[2];
+        bool pure = is_pure_computation(instr->op);
+
+        if (pure && is_commutative(instr->op) && a && b && strcmp(a, b) > 0)
+        {
+            const char *tmp = a;
+            a = b;
+            b = tmp;
+        }
+
+        if (pure)
+        {
+            ValueEntry *known = value_table_find(&table, instr->op, a, b);
+            NameEntry *dstDefs = name_map_get(&defs, dst, false);
+            NameEntry *knownDefs = known ? name_map_get(&defs, known->dst, false) : NULL;
+            if (known && dstDefs && dstDefs->count == 1 && knownDefs && knownDefs->count == 1)
+            {
+                NameEntry *entry = name_map_get(&alias, dst, true);
+                entry->value = known->dst;
+                // The instruction is kept as NOP so the alias key stays allocated until the end
+                instr->op = IR_NOP;
+                removed++;
+                continue;
+            }
+        }
+
+        value_table_kill(&table, dst);
+        if (pure && !same_operand(dst, a) && !same_operand(dst, b))
+            value_table_add(&table, instr->op, a, b, dst);
+    }
+
+    // Declarations of the redirected variables are not needed any more
+    for (int i = from; i < to; i++)
+    {
+        IRInstruction *instr = &program->code[i];
+        if (instr->op == IR_DEFVAR && alias.used > 0 && instr->args[0])
+        {
+            NameEntry *entry = name_map_get(&alias, instr->args[0], false);
+            if (entry && entry->value)
+            {
+                ir_remove(instr);
+                removed++;
+            }
+        }
+    }
+
+    for (int i = from; i < to; i++)
+    {
+        if (program->code[i].op == IR_NOP)
+            ir_remove(&program->code[i]);
+    }
+
+    free(table.entries);
+    name_map_free(&defs);
+    name_map_free(&alias);
+    return removed;
+}
+
+/**
+ * @brief Local value numbering over basic blocks, function by function.
+ *
+ * @details Local frame variables of different functions are unrelated, so the assignments
+ * of a variable are counted in its function only (see local_cse_function()).
+ *
+ * @param program Program to optimise.
+ * @return Number of removed instructions.
+ */
+int optimize_local_cse(IRProgram *program)
+{
+    int removed = 0;
+    for (int start = 0; start < program->count;)
+    {
+        int end = ir_function_end(program, start);
+        removed += local_cse_function(program, start, end);
+        start = end;
+    }
+    ir_compact(program);
+    return removed;
+}
+
+// Value kinds of operands, used to tell integer division from float division
+typedef enum
+{
+    KIND_NONE,
+    KIND_INT,
+    KIND_FLOAT,
+    KIND_STRING,
+    KIND_BOOL,
+    KIND_MIXED
+} OperandKind;
+
+static bool is_int_literal(const char *operand, long long *value)
+{
+    if (!operand || strncmp(operand, "int@", 4) != 0)
+        return false;
+    char *end;
+    long long parsed = strtoll(operand + 4, &end, 0);
+    if (*end != '\0' || end == operand + 4)
+        return false;
+    if (value)
+        *value = parsed;
+    return true;
+}
+
+static bool is_float_literal(const char *operand, double *value)
+{
+    if (!operand || strncmp(operand, "float@", 6) != 0)
+        return false;
+    char *end;
+    double parsed = strtod(operand + 6, &end);
+    if (*end != '\0' || end == operand + 6)
+        return false;
+    if (value)
+        *value = parsed;
+    return true;
+}
+
+static bool is_variable(const char *operand)
+{
+    return operand && (strncmp(operand, "LF@", 3) == 0 || strncmp(operand, "GF@", 3) == 0 ||
+                       strncmp(operand, "TF@", 3) == 0);
+}
+
+static OperandKind kind_join(OperandKind a, OperandKind b)
+{
+    if (a == KIND_NONE)
+        return b;
+    if (b == KIND_NONE || a == b)
+        return a;
+    return KIND_MIXED;
+}
+
+static OperandKind operand_kind(NameMap *kinds, const char *operand)
+{
+    if (!operand)
+        return KIND_NONE;
+    if (strncmp(operand, "int@", 4) == 0)
+        return KIND_INT;
+    if (strncmp(operand, "float@", 6) == 0)
+        return KIND_FLOAT;
+    if (strncmp(operand, "string@", 7) == 0)
+        return KIND_STRING;
+    if (strncmp(operand, "bool@", 5) == 0)
+        return KIND_BOOL;
+    if (strncmp(operand, "nil@", 4) == 0)
+        return KIND_MIXED;
+    NameEntry *entry = name_map_get(kinds, operand, false);
+    return entry ? (OperandKind)entry->count : KIND_NONE;
+}
+
+// Kind of the value the instruction stores into its first operand
+static OperandKind result_kind(NameMap *kinds, const IRInstruction *instr)
+{
+    switch (instr->op)
+    {
+    case IR_MOVE:
+        return operand_kind(kinds, instr->args[1]);
+    case IR_ADD:
+    case IR_SUB:
+    case IR_MUL:
+    case IR_DIV:
+        return kind_join(operand_kind(kinds, instr->args[1]), operand_kind(kinds, instr->args[2]));
+    case IR_IDIV:
+    case IR_FLOAT2INT:
+    case IR_STRI2INT:
+    case IR_STRLEN:
+        return KIND_INT;
+    case IR_INT2FLOAT:
+        return KIND_FLOAT;
+    case IR_LT:
+    case IR_GT:
+    case IR_EQ:
+    case IR_AND:
+    case IR_OR:
+    case IR_NOT:
+        return KIND_BOOL;
+    case IR_INT2CHAR:
+    case IR_CONCAT:
+    case IR_GETCHAR:
+    case IR_SETCHAR:
+    case IR_TYPE:
+        return KIND_STRING;
+    case IR_READ:
+        if (instr->args[1] && strcmp(instr->args[1], "int") == 0)
+            return KIND_INT;
+        if (instr->args[1] && strcmp(instr->args[1], "float") == 0)
+            return KIND_FLOAT;
+        return KIND_MIXED;
+    default:
+        return KIND_MIXED;
+    }
+}
+
+/**
+ * @brief Infers the kind of every variable from all instructions writing it.
+ *
+ * @details Flow insensitive: a variable written with values of different kinds (or by POPS,
+ * whose value is unknown) is KIND_MIXED. The kind is kept in the count field of the map.
+ * Only the instructions from..to-1 (one function) are considered.
+ */
+static void infer_kinds(IRProgram *program, int from, int to, NameMap *kinds)
+{
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (int i = from; i < to; i++)
+        {
+            IRInstruction *instr = &program->code[i];
+            if (!ir_writes_first_arg(instr->op) || !instr->args[0])
+                continue;
+            NameEntry *entry = name_map_get(kinds, instr->args[0], true);
+            OperandKind joined = kind_join((OperandKind)entry->count, result_kind(kinds, instr));
+            if (joined != (OperandKind)entry->count)
+            {
+                entry->count = joined;
+                changed = true;
+            }
+        }
+    }
+}
+
+// Strength reduction of the instructions from..to-1 of one function
+static void strength_reduction_function(IRProgram *program, int from, int to, OptimizerStats *stats)
+{
+    NameMap kinds;
+    name_map_init(&kinds);
+    infer_kinds(program, from, to, &kinds);
+
+    for (int i = from; i < to; i++)
+    {
+        IRInstruction *instr = &program->code[i];
+        long long intValue;
+        double floatValue;
+        char literal[64];
+
+        switch (instr->op)
+        {
+        case IR_DIV:
+            if (operand_kind(&kinds, instr->args[1]) == KIND_INT && operand_kind(&kinds, instr->args[2]) == KIND_INT)
+            {
+                instr->op = IR_IDIV;
+                stats->divisionsSpecialised++;
+                if (is_int_literal(instr->args[2], &intValue) && intValue == 1)
+                {
+                    ir_replace(instr, IR_MOVE, instr->args[0], instr->args[1], NULL);
+                    stats->strengthReduced++;
+                }
+            }
+            break;
+        case IR_IDIV:
+            if (is_int_literal(instr->args[2], &intValue) && intValue == 1)
+            {
+                ir_replace(instr, IR_MOVE, instr->args[0], instr->args[1], NULL);
+                stats->strengthReduced++;
+            }
+            break;
+        case IR_MUL:
+        {
+            int constant = is_int_literal(instr->args[2], &intValue) ? 2 : is_int_literal(instr->args[1], &intValue) ? 1 : 0;
+            if (!constant || intValue < 0 || intValue > 2)
+                break;
+            const char *other = instr->args[3 - constant];
+            if (intValue == 0 && operand_kind(&kinds, other) != KIND_INT)
+                break; // x * 0 of a float (or an unknown kind) keeps the kind of x
+            if (intValue == 0)
+                ir_replace(instr, IR_MOVE, instr->args[0], "int@0", NULL);
+            else if (intValue == 1)
+                ir_replace(instr, IR_MOVE, instr->args[0], other, NULL);
+            else
+                ir_replace(instr, IR_ADD, instr->args[0], other, other);
+            stats->strengthReduced++;
+            break;
+        }
+        case IR_INT2FLOAT:
+            if (is_int_literal(instr->args[1], &intValue))
+            {
+                snprintf(literal, sizeof(literal), "float@%a", (double)intValue);
+                ir_replace(instr, IR_MOVE, instr->args[0], literal, NULL);
+                stats->conversionsFolded++;
+            }
+            break;
+        case IR_FLOAT2INT:
+            if (is_float_literal(instr->args[1], &floatValue) && floatValue > (double)LLONG_MIN &&
+                floatValue < (double)LLONG_MAX)
+            {
+                snprintf(literal, sizeof(literal), "int@%lld", (long long)floatValue);
+                ir_replace(instr, IR_MOVE, instr->args[0], literal, NULL);
+                stats->conversionsFolded++;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    name_map_free(&kinds);
+}
+
+/**
+ * @brief Strength reduction of single instructions.
+ *
+ * @details
+ * - DIV of two integer operands becomes IDIV (IFJcode24 DIV works with floats only),
+ * - multiplication by integer 0, 1 and 2 becomes MOVE or ADD (by 0 only when the other operand is an
+ *   integer), integer division by 1 becomes MOVE,
+ * - INT2FLOAT and FLOAT2INT of literals are folded into MOVE of the converted literal.
+ *
+ * IFJcode24 has no shift instructions, so other powers of two are left as MUL/IDIV.
+ * The kinds of the variables are inferred for every function on its own.
+ *
+ * @param program Program to optimise.
+ * @param stats Counters to update.
+ */
+void optimize_strength_reduction(IRProgram *program, OptimizerStats *stats)
+{
+    for (int start = 0; start < program->count;)
+    {
+        int end = ir_function_end(program, start);
+        strength_reduction_function(program, start, end, stats);
+        start = end;
+    }
+}
+
+// Step of an induction variable update "var = var + step" (ADD/SUB with an integer literal)
+static bool induction_step(const IRInstruction *instr, const char *var, long long *step)
+{
+    long long value;
+    if (instr->op == IR_ADD && same_operand(instr->args[1], var) && is_int_literal(instr->args[2], &value))
+        *step = value;
+    else if (instr->op == IR_ADD && same_operand(instr->args[2], var) && is_int_literal(instr->args[1], &value))
+        *step = value;
+    else if (instr->op == IR_SUB && same_operand(instr->args[1], var) && is_int_literal(instr->args[2], &value))
+        *step = -value;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * @brief Finds the single update of the variable inside the loop.
+ *
+ * @details Accepts both "ADD v v c" and the generator's form "ADD t v c; MOVE v t".
+ *
+ * @return Index of the instruction after which the variable holds its new value, -1 if the
+ * variable is not an induction variable of the loop.
+ */
+static int find_induction_update(IRProgram *program, int start, int end, const char *var, long long *step)
+{
+    int update = -1;
+    for (int i = start; i < end; i++)
+    {
+        IRInstruction *instr = &program->code[i];
+        if (ir_writes_first_arg(instr->op) && same_operand(instr->args[0], var))
+        {
+            if (update != -1)
+                return -1;
+            update = i;
+        }
+    }
+    if (update == -1)
+        return -1;
+
+    IRInstruction *instr = &program->code[update];
+    if (induction_step(instr, var, step))
+        return update;
+    if (instr->op != IR_MOVE || !is_variable(instr->args[1]))
+        return -1;
+
+    // MOVE v t, where t = v + c is computed once in the loop
+    const char *temp = instr->args[1];
+    int tempDef = -1;
+    for (int i = start; i < end; i++)
+    {
+        IRInstruction *other = &program->code[i];
+        if (ir_writes_first_arg(other->op) && same_operand(other->args[0], temp))
+        {
+            if (tempDef != -1)
+                return -1;
+            tempDef = i;
+        }
+    }
+    if (tempDef == -1 || tempDef > update || !induction_step(&program->code[tempDef], var, step))
+        return -1;
+    return update;
+}
+
+// Loop body may only contain straight-line code after the exit test
+static bool is_simple_loop(IRProgram *program, int start, int end)
+{
+    for (int i = start + 1; i < end; i++)
+    {
+        switch (program->code[i].op)
+        {
+        case IR_LABEL:
+        case IR_CALL:
+        case IR_RETURN:
+        case IR_CREATEFRAME:
+        case IR_PUSHFRAME:
+        case IR_POPFRAME:
+        case IR_JUMP:
+        case IR_UNKNOWN:
+            return false;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Positions of the labels of the program, built once per pass (the pass inserts its
+ * instructions only at the end, see PendingInsertions).
+ */
+typedef struct
+{
+    NameMap labels;       // Label name -> index of its LABEL instruction (in count)
+    int *firstTargetFrom; // Lowest index of a label targeted by a jump at or after the position
+} LabelIndex;
+
+static bool is_jump(IROpcode op)
+{
+    return op == IR_JUMP || op == IR_JUMPIFEQ || op == IR_JUMPIFNEQ;
+}
+
+// Builds the index in one pass over the program, the loop search then needs no scanning
+static void label_index_build(LabelIndex *index, IRProgram *program)
+{
+    name_map_init(&index->labels);
+    for (int i = 0; i < program->count; i++)
+    {
+        if (program->code[i].op == IR_LABEL)
+            name_map_get(&index->labels, program->code[i].args[0], true)->count = i;
+    }
+
+    index->firstTargetFrom = malloc(sizeof(int) * (program->count + 1));
+    if (!index->firstTargetFrom)
+        handle_error(ERR_COMPILER_INTERNAL);
+    index->firstTargetFrom[program->count] = program->count;
+    for (int i = program->count - 1; i >= 0; i--)
+    {
+        int first = index->firstTargetFrom[i + 1];
+        if (is_jump(program->code[i].op))
+        {
+            NameEntry *label = name_map_get(&index->labels, program->code[i].args[0], false);
+            if (label && label->count < first)
+                first = label->count;
+        }
+        index->firstTargetFrom[i] = first;
+    }
+}
+
+// Index of the label, or -1 when the program has none of that name
+static int label_index_find(LabelIndex *index, const char *label)
+{
+    NameEntry *entry = name_map_get(&index->labels, label, false);
+    return entry ? entry->count : -1;
+}
+
+// True when some later backward jump re-enters code before the loop (the loop is nested)
+static bool is_nested_loop(LabelIndex *index, int start, int end)
+{
+    return index->firstTargetFrom[end + 1] < start;
+}
+
+/**
+ * @brief Instructions to insert into the program, all at once at the end of a pass.
+ *
+ * @details Inserting in place moves the rest of the program and the positions the pass has found,
+ * so the pass collects the instructions and merges them into the program in one pass.
+ */
+typedef struct
+{
+    int before; // Index of the instruction of the program it goes before
+    int rank;   // Order among the instructions going before the same index
+    int added;  // Index in PendingInsertions.added, orders the instructions of one rank
+} PendingPlace;
+
+typedef struct
+{
+    IRProgram *added; // The instructions, in the order they were added
+    PendingPlace *places;
+} PendingInsertions;
+
+static int compare_places(const void *a, const void *b)
+{
+    const PendingPlace *x = a, *y = b;
+    if (x->before != y->before)
+        return x->before < y->before ? -1 : 1;
+    if (x->rank != y->rank)
+        return x->rank < y->rank ? -1 : 1;
+    return (x->added > y->added) - (x->added < y->added);
+}
+
+/**
+ * @brief Adds an instruction to insert before the index.
+ *
+ * @param rank Order among the instructions going before the same index, lower first.
+ */
+static void pending_insert(PendingInsertions *pending, int before, int rank, IROpcode op, const char *arg1,
+                           const char *arg2, const char *arg3)
+{
+    if (!pending->added)
+        pending->added = ir_create_program();
+    ir_append(pending->added, op, arg1, arg2, arg3);
+    int count = pending->added->count;
+    PendingPlace *places = realloc(pending->places, sizeof(PendingPlace) * count);
+    if (!places)
+        handle_error(ERR_COMPILER_INTERNAL);
+    pending->places = places;
+    pending->places[count - 1] = (PendingPlace){before, rank, count - 1};
+}
+
+// Merges the pending instructions into the program, the program owns their operands afterwards
+static void pending_apply(PendingInsertions *pending, IRProgram *program)
+{
+    if (!pending->added)
+        return;
+    int count = pending->added->count;
+    qsort(pending->places, count, sizeof(PendingPlace), compare_places);
+
+    IRInstruction *code = malloc(sizeof(IRInstruction) * (program->count + count));
+    if (!code)
+        handle_error(ERR_COMPILER_INTERNAL);
+    int out = 0, next = 0;
+    for (int i = 0; i <= program->count; i++)
+    {
+        for (; next < count && pending->places[next].before == i; next++)
+            code[out++] = pending->added->code[pending->places[next].added];
+        if (i < program->count)
+            code[out++] = program->code[i];
+    }
+    free(program->code);
+    program->code = code;
+    program->count = program->capacity = out;
+
+    pending->added->count = 0; // The operands moved to the program
+    ir_free_program(pending->added);
+    free(pending->places);
+    pending->added = NULL;
+    pending->places = NULL;
+}
+
+/**
+ * @brief Tells whether the profile shows that the loop iterates at most once per entry.
+ *
+ * @details The label after the back edge is reached once per exit. The header label is reached once
+ * per iteration, and once more on the exit when the loop is closed by a JUMP (test at the top).
+ */
+static bool is_cold_loop(IRProgram *program, int start, int end, const Profile *profile)
+{
+    long long header = profile_count(profile, PROFILE_LABEL, program->code[start].args[0]);
+    long long exits = 0;
+    if (end + 1 < program->count && program->code[end + 1].op == IR_LABEL)
+        exits = profile_count(profile, PROFILE_LABEL, program->code[end + 1].args[0]);
+    long long iterations = program->code[end].op == IR_JUMP ? header - exits : header;
+    return iterations <= exits;
+}
+
+/**
+ * @brief Replaces multiplications of induction variables inside while loops by additions.
+ *
+ * @details For a loop "LABEL L ... JUMP L", or a rotated one closed by a conditional jump to L,
+ * without inner control flow, a variable updated once per iteration by a constant step s is
+ * an induction variable. Every "MUL m v k" with literal k is then
+ * rewritten to "MOVE m iv", where iv is a new variable initialised to v*k before the loop and
+ * increased by s*k right after the update of v. Loops nested in other loops are skipped, the new
+ * DEFVAR would be executed repeatedly. With a profile, loops that did not iterate more than once
+ * per entry are skipped as well, the code before the loop would cost more than it saves.
+ *
+ * The rewritten loops never contain one another (a loop with a label inside is not simple), so
+ * the loops are found in the program as it was and the new instructions are inserted at the end.
+ *
+ * @param program Program to optimise.
+ * @param stats Counters to update.
+ * @param profile Execution profile (may be NULL).
+ */
+void optimize_induction_variables(IRProgram *program, OptimizerStats *stats, const Profile *profile)
+{
+    LabelIndex index;
+    label_index_build(&index, program);
+    PendingInsertions pending = {NULL, NULL};
+    int rank = 0;
+
+    for (int end = 0; end < program->count; end++)
+    {
+        if (!is_jump(program->code[end].op))
+            continue;
+
+        int start = label_index_find(&index, program->code[end].args[0]);
+        if (start >= end)
+            start = -1;
+        if (start == -1 || !is_simple_loop(program, start, end) || is_nested_loop(&index, start, end))
+            continue;
+        if (profile && is_cold_loop(program, start, end, profile))
+        {
+            stats->coldLoopsSkipped++;
+            continue;
+        }
+
+        for (int i = start + 1; i < end; i++)
+        {
+            IRInstruction *mul = &program->code[i];
+            long long factor;
+            int varIndex;
+            if (mul->op != IR_MUL || !is_variable(mul->args[0]))
+                continue;
+            if (is_variable(mul->args[1]) && is_int_literal(mul->args[2], &factor))
+                varIndex = 1;
+            else if (is_variable(mul->args[2]) && is_int_literal(mul->args[1], &factor))
+                varIndex = 2;
+            else
+                continue;
+
+            char var[256];
+            snprintf(var, sizeof(var), "%s", mul->args[varIndex]);
+            long long step;
+            int update = find_induction_update(program, start + 1, end, var, &step);
+            if (update == -1)
+                continue;
+
+            char iv[64], factorText[32], increment[32], target[256];
+            snprintf(iv, sizeof(iv), "%.3s%%iv%d", var, compilerContext->inductionCounter++);
+            snprintf(factorText, sizeof(factorText), "int@%lld", factor);
+            snprintf(increment, sizeof(increment), "int@%lld", step * factor);
+            snprintf(target, sizeof(target), "%s", mul->args[0]);
+
+            // The initialisations go before the loop in order, an increment goes right after the update
+            // (before the increments added there earlier)
+            ir_replace(mul, IR_MOVE, target, iv, NULL);
+            rank++;
+            pending_insert(&pending, update + 1, -rank, IR_ADD, iv, iv, increment);
+            pending_insert(&pending, start, rank, IR_DEFVAR, iv, NULL, NULL);
+            pending_insert(&pending, start, rank, IR_MUL, iv, var, factorText);
+            stats->inductionReduced++;
+        }
+    }
+    name_map_free(&index.labels);
+    free(index.firstTargetFrom);
+    pending_apply(&pending, program);
+}
+
+/**
+ * @brief Runs all optimisation passes over the program.
+ *
+ * @param program Program to optimise.
+ * @param stats Counters to fill (may be NULL).
+ * @param profile Execution profile guiding the passes (may be NULL).
+ */
+void optimize_program(IRProgram *program, OptimizerStats *stats, const Profile *profile)
+{
+    OptimizerStats local = {0};
+
+    local.instructionsBefore = program->count;
+    optimize_strength_reduction(program, &local);
+    optimize_induction_variables(program, &local, profile);
+    local.cseEliminated = optimize_local_cse(program);
+    local.instructionsAfter = program->count;
+
+    if (stats)
+        *stats = local;
+}
+
+/**
+ * @brief Prints the optimisation report.
+ */
+void print_optimizer_stats(const OptimizerStats *stats, FILE *out)
+{
+    fprintf(out, "optimizer: %d instructions generated, %d after optimisation\n",
+            stats->instructionsBefore, stats->instructionsAfter);
+    fprintf(out, "optimizer: local CSE eliminated %d instructions\n", stats->cseEliminated);
+    fprintf(out, "optimizer: strength reduction rewrote %d instructions, specialised %d divisions\n",
+            stats->strengthReduced, stats->divisionsSpecialised);
+    fprintf(out, "optimizer: %d literal conversions folded, %d induction multiplications reduced\n",
+            stats->conversionsFolded, stats->inductionReduced);
+    fprintf(out, "optimizer: profile flipped %d branches, skipped %d cold loops\n",
+            stats->branchesFlipped, stats->coldLoopsSkipped);
+    fprintf(out, "optimizer: %d self tail calls turned into jumps\n", stats->tailCallsEliminated);
+}
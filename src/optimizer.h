@@ -0,0 +1,40 @@
+/**
+ * @file optimizer.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Code generator
+ * @brief Optimisation passes over the intermediate representation.
+ */
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <stdio.h>
+#include "ir.h"
+#include "profile.h"
+
+/**
+ * @brief Counters collected while optimising one program.
+ */
+typedef struct
+{
+    int instructionsBefore; // Instructions produced by the generator
+    int instructionsAfter;  // Instructions left after all passes
+    int cseEliminated;      // Instructions removed by common subexpression elimination
+    int strengthReduced;    // MUL/IDIV by 0, 1, 2 rewritten to MOVE/ADD
+    int divisionsSpecialised; // DIV of integers turned into IDIV
+    int conversionsFolded;  // INT2FLOAT/FLOAT2INT of literals folded
+    int inductionReduced;   // MUL of induction variables replaced by additions
+    int coldLoopsSkipped;   // Loops left alone because the profile shows they hardly iterate
+    int branchesFlipped;    // If statements laid out with the else branch falling through
+    int tailCallsEliminated; // Self tail calls turned into jumps
+} OptimizerStats;
+
+// Pass pipeline
+void optimize_program(IRProgram *program, OptimizerStats *stats, const Profile *profile);
+void print_optimizer_stats(const OptimizerStats *stats, FILE *out);
+
+// Single passes
+int optimize_local_cse(IRProgram *program);
+void optimize_strength_reduction(IRProgram *program, OptimizerStats *stats);
+void optimize_induction_variables(IRProgram *program, OptimizerStats *stats, const Profile *profile);
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ * @file profile.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Code generator
+ * @brief Execution profile recorded by the interpreter and used by the code generator.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "profile.h"
+#include "error.h"
+
+#define PROFILE_INITIAL_CAPACITY 64
+#define PROFILE_LINE_BUFFER 1024
+
+static const char *kindNames[] = {
+    [PROFILE_LABEL] = "label",
+    [PROFILE_CALL] = "call",
+};
+
+static ProfileEntry *profile_find(const Profile *profile, ProfileKind kind, const char *name)
+{
+    for (int i = 0; i < profile->count; i++)
+    {
+        ProfileEntry *entry = &profile->entries[i];
+        if (entry->kind == kind && strcmp(entry->name, name) == 0)
+            return entry;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Allocates an empty profile.
+ */
+Profile *profile_create()
+{
+    Profile *profile = malloc(sizeof(Profile));
+    if (!profile)
+        handle_error(ERR_COMPILER_INTERNAL);
+    profile->entries = malloc(sizeof(ProfileEntry) * PROFILE_INITIAL_CAPACITY);
+    if (!profile->entries)
+        handle_error(ERR_COMPILER_INTERNAL);
+    profile->count = 0;
+    profile->capacity = PROFILE_INITIAL_CAPACITY;
+    return profile;
+}
+
+/**
+ * @brief Frees the profile with all its entries.
+ */
+void profile_free(Profile *profile)
+{
+    if (!profile)
+        return;
+    for (int i = 0; i < profile->count; i++)
+        free(profile->entries[i].name);
+    free(profile->entries);
+    free(profile);
+}
+
+/**
+ * @brief Adds the count to the counter of the event, the counter is created when missing.
+ *
+ * @param profile Target profile.
+ * @param kind Kind of the event.
+ * @param name Label name, or "site callee" for calls.
+ * @param count Number of occurrences to add.
+ */
+void profile_add(Profile *profile, ProfileKind kind, const char *name, long long count)
+{
+    ProfileEntry *entry = profile_find(profile, kind, name);
+    if (entry)
+    {
+        entry->count += count;
+        return;
+    }
+
+    if (profile->count == profile->capacity)
+    {
+        int newCapacity = profile->capacity * 2;
+        ProfileEntry *newEntries = realloc(profile->entries, sizeof(ProfileEntry) * newCapacity);
+        if (!newEntries)
+            handle_error(ERR_COMPILER_INTERNAL);
+        profile->entries = newEntries;
+        profile->capacity = newCapacity;
+    }
+
+    entry = &profile->entries[profile->count++];
+    entry->kind = kind;
+    entry->count = count;
+    entry->name = malloc(strlen(name) + 1);
+    if (!entry->name)
+        handle_error(ERR_COMPILER_INTERNAL);
+    strcpy(entry->name, name);
+}
+
+/**
+ * @brief Returns the recorded count of the event (0 when it never happened).
+ */
+long long profile_count(const Profile *profile, ProfileKind kind, const char *name)
+{
+    ProfileEntry *entry = profile_find(profile, kind, name);
+    return entry ? entry->count : 0;
+}
+
+/**
+ * @brief Reads a profile written by profile_save().
+ *
+ * @param path Name of the file.
+ * @return The profile, or NULL when the file cannot be read or is malformed.
+ */
+Profile *profile_load(const char *path)
+{
+    FILE *in = fopen(path, "r");
+    if (!in)
+        return NULL;
+
+    Profile *profile = profile_create();
+    char line[PROFILE_LINE_BUFFER];
+    while (fgets(line, sizeof(line), in))
+    {
+        char kind[16], first[PROFILE_LINE_BUFFER], second[PROFILE_LINE_BUFFER];
+        long long count;
+        if (sscanf(line, "%15s", kind) != 1 || kind[0] == '#')
+            continue;
+
+        if (strcmp(kind, kindNames[PROFILE_CALL]) == 0 &&
+            sscanf(line, "%*s %1023s %1023s %lld", first, second, &count) == 3)
+        {
+            char name[2 * PROFILE_LINE_BUFFER];
+            snprintf(name, sizeof(name), "%s %s", first, second);
+            profile_add(profile, PROFILE_CALL, name, count);
+        }
+        else if (strcmp(kind, kindNames[PROFILE_LABEL]) == 0 &&
+                 sscanf(line, "%*s %1023s %lld", first, &count) == 2)
+        {
+            profile_add(profile, PROFILE_LABEL, first, count);
+        }
+        else
+        {
+            profile_free(profile);
+            fclose(in);
+            return NULL;
+        }
+    }
+    fclose(in);
+    return profile;
+}
+
+/**
+ * @brief Writes the profile to a file.
+ *
+ * @return false when the file cannot be written.
+ */
+bool profile_save(const Profile *profile, const char *path)
+{
+    FILE *out = fopen(path, "w");
+    if (!out)
+        return false;
+
+    fprintf(out, "# IFJ24 execution profile\n");
+    for (int i = 0; i < profile->count; i++)
+    {
+        const ProfileEntry *entry = &profile->entries[i];
+        fprintf(out, "%s %s %lld\n", kindNames[entry->kind], entry->name, entry->count);
+    }
+    return fclose(out) == 0;
+}
+
+/**
+ * @brief Prints the most frequent calls.
+ *
+ * @param profile Profile to print.
+ * @param out Output stream.
+ * @param limit Maximal number of printed calls.
+ */
+void profile_print_hot_calls(const Profile *profile, FILE *out, int limit)
+{
+    bool *printed = calloc(profile->count + 1, sizeof(bool));
+    if (!printed)
+        handle_error(ERR_COMPILER_INTERNAL);
+
+    for (int n = 0; n < limit; n++)
+    {
+        int hottest = -1;
+        for (int i = 0; i < profile->count; i++)
+        {
+            const ProfileEntry *entry = &profile->entries[i];
+            if (entry->kind == PROFILE_CALL && !printed[i] &&
+                (hottest == -1 || entry->count > profile->entries[hottest].count))
+                hottest = i;
+        }
+        if (hottest == -1)
+            break;
+        printed[hottest] = true;
+        fprintf(out, "profile: call %s executed %lld times\n", profile->entries[hottest].name,
+                profile->entries[hottest].count);
+    }
+    free(printed);
+}
@@ -0,0 +1,62 @@
+/**
+ * @file profile.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Code generator
+ * @brief Execution profile recorded by the interpreter and used by the code generator.
+ *
+ * @details With --profile-generate the built-in interpreter counts how many times every label
+ * was reached and how many times every call site ("$name%call_N", the N-th call in the function)
+ * called its function, and the counts are saved to a text file. With --profile-use the file is loaded again and the generator lays out if
+ * statements with the hot branch falling through, the optimiser skips cold loops.
+ *
+ * File format, one entry per line ('#' starts a comment):
+ * @code
+ * label $while_start_0 30000
+ * call $main%call_0 $collatz 29999
+ * @endcode
+ */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ * @brief Kinds of the counted events.
+ */
+typedef enum
+{
+    PROFILE_LABEL, // Label reached (by a jump or by falling through)
+    PROFILE_CALL   // Calls from one call site, named "site callee"
+} ProfileKind;
+
+typedef struct
+{
+    ProfileKind kind;
+    char *name;
+    long long count;
+} ProfileEntry;
+
+/**
+ * @brief Growable array of counters.
+ */
+typedef struct Profile
+{
+    ProfileEntry *entries;
+    int count;
+    int capacity;
+} Profile;
+
+Profile *profile_create();
+void profile_free(Profile *profile);
+void profile_add(Profile *profile, ProfileKind kind, const char *name, long long count);
+long long profile_count(const Profile *profile, ProfileKind kind, const char *name);
+
+// Files
+Profile *profile_load(const char *path);
+bool profile_save(const Profile *profile, const char *path);
+
+// Output
+void profile_print_hot_calls(const Profile *profile, FILE *out, int limit);
+
+#endif
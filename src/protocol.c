@@ -0,0 +1,71 @@
+/**
+ * @file protocol.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief Messages between the compile server (main --server) and its client (ifj_client).
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <unistd.h>
+
+#include "protocol.h"
+
+/**
+ * @brief Writes the whole buffer, retrying short and interrupted writes.
+ */
+bool protocol_write_all(int fd, const void *data, size_t size)
+{
+    const char *bytes = data;
+    while (size > 0)
+    {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        bytes += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads exactly size bytes, false when the connection ends before.
+ */
+bool protocol_read_all(int fd, void *data, size_t size)
+{
+    char *bytes = data;
+    while (size > 0)
+    {
+        ssize_t received = read(fd, bytes, size);
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received <= 0)
+            return false;
+        bytes += received;
+        size -= (size_t)received;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads the header line of a message (without the '\\n').
+ *
+ * @details The header is read byte by byte, so nothing of the body that follows is consumed.
+ *
+ * @return False when the connection ends or the line does not fit into the buffer.
+ */
+bool protocol_read_line(int fd, char *line, size_t size)
+{
+    for (size_t length = 0; length + 1 < size; length++)
+    {
+        if (!protocol_read_all(fd, &line[length], 1))
+            return false;
+        if (line[length] == '\n')
+        {
+            line[length] = '\0';
+            return true;
+        }
+    }
+    return false;
+}
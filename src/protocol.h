@@ -0,0 +1,33 @@
+/**
+ * @file protocol.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief Messages between the compile server (main --server) and its client (ifj_client).
+ *
+ * @details One request per connection over a Unix domain stream socket:
+ * @code
+ * SOURCE <length>\n<length bytes of IFJ24 source>
+ * PATH <length>\n<length bytes of a file name, opened by the server>
+ * QUIT 0\n                          (stops the server)
+ * @endcode
+ * The answer is the exit code the command line compiler would return, followed by its standard
+ * output (the IFJcode24 program) and its error messages:
+ * @code
+ * <exit code> <output length> <error length>\n<output bytes><error bytes>
+ * @endcode
+ */
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PROTOCOL_DEFAULT_SOCKET "/tmp/ifj24.sock"
+#define PROTOCOL_HEADER_MAX 64
+#define PROTOCOL_REQUEST_MAX (256 * 1024 * 1024)
+
+bool protocol_write_all(int fd, const void *data, size_t size);
+bool protocol_read_all(int fd, void *data, size_t size);
+bool protocol_read_line(int fd, char *line, size_t size);
+
+#endif
@@ -5,7 +5,152 @@
  * @brief This file contains functions for semantic analysis, processing binary tree, checking everything.
  */
 
+#include <stdint.h>
+#include <stdlib.h>
+
 #include "semantic.h"
+#include "builtins.h"
+
+// * Frame slots of the function being analysed. The generated code has one frame variable per
+// * name, so a name declared again in another block of the same function keeps its slot.
+// * Names are interned, equal names have equal pointers, so the slots of the named variables are
+// * kept in an open addressing table keyed by the pointer. An entry belongs to the function whose
+// * number it carries, starting a function does not have to clear the table.
+#define FRAME_SLOT_TABLE_INITIAL_SIZE 64
+typedef struct
+{
+    const char *name;   // Interned name, NULL for a free entry
+    unsigned function;  // Number of the function the entry belongs to
+    int slot;
+} FrameSlotEntry;
+static _Thread_local FrameSlotEntry *frameSlotTable = NULL;
+static _Thread_local int frameSlotTableSize = 0;
+static _Thread_local int frameSlotNamed = 0;     // Entries of the current function
+static _Thread_local unsigned frameSlotFunction = 1; // Never 0, the number of the entries of a new table
+static _Thread_local int frameSlotCount = 0;     // Slots of the current function, temporaries included
+
+static int frame_slot_index(FrameSlotEntry *table, int size, const char *name)
+{
+    int index = (int)(((uintptr_t)name >> 4) * 2654435761u & (uintptr_t)(size - 1));
+    while (table[index].function == frameSlotFunction && table[index].name != name)
+        index = (index + 1) & (size - 1);
+    return index;
+}
+
+static void frame_slot_table_grow()
+{
+    int newSize = frameSlotTableSize ? 2 * frameSlotTableSize : FRAME_SLOT_TABLE_INITIAL_SIZE;
+    FrameSlotEntry *newTable = calloc(newSize, sizeof(FrameSlotEntry));
+    if (!newTable)
+        handle_error(ERR_COMPILER_INTERNAL);
+    for (int i = 0; i < frameSlotTableSize; i++)
+    {
+        if (frameSlotTable[i].function == frameSlotFunction && frameSlotTable[i].name != NULL)
+            newTable[frame_slot_index(newTable, newSize, frameSlotTable[i].name)] = frameSlotTable[i];
+    }
+    free(frameSlotTable);
+    frameSlotTable = newTable;
+    frameSlotTableSize = newSize;
+}
+
+/**
+ * @brief Starts the frame slots of the next function.
+ */
+static void begin_frame_slots()
+{
+    frameSlotCount = 0;
+    frameSlotNamed = 0;
+    if (++frameSlotFunction == 0)
+    {
+        // The numbers wrapped around, entries of old functions could be taken for current ones
+        free(frameSlotTable);
+        frameSlotTable = NULL;
+        frameSlotTableSize = 0;
+        frameSlotFunction = 1;
+    }
+}
+
+/**
+ * @brief Returns the frame slot of a named variable or a new slot for a temporary.
+ *
+ * @param name Interned name of the variable, NULL for an expression temporary.
+ * @return Dense index of the slot within the current function.
+ */
+static int assign_frame_slot(const char *name)
+{
+    if (name == NULL)
+        return frameSlotCount++;
+
+    if (2 * (frameSlotNamed + 1) > frameSlotTableSize)
+        frame_slot_table_grow();
+    FrameSlotEntry *entry = &frameSlotTable[frame_slot_index(frameSlotTable, frameSlotTableSize, name)];
+    if (entry->function != frameSlotFunction)
+    {
+        entry->name = name;
+        entry->function = frameSlotFunction;
+        entry->slot = frameSlotCount++;
+        frameSlotNamed++;
+    }
+    return entry->slot;
+}
+
+/**
+ * @brief Frees the frame slot table of the thread (at the end of a compilation).
+ */
+void semantic_free()
+{
+    free(frameSlotTable);
+    frameSlotTable = NULL;
+    frameSlotTableSize = frameSlotNamed = frameSlotCount = 0;
+}
+
+/**
+ * @brief Gives the just declared local variable its frame slot.
+ *
+ * @param node Identifier node of the declaration or parameter.
+ * @param stack Symbol stack with the variable in its top scope.
+ */
+static void declare_frame_slot(BinaryTreeNode *node, SymbolStack *stack)
+{
+    Symbol *symbol = search_hash_table(stack->top->table, node->strValue);
+    if (symbol == NULL || symbol->isGlobal)
+        return;
+    symbol->slot = assign_frame_slot(node_identifier(node));
+    node->slot = symbol->slot;
+}
+
+/**
+ * @brief Copies the frame slot of the referenced variable to an identifier node.
+ */
+static void bind_frame_slot(BinaryTreeNode *node, SymbolStack *stack)
+{
+    if (node == NULL || node->tokenType != TOKEN_IDENTIFIER)
+        return;
+    Symbol *symbol = search_symbol_stack(stack, node->strValue);
+    if (symbol != NULL)
+        node->slot = symbol->slot;
+}
+
+/**
+ * @brief Resolves the operands of an expression and gives every operation a temporary slot.
+ *
+ * @details The code generator stores the result of each operation node into its own frame
+ * variable, the slot of that variable is kept on the operation node.
+ */
+static void assign_expression_slots(BinaryTreeNode *node, SymbolStack *stack)
+{
+    if (node == NULL)
+        return;
+    if (node->type == NODE_OP)
+    {
+        assign_expression_slots(node->left, stack);
+        assign_expression_slots(node->right, stack);
+        if (node->slot < 0)
+            node->slot = assign_frame_slot(NULL);
+        return;
+    }
+    bind_frame_slot(node, stack);
+}
 
 void process_var_declaration(BinaryTreeNode *node, SymbolStack *stack)
 {
@@ -13,7 +158,7 @@ void process_var_declaration(BinaryTreeNode *node, SymbolStack *stack)
     bool isConst = false;
 
     // * Check if the variable is constant
-    if (strcmp(node->strValue, "const") == 0)
+    if (node_keyword(node) == KEYWORD_CONST)
     {
         isConst = true;
     }
@@ -36,7 +181,7 @@ void process_var_declaration(BinaryTreeNode *node, SymbolStack *stack)
     }
     else
     {
-        varType = value_string_to_type(varSpeci->strValue);
+        varType = node_data_type(varSpeci);
     }
 
     // * ASSIGN "=" LOGIC: Get the assigned value
@@ -65,8 +210,22 @@ void process_var_declaration(BinaryTreeNode *node, SymbolStack *stack)
             varType = process_expression(varValue, stack);
         }
 
+        // * The type of a literal follows from its token, an identifier has the type of its variable
+        DataType initDataType = value_string_to_type(token_to_type(initType));
+        if (initType == TOKEN_IDENTIFIER)
+        {
+            Symbol *source = search_symbol_stack(stack, initValue);
+            if (source == NULL)
+            {
+                freeTreeFromAnyNode(node);
+                free_symbol_stack(stack);
+                handle_error(ERR_UNDEFINED_ID);
+            }
+            initDataType = source->type;
+        }
+
         // * Check type compatibility between the value and the declared type
-        if (!are_types_compatible(value_string_to_type(token_to_type(initType)), varType))
+        if (!are_types_compatible(initDataType, varType))
         {
             freeTreeFromAnyNode(node);
             free_symbol_stack(stack);
@@ -89,19 +248,29 @@ void process_var_declaration(BinaryTreeNode *node, SymbolStack *stack)
         }
 
         // * TESTING OUTPUT: Insert the variable into the symbol table
-        switch (varType)
+        if (initType == TOKEN_IDENTIFIER)
+        {
+            // * The value is known only at run time
+            bind_frame_slot(varValue, stack);
+            insert_symbol_stack(stack, varIdenti, varType, NULL, isConst, true, isGlobal, TYPE_EMPTY);
+        }
+        else switch (varType)
         {
         case TYPE_INT:
         case TYPE_INT_NULL:
         {
-            int val = atoi(initValue); // Convert to integer using atoi
+            int val = varValue->value.kind == VALUE_INT     ? (int)varValue->value.intValue
+                      : varValue->value.kind == VALUE_FLOAT ? (int)varValue->value.floatValue
+                                                            : 0;
             insert_symbol_stack(stack, varIdenti, varType, &val, isConst, isNull, isGlobal, TYPE_EMPTY);
         }
         break;
         case TYPE_FLOAT:
         case TYPE_FLOAT_NULL:
         {
-            float val = strtof(initValue, NULL); // Convert to float using strtof
+            float val = varValue->value.kind == VALUE_FLOAT ? (float)varValue->value.floatValue
+                        : varValue->value.kind == VALUE_INT ? (float)varValue->value.intValue
+                                                            : 0.0f;
             insert_symbol_stack(stack, varIdenti, varType, &val, isConst, isNull, isGlobal, TYPE_EMPTY);
         }
         break;
@@ -114,23 +283,56 @@ void process_var_declaration(BinaryTreeNode *node, SymbolStack *stack)
         default:
             break;
         }
+        declare_frame_slot(varnode, stack);
     }
     // * If the value is an operation (e.g., a complex expression)
     else if (varValue->type == NODE_OP)
     {
         // Process the expression for complex initializations (e.g., "a = 1 + 2 * 5")
-        process_expression(varValue, stack);
+        DataType expressionType = process_expression(varValue, stack);
+        if (varType == TYPE_UNKNOWN)
+        {
+            varType = expressionType;
+        }
+
+        if (search_hash_table(stack->top->table, varIdenti))
+        {
+            freeTreeFromAnyNode(node);
+            free_symbol_stack(stack);
+            handle_error(ERR_REDEF);
+        }
+
+        // * The value is known only at run time
+        insert_symbol_stack(stack, varIdenti, varType, NULL, isConst, true, stack->top->next == NULL, TYPE_EMPTY);
+        declare_frame_slot(varnode, stack);
     }
     // * If the value is a function call
     else if (varValue->type == NODE_FUNC_CALL)
     {
         DataType funcReturnType = process_validate_func_call(varValue, stack);
-        if (funcReturnType)
+
+        // * Check the return type against the variable's type (or infer the type from it)
+        if (varType == TYPE_UNKNOWN)
         {
-            /* code */
+            varType = funcReturnType;
+        }
+        else if (!are_types_compatible(funcReturnType, varType))
+        {
+            freeTreeFromAnyNode(node);
+            free_symbol_stack(stack);
+            handle_error(ERR_TYPE_COMPAT);
         }
 
-        //  TODO: Check the return type against the variable's type
+        if (search_hash_table(stack->top->table, varIdenti))
+        {
+            freeTreeFromAnyNode(node);
+            free_symbol_stack(stack);
+            handle_error(ERR_REDEF);
+        }
+
+        // * The value is known only at run time
+        insert_symbol_stack(stack, varIdenti, varType, NULL, isConst, true, stack->top->next == NULL, TYPE_EMPTY);
+        declare_frame_slot(varnode, stack);
     }
 }
 
@@ -156,14 +358,16 @@ void process_if(BinaryTreeNode *ConditionNode, SymbolStack *stack)
         BinaryTreeNode *nonNullVal = move_right_until(conditionAndNonNull, TOKEN_IDENTIFIER);
         nonNullVal_str = nonNullVal->strValue;
         insert_symbol_stack(stack, nonNullVal_str, TYPE_NONNULL, "", false, false, false, TYPE_EMPTY);
+        declare_frame_slot(nonNullVal, stack);
     }
 
     // * Process the actual condition expression (TODO: implement condition processing)
+    assign_expression_slots(conditionAndNonNull->left, stack);
 
     // * Handle the body of the IF statement (code inside curly brackets)
     BinaryTreeNode *conditionbody = move_right_until(auxnode, TOKEN_CURLYL_BRACKET);
     conditionbody = move_left_until(conditionbody, TOKEN_EMPTY); // move to the inner content
-    ProcessTree(conditionbody, stack);                           // Process the body of the IF
+    process_block(conditionbody, stack);                         // Process the body of the IF
     pop_scope(stack);                                            // End the IF scope
 
     // * Handle the ELSE block if it exists
@@ -174,7 +378,7 @@ void process_if(BinaryTreeNode *ConditionNode, SymbolStack *stack)
 
         // * Create a new scope for the ELSE block
         push_scope(stack);
-        ProcessTree(elsebody, stack); // Process the body of the ELSE
+        process_block(elsebody, stack); // Process the body of the ELSE
         pop_scope(stack);             // End the ELSE scope
     }
 }
@@ -201,6 +405,7 @@ void process_while(BinaryTreeNode *whileNode, SymbolStack *stack)
         BinaryTreeNode *nonNullNode = move_right_until(conditionAndNonNullNode, TOKEN_IDENTIFIER);
         char *nonNullNode_str = nonNullNode->strValue;
         insert_symbol_stack(stack, nonNullNode_str, TYPE_NONNULL, "", false, false, false, TYPE_EMPTY);
+        declare_frame_slot(nonNullNode, stack);
     }
 
     // * Process the body of the while loop (code inside curly brackets)
@@ -209,7 +414,7 @@ void process_while(BinaryTreeNode *whileNode, SymbolStack *stack)
 
     // * Create a new scope for the loop body and process the body code
     push_scope(stack);
-    ProcessTree(body, stack); // Process the statements inside the while loop
+    process_block(body, stack); // Process the statements inside the while loop
     pop_scope(stack);         // End the scope after processing the body
 }
 
@@ -229,6 +434,7 @@ void process_identifier_assign(BinaryTreeNode *node, SymbolStack *stack)
         free_symbol_stack(stack);
         handle_error(ERR_UNDEFINED_ID);
     }
+    nodeidentifier->slot = identifier->slot;
 
     // * Move to the right to find the assignment operator and the expression to assign
     BinaryTreeNode *expressionOrFunc = move_right_until(nodeidentifier->right, TOKEN_ASSIGNMENT);
@@ -250,7 +456,7 @@ void process_identifier_assign(BinaryTreeNode *node, SymbolStack *stack)
         {
             /* code */
         }
-        else if (are_types_compatible(funcTypeReturn, identifier->freturn_type))
+        else if (!are_types_compatible(funcTypeReturn, identifier->type))
         {
             // Error: function return type does not match variable type
             freeTreeFromAnyNode(node);
@@ -261,6 +467,7 @@ void process_identifier_assign(BinaryTreeNode *node, SymbolStack *stack)
     // * If the assigned value is an operation (expression), handle it here
     else if (expressionOrFunc->type == NODE_OP && (strcmp(expressionOrFunc->strValue, "null") != 0))
     {
+        assign_expression_slots(expressionOrFunc, stack);
     }
     else
     {
@@ -268,6 +475,20 @@ void process_identifier_assign(BinaryTreeNode *node, SymbolStack *stack)
         BinaryTreeNode *valuetoAssign = expressionOrFunc;
         DataType valuetoAssign_type = find_return_datatype(valuetoAssign->strValue);
 
+        // * An identifier has the type of the variable it names
+        if (valuetoAssign->tokenType == TOKEN_IDENTIFIER)
+        {
+            Symbol *source = search_symbol_stack(stack, valuetoAssign->strValue);
+            if (source == NULL)
+            {
+                freeTreeFromAnyNode(node);
+                free_symbol_stack(stack);
+                handle_error(ERR_UNDEFINED_ID);
+            }
+            valuetoAssign_type = source->type;
+            valuetoAssign->slot = source->slot;
+        }
+
         Symbol *variable = search_symbol_stack(stack, nodeidentifier_str);
         DataType variable_type = variable->type;
 
@@ -294,7 +515,7 @@ void process_identifier_assign(BinaryTreeNode *node, SymbolStack *stack)
         }
 
         // * Update the variable with the new value (integer type conversion)
-        int value_to_assign = atoi(valuetoAssign->strValue); // Use strtol for more control if needed
+        int value_to_assign = valuetoAssign->value.kind == VALUE_INT ? (int)valuetoAssign->value.intValue : 0;
         upd_var_symbol_stack(stack, variable, (void *)&value_to_assign, valuetoAssign_type);
     }
 }
@@ -320,7 +541,7 @@ void process_func_def(BinaryTreeNode *funcDefNode, SymbolStack *stack)
 
     // * Process the return type of the function
     BinaryTreeNode *funcReturn_type = move_right_until(funcName_node, TOKEN_KEYWORD);
-    DataType returnDef_type = value_string_to_type(funcReturn_type->strValue);
+    DataType returnDef_type = node_data_type(funcReturn_type);
 
     // * Check if the function is `main` and validate its constraints
     if (strcmp(funcName_node->strValue, "main") == 0)
@@ -353,13 +574,17 @@ void process_func_def(BinaryTreeNode *funcDefNode, SymbolStack *stack)
     // * Check for function redefinition
     if (search_hash_table(stack->top->table, funcSymbol->name))
     {
+        free(funcSymbol->name);
+        free(funcSymbol);
         freeTreeFromAnyNode(funcDefNode);
         free_symbol_stack(stack);
         handle_error(ERR_REDEF);
     }
 
-    // Insert function into the symbol table
+    // Insert function into the symbol table (it keeps its own copy of the symbol)
     insert_symbol_stack(stack, funcSymbol->name, funcSymbol->type, funcSymbol->value.params, false, false, true, returnDef_type);
+    free(funcSymbol->name);
+    free(funcSymbol);
 
     // * Restore original scope
     stack->top = currentScope;
@@ -367,13 +592,27 @@ void process_func_def(BinaryTreeNode *funcDefNode, SymbolStack *stack)
     // * Push a new scope for the function body
     push_scope(stack);
 
+    // * Parameters are variables of the body scope, their values are known only at run time
+    for (Symbol *param = paramChain; param != NULL; param = param->next)
+    {
+        insert_symbol_stack(stack, param->name, param->type, NULL, true, true, false, TYPE_EMPTY);
+    }
+
+    // * Frame slots of the function start with its parameters
+    begin_frame_slots();
+    for (BinaryTreeNode *param = funcParams_start->right; param != NULL && param->tokenType != TOKEN_RPAREN; param = param->right)
+    {
+        if (param->tokenType == TOKEN_IDENTIFIER)
+            declare_frame_slot(param, stack);
+    }
+
     // * Process the function body and the return statement
     BinaryTreeNode *funcBody = move_left_until(funcReturn_type->right, TOKEN_EMPTY);
-    BinaryTreeNode *funcReturnExp_type = ProcessTree(funcBody, stack);
+    BinaryTreeNode *funcReturnExp_type = process_block(funcBody, stack);
 
     // * Process return type and check for valid return statement
     DataType returnExp_type = process_func_return(funcReturnExp_type, stack);
-    bool hasReturn = (strcmp(funcReturnExp_type->strValue, "return") == 0);
+    bool hasReturn = node_keyword(funcReturnExp_type) == KEYWORD_RETURN;
 
     // * Handle void function return constraints
     if (returnDef_type == TYPE_VOID)
@@ -436,7 +675,7 @@ Symbol *parse_parameters(BinaryTreeNode *paramsListNode)
             // * If token is an identifier (parameter name)
             BinaryTreeNode *param_ident = params_node;
             BinaryTreeNode *param_type = move_right_until(param_ident, TOKEN_KEYWORD);
-            DataType param_datatype = value_string_to_type(param_type->strValue); // Get the parameter's type
+            DataType param_datatype = node_data_type(param_type); // Get the parameter's type
 
             // * Create a new symbol for the parameter
             Symbol *paramSymbol = malloc(sizeof(Symbol));
@@ -472,6 +711,12 @@ DataType process_validate_func_call(BinaryTreeNode *funcnode, SymbolStack *stack
         return TYPE_UNKNOWN;
     }
 
+    // * Built-in functions (ifj.name) are checked against the descriptor table
+    if (funcnode->right && funcnode->right->tokenType == TOKEN_DOT)
+    {
+        return process_builtin_call(funcnode, stack);
+    }
+
     char *funcName_str = funcnode->strValue; // Extract the function name
 
     // * Save the current scope and move to the global scope
@@ -488,7 +733,7 @@ DataType process_validate_func_call(BinaryTreeNode *funcnode, SymbolStack *stack
     // * Check if the function is defined
     if (!funcSymbol)
     {
-        fprintf(stderr, "Error: Function '%s' is not defined.\n", funcName_str);
+        fprintf(compiler_diagnostics(), "Error: Function '%s' is not defined.\n", funcName_str);
         freeTreeFromAnyNode(funcnode);
         free_symbol_stack(stack);
         handle_error(ERR_UNDEFINED_ID);
@@ -521,14 +766,17 @@ DataType process_validate_func_call(BinaryTreeNode *funcnode, SymbolStack *stack
 
             // * Find the argument type (either from the symbol table or directly from the node)
             if (argNode_tofind != NULL)
-                argType = find_return_datatype(argNode_tofind->name);
+            {
+                argType = argNode_tofind->type;
+                argNode->slot = argNode_tofind->slot;
+            }
             else
                 argType = find_return_datatype(argNode->strValue);
 
             // * Validate that the argument type matches the parameter type
             if (!are_types_compatible(argType, paramSymbol->type))
             {
-                fprintf(stderr, "Error: Type mismatch for parameter '%s' in function '%s'. Expected '%s', got '%s'.\n",
+                fprintf(compiler_diagnostics(), "Error: Type mismatch for parameter '%s' in function '%s'. Expected '%s', got '%s'.\n",
                         paramSymbol->name, funcName_str,
                         value_type_to_string(paramSymbol->type),
                         value_type_to_string(argType));
@@ -544,7 +792,7 @@ DataType process_validate_func_call(BinaryTreeNode *funcnode, SymbolStack *stack
         else
         {
             // * If there are more arguments than parameters
-            fprintf(stderr, "Error: Too many arguments for function '%s'. Expected %d, got more than %d.\n",
+            fprintf(compiler_diagnostics(), "Error: Too many arguments for function '%s'. Expected %d, got more than %d.\n",
                     funcName_str, paramCount, argCount + 1);
             freeTreeFromAnyNode(funcnode);
             free_symbol_stack(stack);
@@ -561,7 +809,7 @@ DataType process_validate_func_call(BinaryTreeNode *funcnode, SymbolStack *stack
     while (missingParam)
     {
         // * If a parameter is missing, throw an error
-        fprintf(stderr, "Error: Missing argument for parameter '%s' in function '%s'.\n",
+        fprintf(compiler_diagnostics(), "Error: Missing argument for parameter '%s' in function '%s'.\n",
                 missingParam->name, funcName_str);
         freeTreeFromAnyNode(funcnode);
         free_symbol_stack(stack);
@@ -574,6 +822,69 @@ DataType process_validate_func_call(BinaryTreeNode *funcnode, SymbolStack *stack
     return funcSymbol->freturn_type;
 }
 
+DataType process_builtin_call(BinaryTreeNode *ifjNode, SymbolStack *stack)
+{
+    // * Find the descriptor of the built-in function (ifj -> . -> name), the generator takes it from the call node
+    BinaryTreeNode *nameNode = ifjNode->right->right;
+    const BuiltinDescriptor *builtin = nameNode ? builtin_lookup(node_identifier(nameNode)) : NULL;
+    ifjNode->builtin = builtin;
+    if (!builtin)
+    {
+        fprintf(compiler_diagnostics(), "Error: Built-in function 'ifj.%s' is not defined.\n", nameNode ? nameNode->strValue : "");
+        freeTreeFromAnyNode(ifjNode);
+        free_symbol_stack(stack);
+        handle_error(ERR_UNDEFINED_ID);
+    }
+
+    // * Check the number and types of the arguments
+    BinaryTreeNode *argNode = nameNode->left ? nameNode->left->right : NULL;
+    int argCount = 0;
+    for (; argNode && argNode->tokenType != TOKEN_RPAREN; argNode = argNode->right)
+    {
+        if (argNode->tokenType == TOKEN_COMMA)
+            continue;
+
+        DataType argType;
+        if (argNode->tokenType == TOKEN_IDENTIFIER)
+        {
+            Symbol *argSymbol = search_symbol_stack(stack, argNode->strValue);
+            if (!argSymbol)
+            {
+                freeTreeFromAnyNode(ifjNode);
+                free_symbol_stack(stack);
+                handle_error(ERR_UNDEFINED_ID);
+            }
+            argType = argSymbol->type;
+            argNode->slot = argSymbol->slot;
+        }
+        else if (argNode->tokenType == TOKEN_NULL)
+            argType = TYPE_NULL;
+        else
+            argType = value_string_to_type(token_to_type(argNode->tokenType));
+
+        if (argCount >= builtin->arity ||
+            (builtin->params[argCount] != TYPE_UNKNOWN && !are_types_compatible(argType, builtin->params[argCount])))
+        {
+            fprintf(compiler_diagnostics(), "Error: Wrong arguments for built-in function 'ifj.%s'.\n", builtin->name);
+            freeTreeFromAnyNode(ifjNode);
+            free_symbol_stack(stack);
+            handle_error(ERR_FUNC_PARAM);
+        }
+        argCount++;
+    }
+
+    if (argCount != builtin->arity)
+    {
+        fprintf(compiler_diagnostics(), "Error: Built-in function 'ifj.%s' expects %d arguments, got %d.\n",
+                builtin->name, builtin->arity, argCount);
+        freeTreeFromAnyNode(ifjNode);
+        free_symbol_stack(stack);
+        handle_error(ERR_FUNC_PARAM);
+    }
+
+    return builtin->returnType;
+}
+
 DataType process_func_return(BinaryTreeNode *returnNode, SymbolStack *stack)
 {
     // * Check if there is no return expression (i.e., both left and right are NULL)
@@ -594,17 +905,16 @@ DataType process_expression(BinaryTreeNode *returnNode, SymbolStack *stack)
     Stack s;
     initStack(&s, rule);
     setStartNodeInOrder(returnNode);
-    InOrder(curInOrderNode, &s);
+    InOrder(compilerContext->curInOrderNode, &s);
 
     // PrintAllStack(&s);
+    freeStack(&s);
 
     if (returnNode == NULL)
     {
         return TYPE_EMPTY;
     }
-    if (stack)
-    {
-    }
+    assign_expression_slots(returnNode, stack);
 
     // ? BinaryTreeNode *node = returnNode;
 
@@ -643,7 +953,23 @@ void process_voidFunc(BinaryTreeNode *node, SymbolStack *stack)
     }
 }
 
-BinaryTreeNode *ProcessTree(BinaryTreeNode *root, SymbolStack *stack)
+/**
+ * @brief Runs the semantic analysis of the tree built by FIRST().
+ *
+ * @details ctx becomes the current context of the thread for the analysis.
+ *
+ * @param ctx Context of the compilation.
+ * @param root Root of the abstract syntax tree.
+ * @param stack Symbol stack with the global scope.
+ * @return The return statement the top level ended at, NULL otherwise.
+ */
+BinaryTreeNode *ProcessTree(CompilerContext *ctx, BinaryTreeNode *root, SymbolStack *stack)
+{
+    compilerContext = ctx;
+    return process_block(root, stack);
+}
+
+BinaryTreeNode *process_block(BinaryTreeNode *root, SymbolStack *stack)
 {
     // * Base condition: If the root is NULL, return immediately
     if (root == NULL)
@@ -660,32 +986,33 @@ BinaryTreeNode *ProcessTree(BinaryTreeNode *root, SymbolStack *stack)
         {
             node = node->right;
 
+            // * Empty block
+            if (node == NULL)
+                break;
+
             switch (node->tokenType)
             {
             case TOKEN_KEYWORD:
-                if (strcmp(node->strValue, "var") == 0) // Variable declaration
+                switch (node_keyword(node))
                 {
+                case KEYWORD_VAR:   // Variable declaration
+                case KEYWORD_CONST: // Constant declaration
                     process_var_declaration(node, stack);
-                }
-                else if (strcmp(node->strValue, "const") == 0) // Constant declaration
-                {
-                    process_var_declaration(node, stack);
-                }
-                else if (strcmp(node->strValue, "pub") == 0) // Function declaration
-                {
+                    break;
+                case KEYWORD_PUB: // Function declaration
                     process_func_def(node, stack);
-                }
-                else if (strcmp(node->strValue, "return") == 0) // Return statement
-                {
+                    break;
+                case KEYWORD_RETURN: // Return statement
+                    assign_expression_slots(node->left, stack);
                     return node; // Exit early if it's a return statement
-                }
-                else if (strcmp(node->strValue, "if") == 0) // If statement
-                {
+                case KEYWORD_IF: // If statement
                     process_if(node, stack);
-                }
-                else if (strcmp(node->strValue, "while") == 0) // While loop
-                {
+                    break;
+                case KEYWORD_WHILE: // While loop
                     process_while(node, stack);
+                    break;
+                default:
+                    break;
                 }
                 break;
 
@@ -698,6 +1025,10 @@ BinaryTreeNode *ProcessTree(BinaryTreeNode *root, SymbolStack *stack)
                 {
                     process_voidFunc(node, stack); // Process void function call
                 }
+                else if (node->right && node->right->tokenType == TOKEN_DOT) // Built-in function call (ifj.name)
+                {
+                    process_voidFunc(node, stack);
+                }
                 break;
 
             default:
@@ -26,6 +26,7 @@ void process_func_def(BinaryTreeNode *funcDefNode, SymbolStack *stack);
 Symbol *parse_parameters(BinaryTreeNode *paramsListNode);
 DataType process_func_return(BinaryTreeNode *returnNode, SymbolStack *stack);
 DataType process_validate_func_call(BinaryTreeNode *funcnode, SymbolStack *stack);
+DataType process_builtin_call(BinaryTreeNode *ifjNode, SymbolStack *stack);
 void process_voidFunc(BinaryTreeNode *node, SymbolStack *stack);
 
 // expressions
@@ -37,7 +38,9 @@ void process_while(BinaryTreeNode *Whilenode, SymbolStack *stack);
 
 void process_var_declaration(BinaryTreeNode *node, SymbolStack *stack);
 void process_identifier_assign(BinaryTreeNode *node, SymbolStack *stack);
-BinaryTreeNode *ProcessTree(BinaryTreeNode *root, SymbolStack *stack);
+BinaryTreeNode *process_block(BinaryTreeNode *root, SymbolStack *stack);
+BinaryTreeNode *ProcessTree(CompilerContext *ctx, BinaryTreeNode *root, SymbolStack *stack);
+void semantic_free();
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,185 @@
+/**
+ * @file server.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief Compile server listening on a Unix domain socket (main --server).
+ *
+ * @details The server stays resident, so repeated compilations do not pay for starting the process.
+ * Requests are served one after another (see protocol.h), each one by ifj_compile() or
+ * compile_to_stream(), which reset the whole compiler context before and after it, so a request never sees anything left by
+ * the previous one, not even after an error. Only the default mode is served, the IFJcode24
+ * program is returned as the command line compiler prints it.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "server.h"
+#include "protocol.h"
+#include "compiler.h"
+
+/**
+ * @brief Sends the answer: the exit code, the output and the error messages.
+ */
+static bool send_response(int fd, int exitCode, const char *out, size_t outLength, const char *err,
+                          size_t errLength)
+{
+    char header[PROTOCOL_HEADER_MAX];
+    int headerLength = snprintf(header, sizeof(header), "%d %zu %zu\n", exitCode, outLength, errLength);
+    return protocol_write_all(fd, header, (size_t)headerLength) && protocol_write_all(fd, out, outLength) &&
+           protocol_write_all(fd, err, errLength);
+}
+
+// An answer with only an error message, the request could not be compiled at all
+static void send_error(int fd, const char *message)
+{
+    send_response(fd, 99, "", 0, message, strlen(message));
+}
+
+/**
+ * @brief Compiles the source of a request.
+ *
+ * @details SOURCE is compiled from the request body in memory, PATH names a file the server opens.
+ *
+ * @return Exit code of the compilation.
+ */
+static int compile_request(const char *kind, const char *body, size_t length, FILE *out, FILE *err)
+{
+    CompilerContext context = {.diagnostics = err};
+    if (strcmp(kind, "SOURCE") == 0)
+        return ifj_compile(&context, body, length, out);
+
+    FILE *source = fopen(body, "r");
+    if (!source)
+    {
+        fprintf(err, "Cannot open file %s\n", body);
+        return 99;
+    }
+    int exitCode = compile_to_stream(&context, source, out);
+    fclose(source);
+    return exitCode;
+}
+
+/**
+ * @brief Serves one connection.
+ *
+ * @return False when the request asked the server to stop.
+ */
+static bool handle_request(int fd)
+{
+    char header[PROTOCOL_HEADER_MAX];
+    char kind[16];
+    size_t length;
+
+    if (!protocol_read_line(fd, header, sizeof(header)) || sscanf(header, "%15s %zu", kind, &length) != 2 ||
+        (strcmp(kind, "SOURCE") != 0 && strcmp(kind, "PATH") != 0 && strcmp(kind, "QUIT") != 0))
+    {
+        send_error(fd, "server: malformed request\n");
+        return true;
+    }
+    if (strcmp(kind, "QUIT") == 0)
+    {
+        send_response(fd, 0, "", 0, "", 0);
+        return false;
+    }
+    if (length > PROTOCOL_REQUEST_MAX || (strcmp(kind, "PATH") == 0 && length >= 4096))
+    {
+        send_error(fd, "server: request too large\n");
+        return true;
+    }
+
+    char *body = malloc(length + 1);
+    if (!body)
+    {
+        send_error(fd, "server: out of memory\n");
+        return true;
+    }
+    if (!protocol_read_all(fd, body, length))
+    {
+        free(body);
+        return true;
+    }
+    body[length] = '\0';
+
+    char *out = NULL, *err = NULL;
+    size_t outLength = 0, errLength = 0;
+    FILE *outStream = open_memstream(&out, &outLength);
+    FILE *errStream = open_memstream(&err, &errLength);
+    if (outStream && errStream)
+    {
+        int exitCode = compile_request(kind, body, length, outStream, errStream);
+        // Closing the streams finishes their buffers
+        fclose(outStream);
+        fclose(errStream);
+        send_response(fd, exitCode, out, outLength, err, errLength);
+    }
+    else
+    {
+        if (outStream)
+            fclose(outStream);
+        if (errStream)
+            fclose(errStream);
+        send_error(fd, "server: out of memory\n");
+    }
+    free(out);
+    free(err);
+    free(body);
+    return true;
+}
+
+/**
+ * @brief Serves compile requests on the socket until a QUIT request.
+ *
+ * @details A stale socket file left by a server that did not stop cleanly is replaced.
+ *
+ * @return The exit code of the server process.
+ */
+int server_run(const char *socketPath)
+{
+    struct sockaddr_un address;
+    if (strlen(socketPath) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "server: socket path %s is too long\n", socketPath);
+        return 99;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath);
+
+    // A client that disconnects early must not kill the server
+    signal(SIGPIPE, SIG_IGN);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        perror("server: socket");
+        return 99;
+    }
+    unlink(socketPath);
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(listener, 16) < 0)
+    {
+        perror("server: bind");
+        close(listener);
+        return 99;
+    }
+    fprintf(stderr, "server: listening on %s\n", socketPath);
+
+    bool running = true;
+    while (running)
+    {
+        int client = accept(listener, NULL, NULL);
+        if (client < 0)
+            continue;
+        running = handle_request(client);
+        close(client);
+    }
+
+    close(listener);
+    unlink(socketPath);
+    return 0;
+}
@@ -0,0 +1,12 @@
+/**
+ * @file server.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief Compile server listening on a Unix domain socket (main --server).
+ */
+#ifndef SERVER_H
+#define SERVER_H
+
+int server_run(const char *socketPath);
+
+#endif
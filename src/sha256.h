@@ -0,0 +1,32 @@
+/**
+ * @file sha256.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief SHA-256 (FIPS 180-4), the keys of the compilation cache.
+ */
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_DIGEST_SIZE 32
+#define SHA256_HEX_SIZE (2 * SHA256_DIGEST_SIZE + 1)
+
+/**
+ * @brief State of an incremental hash.
+ */
+typedef struct
+{
+    uint32_t state[8];
+    uint64_t length;       // Bytes hashed so far
+    unsigned char block[64];
+    size_t blockLength;    // Bytes waiting in block
+} Sha256;
+
+void sha256_init(Sha256 *hash);
+void sha256_update(Sha256 *hash, const void *data, size_t length);
+void sha256_final(Sha256 *hash, unsigned char digest[SHA256_DIGEST_SIZE]);
+void sha256_hex(const unsigned char digest[SHA256_DIGEST_SIZE], char hex[SHA256_HEX_SIZE]);
+
+#endif
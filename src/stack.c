@@ -9,6 +9,7 @@
 #include <string.h>
 
 #include "stack.h"
+#include "context.h"
 
 // Init stack
 
@@ -20,7 +21,7 @@ void initStack(Stack *s, TypeOfData type)
     s->top = (Stack_item *)malloc(sizeof(Stack_item));
     if (s->top == NULL)
     {
-        fprintf(stderr, "Chyba: malloc initStack.\n");
+        fprintf(compiler_diagnostics(), "Chyba: malloc initStack.\n");
         exit(EXIT_FAILURE);
     }
     // Pointers
@@ -33,7 +34,7 @@ void initStack(Stack *s, TypeOfData type)
     s->top->data.token_type = TOKEN_EMPTY;
     if (!dynamic_string_init(&s->top->data.token_val.valueString))
     {
-        fprintf(stderr, "Chyba: dynamic string init.\n");
+        fprintf(compiler_diagnostics(), "Chyba: dynamic string init.\n");
         exit(EXIT_FAILURE);
     }
     dynamic_string_add_char(&s->top->data.token_val.valueString, '$');
@@ -56,7 +57,7 @@ void push(Stack *s, const Stack_item item)
     Stack_item *newItem = (Stack_item *)malloc(sizeof(Stack_item));
     if (newItem == NULL)
     {
-        fprintf(stderr, "Chyba: Pokus o push zásobníka.\n");
+        fprintf(compiler_diagnostics(), "Chyba: Pokus o push zásobníka.\n");
         exit(EXIT_FAILURE);
     }
     // Pointers
@@ -82,17 +83,17 @@ void pushAfterTerminal(Stack *s, const Stack_item item)
     else
     {
         Stack_item *tmp = s->top;
-        Stack_item *newItem = (Stack_item *)malloc(sizeof(Stack_item));
-        if (newItem == NULL)
-        {
-            fprintf(stderr, "Chyba: Pokus o push zásobníka.\n");
-            exit(EXIT_FAILURE);
-        }
         // Shift pointer to the terminal
         if (isTerminal(tmp))
             push(s, item);
         else
         {
+            Stack_item *newItem = (Stack_item *)malloc(sizeof(Stack_item));
+            if (newItem == NULL)
+            {
+                fprintf(compiler_diagnostics(), "Chyba: Pokus o push zásobníka.\n");
+                exit(EXIT_FAILURE);
+            }
             while (!isTerminal(tmp->prev))
                 tmp = tmp->prev;
             // Pointers
@@ -133,7 +134,7 @@ void getElement(Stack *s, Stack_item *retItem)
 {
     if (isEmpty(s->top))
     {
-        fprintf(stderr, "Chyba: Pokus o pop z prázdneho zásobníka.\n");
+        fprintf(compiler_diagnostics(), "Chyba: Pokus o pop z prázdneho zásobníka.\n");
         exit(EXIT_FAILURE);
     }
     retItem->type = s->top->type;
@@ -159,11 +160,13 @@ int topTerminal(Stack *s)
 }
 
 /// @brief Function for deallocation memory
+/// @details Only the string of the bottom item ("$" from initStack) belongs to the stack,
+/// the other items share the strings of the tokens and of the caller.
 /// @param s pointer to stack
 void freeStack(Stack *s)
 {
     // Dealloc string memory
-    dynamic_string_free(&s->top->data.token_val.valueString);
+    dynamic_string_free(&s->bottom->data.token_val.valueString);
 
     while (s->top != NULL)
     {
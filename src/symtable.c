@@ -8,6 +8,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include "symtable.h"
+#include "time_report.h"
+#include "context.h"
 
 // Utility Functions
 
@@ -31,6 +33,18 @@ void free_string(char *str)
     }
 }
 
+// Frees the parameter chain of a function symbol (see parse_parameters())
+static void free_params(Symbol *params)
+{
+    while (params)
+    {
+        Symbol *next = params->next;
+        free_string(params->name);
+        free(params);
+        params = next;
+    }
+}
+
 // DJB2 Hash Function
 // @https://theartincode.stanis.me/008-djb2/
 unsigned long djb2_hash(const char *str)
@@ -58,7 +72,7 @@ HashTable *create_hash_table()
     HashTable *table = malloc(sizeof(HashTable));
     if (!table)
     {
-        fprintf(stderr, "Error allocating memory for hash table.\n");
+        fprintf(compiler_diagnostics(), "Error allocating memory for hash table.\n");
         exit(EXIT_FAILURE);
     }
 
@@ -66,7 +80,7 @@ HashTable *create_hash_table()
     table->buckets = malloc(sizeof(Symbol *) * HASH_TABLE_SIZE);
     if (!table->buckets)
     {
-        fprintf(stderr, "Error allocating memory for hash table buckets.\n");
+        fprintf(compiler_diagnostics(), "Error allocating memory for hash table buckets.\n");
         free(table);
         exit(EXIT_FAILURE);
     }
@@ -89,7 +103,7 @@ void insert_hash_table(HashTable *table, const char *name, DataType type, void *
     Symbol *existing = search_hash_table(table, name);
     if (existing)
     {
-        fprintf(stderr, "Error: Redeclaration of symbol '%s'.\n", name);
+        fprintf(compiler_diagnostics(), "Error: Redeclaration of symbol '%s'.\n", name);
         return;
     }
 
@@ -97,7 +111,7 @@ void insert_hash_table(HashTable *table, const char *name, DataType type, void *
     Symbol *new_symbol = malloc(sizeof(Symbol));
     if (!new_symbol)
     {
-        fprintf(stderr, "Error allocating memory for symbol.\n");
+        fprintf(compiler_diagnostics(), "Error allocating memory for symbol.\n");
         exit(EXIT_FAILURE);
     }
 
@@ -107,6 +121,7 @@ void insert_hash_table(HashTable *table, const char *name, DataType type, void *
     new_symbol->isConst = isConst;
     new_symbol->isNull = isNull;
     new_symbol->isGlobal = isGlobal;
+    new_symbol->slot = -1;
     new_symbol->freturn_type = freturn_type;
 
     // If the value is not NULL, initialize the symbol's value based on its type
@@ -127,7 +142,7 @@ void insert_hash_table(HashTable *table, const char *name, DataType type, void *
             new_symbol->value.strValue = copy_string((char *)value);
             if (!new_symbol->value.strValue && type == TYPE_STRING)
             {
-                fprintf(stderr, "Error: Memory allocation failed for string value '%s'.\n", (char *)value);
+                fprintf(compiler_diagnostics(), "Error: Memory allocation failed for string value '%s'.\n", (char *)value);
                 free_string(new_symbol->name);
                 free(new_symbol);
                 return;
@@ -194,6 +209,10 @@ void delete_hash_table(HashTable *table, const char *name)
             {
                 free(current->value.strValue); // If the symbol is a string, free its value
             }
+            else if (current->type == TYPE_FUNCTION)
+            {
+                free_params(current->value.params); // The parameter chain belongs to the function
+            }
             free(current); // Free the symbol itself
             return;        // Done, exit the function
         }
@@ -219,6 +238,10 @@ void free_hash_table(HashTable *table)
             {
                 free(temp->value.strValue);
             }
+            else if (temp->type == TYPE_FUNCTION)
+            {
+                free_params(temp->value.params);
+            }
 
             // Finally, free the symbol itself
             free(temp);
@@ -239,7 +262,7 @@ SymbolStack *create_symbol_stack()
     SymbolStack *stack = malloc(sizeof(SymbolStack));
     if (!stack)
     {
-        fprintf(stderr, "Error allocating memory for symbol stack.\n");
+        fprintf(compiler_diagnostics(), "Error allocating memory for symbol stack.\n");
         exit(EXIT_FAILURE);
     }
 
@@ -252,7 +275,7 @@ void push_scope(SymbolStack *stack)
     Scope *new_scope = malloc(sizeof(Scope));
     if (!new_scope)
     {
-        fprintf(stderr, "Error allocating memory for new scope.\n");
+        fprintf(compiler_diagnostics(), "Error allocating memory for new scope.\n");
         exit(EXIT_FAILURE);
     }
 
@@ -265,7 +288,7 @@ void pop_scope(SymbolStack *stack)
 {
     if (stack->top == NULL)
     {
-        fprintf(stderr, "Error: No scope to pop.\n");
+        fprintf(compiler_diagnostics(), "Error: No scope to pop.\n");
         return;
     }
 
@@ -280,10 +303,11 @@ void insert_symbol_stack(SymbolStack *stack, const char *name, DataType type, vo
 {
     if (stack->top == NULL)
     {
-        fprintf(stderr, "Error: No active scope to insert symbol '%s'.\n", name);
+        fprintf(compiler_diagnostics(), "Error: No active scope to insert symbol '%s'.\n", name);
         return;
     }
     insert_hash_table(stack->top->table, name, type, value, isConst, isNull, isGlobal, freturn_type);
+    time_report_count(COUNTER_SYMBOLS, 1);
 }
 
 Symbol *search_symbol_stack(SymbolStack *stack, const char *name)
@@ -329,21 +353,21 @@ int upd_var_symbol_stack(SymbolStack *stack, Symbol *symbol, void *new_value, Da
         symbol->value.strValue = copy_string((char *)new_value); // Copy the new string
         if (!symbol->value.strValue)                             // Handle string memory allocation failure
         {
-            fprintf(stderr, "Error: Memory allocation failed for string value '%s'.\n", (char *)new_value);
+            fprintf(compiler_diagnostics(), "Error: Memory allocation failed for string value '%s'.\n", (char *)new_value);
             return -1; // Return -1 on failure
         }
         break;
 
     case TYPE_FUNCTION:
         // Function values should not be updated in this manner
-        fprintf(stderr, "Error: Cannot update function type variable '%s'.\n", symbol->name);
+        fprintf(compiler_diagnostics(), "Error: Cannot update function type variable '%s'.\n", symbol->name);
         return -1; // Return -1 for function type symbols
     case TYPE_NULL:
         break;
 
     default:
         // Handle unsupported types
-        fprintf(stderr, "Error: Unsupported type for variable '%s'.\n", symbol->name);
+        fprintf(compiler_diagnostics(), "Error: Unsupported type for variable '%s'.\n", symbol->name);
         return -1; // Return -1 for unsupported types
     }
 
@@ -354,7 +378,7 @@ void delete_symbol_stack(SymbolStack *stack, const char *name)
 {
     if (stack->top == NULL) // Check if there is no active scope
     {
-        fprintf(stderr, "Error: No active scope to delete symbol '%s'.\n", name);
+        fprintf(compiler_diagnostics(), "Error: No active scope to delete symbol '%s'.\n", name);
         return;
     }
     delete_hash_table(stack->top->table, name); // Delete the symbol from the current scope's hash table
@@ -367,4 +391,7 @@ void free_symbol_stack(SymbolStack *stack)
         pop_scope(stack); // Pop each scope and free its associated resources
     }
     free(stack); // Free the memory for the symbol stack itself
+    // Error paths free the stack before handle_error(), compile_to_stream() must not free it again
+    if (compilerContext && compilerContext->symbols == stack)
+        compilerContext->symbols = NULL;
 }
@@ -19,6 +19,7 @@ typedef struct Symbol
     bool isConst;          // Indicates if the symbol is a constant
     bool isNull;           // Indicates if the symbol currently holds a null value
     bool isGlobal;         // Indicates global variable
+    int slot;              // Frame slot of a local variable (-1 for globals and functions)
     union
     {
         int intValue;          // Integer value
@@ -6,8 +6,6 @@
  */
 #include "syntactic_analysis.h"
 
-static int infestNum = 0;
-static int scopeNum = 0;
 typedef enum
 {
     sStartExc,
@@ -19,8 +17,56 @@ typedef enum
     sErrorExc
 } ExpressionFSM;
 
+/** @brief Takes the next token that is not a comment or an end of line.
+ *  @details The token comes from the lexer thread with --pipeline (which drops comments itself), from get_token()
+ *  otherwise. The parser passes the strings of the tokens around by value, so they are not freed one by one: the
+ *  context keeps them until parser_free_tokens(), the tree has copies of them.
+ *  @param ctx Context of the compilation.
+ *  @param file A pointer to the file being analyzed.
+ *  @return The token
+ */
+Token parser_next_token(CompilerContext *ctx, FILE *file)
+{
+    Token token = ctx->tokens ? token_pipeline_next(ctx->tokens) : get_token(file);
+    while (token.type == TOKEN_COMMENT || token.type == TOKEN_EOL)
+    {
+        dynamic_string_free(&token.value.valueString);
+        token = ctx->tokens ? token_pipeline_next(ctx->tokens) : get_token(file);
+    }
+
+    if (ctx->tokenStringCount == ctx->tokenStringCapacity)
+    {
+        int capacity = ctx->tokenStringCapacity ? 2 * ctx->tokenStringCapacity : 256;
+        char **strings = realloc(ctx->tokenStrings, (size_t)capacity * sizeof(char *));
+        if (!strings)
+        {
+            dynamic_string_free(&token.value.valueString);
+            handle_error(ERR_COMPILER_INTERNAL);
+        }
+        ctx->tokenStrings = strings;
+        ctx->tokenStringCapacity = capacity;
+    }
+    ctx->tokenStrings[ctx->tokenStringCount++] = token.value.valueString.str;
+    return token;
+}
+
+/** @brief Frees the strings of all tokens taken by parser_next_token().
+ *  @details Called when the parse ends, also after an error.
+ *  @param ctx Context of the compilation.
+ */
+void parser_free_tokens(CompilerContext *ctx)
+{
+    for (int i = 0; i < ctx->tokenStringCount; i++)
+        free(ctx->tokenStrings[i]);
+    free(ctx->tokenStrings);
+    ctx->tokenStrings = NULL;
+    ctx->tokenStringCount = ctx->tokenStringCapacity = 0;
+}
+
 /** @brief Processes the FIRST rule in the syntactic analysis.
  *  @details First and the only one function called from main. Verifies part of code which is out of scope.
+ *  The tree is built in ctx, which becomes the current context of the thread (used by moveUp() and the other AST helpers).
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -29,9 +75,10 @@ typedef enum
  *  EXPRESSIONS;
  *  @endcode
  */
-bool FIRST(FILE *file)
+bool FIRST(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ FIRST ------\n");
+    compilerContext = ctx;
     Token token;
     GET_TOKEN_RAW(token, file);
     // Ends at the end of file (not at end of line)
@@ -41,21 +88,21 @@ bool FIRST(FILE *file)
     switch (token.keyword_val)
     {
     case KEYWORD_PUB:
-        insertRightMoveRight(currentNode, NODE_FUNC_DEF, token.type, token.value.valueString.str);
-        infestNum++;
-        if (!FN_DEF(file))
+        insertRightMoveRight(ctx->currentNode, NODE_FUNC_DEF, token.type, token.value.valueString.str);
+        ctx->infestNum++;
+        if (!FN_DEF(ctx, file))
             return false;
         break;
     case KEYWORD_VAR:
-        insertRightMoveRight(currentNode, NODE_VAR_DECL, token.type, token.value.valueString.str);
-        infestNum++;
-        if (!VAR_DEF(file))
+        insertRightMoveRight(ctx->currentNode, NODE_VAR_DECL, token.type, token.value.valueString.str);
+        ctx->infestNum++;
+        if (!VAR_DEF(ctx, file))
             return false;
         break;
     case KEYWORD_CONST:
-        insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-        infestNum++;
-        if (!CONST_DEF(file))
+        insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+        ctx->infestNum++;
+        if (!CONST_DEF(ctx, file))
             return false;
         break;
     default:
@@ -63,16 +110,17 @@ bool FIRST(FILE *file)
         return false;
         break;
     }
-    moveUp(infestNum);
-    infestNum = 0;
-    insertLeftMoveLeft(currentNode, NODE_GENERAL, TOKEN_EMPTY, "");
+    moveUp(ctx->infestNum);
+    ctx->infestNum = 0;
+    insertLeftMoveLeft(ctx->currentNode, NODE_GENERAL, TOKEN_EMPTY, "");
     // Recursive calling itself for processing next code out of scope
-    if (!FIRST(file))
+    if (!FIRST(ctx, file))
         return false;
     return true;
 }
 /** @brief Processes the commands, coditions, ...
  *  @details Fucntion is called in scope for verification part of code which is inside scope.
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -81,7 +129,7 @@ bool FIRST(FILE *file)
  *  EXPRESSIONS;
  *  @endcode
  */
-bool STATEMENT(FILE *file, int *infestNumLok)
+bool STATEMENT(CompilerContext *ctx, FILE *file, int *infestNumLok)
 {
     pmesg(" ------ STATEMENT ------\n");
     bool canShift = true;
@@ -92,9 +140,9 @@ bool STATEMENT(FILE *file, int *infestNumLok)
         return true;
     else if (token.type == TOKEN_IDENTIFIER)
     {
-        insertRightMoveRight(currentNode, NODE_VAR, token.type, token.value.valueString.str);
-        infestNum++;
-        if (!CALL_DEF(file))
+        insertRightMoveRight(ctx->currentNode, NODE_VAR, token.type, token.value.valueString.str);
+        ctx->infestNum++;
+        if (!CALL_DEF(ctx, file))
             return false;
     }
     else if(token.type == TOKEN_SEMICOLON)
@@ -107,45 +155,45 @@ bool STATEMENT(FILE *file, int *infestNumLok)
         switch (token.keyword_val)
         {
         case KEYWORD_CONST:
-            insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-            infestNum++;
-            if (!CONST_DEF(file))
+            insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+            ctx->infestNum++;
+            if (!CONST_DEF(ctx, file))
                 return false;
             break;
         case KEYWORD_VAR:
-            insertRightMoveRight(currentNode, NODE_VAR, token.type, token.value.valueString.str);
-            infestNum++;
-            if (!VAR_DEF(file))
+            insertRightMoveRight(ctx->currentNode, NODE_VAR, token.type, token.value.valueString.str);
+            ctx->infestNum++;
+            if (!VAR_DEF(ctx, file))
                 return false;
             break;
         case KEYWORD_IF:
-            insertRightMoveRight(currentNode, NODE_VAR, token.type, token.value.valueString.str);
-            infestNum++;
-            if (!IF_DEF(file))
+            insertRightMoveRight(ctx->currentNode, NODE_VAR, token.type, token.value.valueString.str);
+            ctx->infestNum++;
+            if (!IF_DEF(ctx, file))
                 return false;
             break;
         case KEYWORD_ELSE:
             moveUp(1);
             moveDownRight(1);
-            insertLeftMoveLeft(currentNode, NODE_VAR, token.type, token.value.valueString.str);
-            infestNum++;
-            if (!ELSE_DEF(file))
+            insertLeftMoveLeft(ctx->currentNode, NODE_VAR, token.type, token.value.valueString.str);
+            ctx->infestNum++;
+            if (!ELSE_DEF(ctx, file))
                 return false;
-            moveUp(infestNum + 1);
-            infestNum = 0;
+            moveUp(ctx->infestNum + 1);
+            ctx->infestNum = 0;
             canShift = false;
             moveDownLeft(1);
             break;
         case KEYWORD_WHILE:
-            insertRightMoveRight(currentNode, NODE_VAR, token.type, token.value.valueString.str);
-            infestNum++;
-            if (!WHILE_DEF(file))
+            insertRightMoveRight(ctx->currentNode, NODE_VAR, token.type, token.value.valueString.str);
+            ctx->infestNum++;
+            if (!WHILE_DEF(ctx, file))
                 return false;
             break;
         case KEYWORD_RETURN:
-            insertRightMoveRight(currentNode, NODE_VAR, token.type, token.value.valueString.str);
-            infestNum++;
-            if (!RET_DEF(file))
+            insertRightMoveRight(ctx->currentNode, NODE_VAR, token.type, token.value.valueString.str);
+            ctx->infestNum++;
+            if (!RET_DEF(ctx, file))
                 return false;
             break;
         default:
@@ -158,20 +206,21 @@ bool STATEMENT(FILE *file, int *infestNumLok)
     if (canShift)
     {
         // Create new general_node for next command
-        moveUp(infestNum);
-        infestNum = 0;
-        insertLeftMoveLeft(currentNode, NODE_GENERAL, TOKEN_EMPTY, "");
+        moveUp(ctx->infestNum);
+        ctx->infestNum = 0;
+        insertLeftMoveLeft(ctx->currentNode, NODE_GENERAL, TOKEN_EMPTY, "");
         // Number of all commands in SCOPE
         *infestNumLok = *infestNumLok + 1;
     }
     pmesg(" ------ END STATEMENT ------\n");
     // Recursive calling itself for processing next code out of scope
-    if (!STATEMENT(file, infestNumLok))
+    if (!STATEMENT(ctx, file, infestNumLok))
         return false;
     return true;
 }
 
 /** @brief Processes command for variable declaration
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -180,14 +229,14 @@ bool STATEMENT(FILE *file, int *infestNumLok)
  *  EXPRESSIONS;
  *  @endcode
  */
-bool VAR_DEF(FILE *file)
+bool VAR_DEF(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ VARDEF ------\n");
     Token token;
     // var id
     GET_TOKEN_RAW(token, file);
-    insertRightMoveRight(currentNode, NODE_VAR, token.type, token.value.valueString.str);
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_VAR, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.type != TOKEN_IDENTIFIER)
         return false;
     GET_TOKEN_RAW(token, file);
@@ -198,17 +247,17 @@ bool VAR_DEF(FILE *file)
         return true;
     // var id : ASSIGN_VAR
     case TOKEN_COLON:
-        insertRightMoveRight(currentNode, NODE_VAR, token.type, token.value.valueString.str);
-        infestNum++;
-        if (!ASSIGN_VAR(file))
+        insertRightMoveRight(ctx->currentNode, NODE_VAR, token.type, token.value.valueString.str);
+        ctx->infestNum++;
+        if (!ASSIGN_VAR(ctx, file))
             return false;
         break;
     // var id = EXP;
     case TOKEN_ASSIGNMENT:
-        insertRightMoveRight(currentNode, NODE_VAR, token.type, token.value.valueString.str);
-        infestNum++;
+        insertRightMoveRight(ctx->currentNode, NODE_VAR, token.type, token.value.valueString.str);
+        ctx->infestNum++;
         GET_TOKEN_RAW(token, file);
-        if (!EXPRESSION(file, token))
+        if (!EXPRESSION(ctx, file, token))
             return false;
         break;
     default:
@@ -219,6 +268,7 @@ bool VAR_DEF(FILE *file)
     return true;
 }
 /** @brief Processes command for constant declaration
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -227,40 +277,40 @@ bool VAR_DEF(FILE *file)
  *  EXPRESSIONS;
  *  @endcode
  */
-bool CONST_DEF(FILE *file)
+bool CONST_DEF(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ CONST_DEF ------\n");
     Token token;
     // const id
     GET_TOKEN_RAW(token, file);
-    insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.type != TOKEN_IDENTIFIER)
         return false;
     // const id =
     GET_TOKEN_RAW(token, file);
-    insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.type == TOKEN_ASSIGNMENT)
     {
-        if (!ASSIGN_CONST(file))
+        if (!ASSIGN_CONST(ctx, file))
             return false;
     }
     // const id : i32 = EXP
     else if (token.type == TOKEN_COLON)
     {
         GET_TOKEN_RAW(token, file);
-        insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-        infestNum++;
+        insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+        ctx->infestNum++;
         if (!VAL_TYPE(token))
             return false;
         GET_TOKEN_RAW(token, file);
-        insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-        infestNum++;
+        insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+        ctx->infestNum++;
         if (token.type != TOKEN_ASSIGNMENT)
             return false;
         GET_TOKEN_RAW(token, file);
-        if (!EXPRESSION(file, token))
+        if (!EXPRESSION(ctx, file, token))
             return false;
     }
     else
@@ -269,6 +319,7 @@ bool CONST_DEF(FILE *file)
     return true;
 }
 /** @brief Processes function declaration
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -277,54 +328,55 @@ bool CONST_DEF(FILE *file)
  *  EXPRESSIONS;
  *  @endcode
  */
-bool FN_DEF(FILE *file)
+bool FN_DEF(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ FN_DEF ------\n");
     Token token;
     // t_fn
     GET_TOKEN_RAW(token, file);
-    insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.keyword_val != KEYWORD_FN)
         return false;
     // t_ID
     GET_TOKEN_RAW(token, file);
-    insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.type != TOKEN_IDENTIFIER)
         return false;
     // t_(
     GET_TOKEN_RAW(token, file);
-    insertLeftMoveLeft(currentNode, NODE_CONST, token.type, token.value.valueString.str);
+    insertLeftMoveLeft(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
     if (token.type != TOKEN_LPAREN)
         return false;
     // Parametre
-    int tmpinf = infestNum;
-    infestNum = 1;
-    if (!PARAM(file))
+    int tmpinf = ctx->infestNum;
+    ctx->infestNum = 1;
+    if (!PARAM(ctx, file))
         return false;
-    moveUp(infestNum);
-    infestNum = tmpinf;
+    moveUp(ctx->infestNum);
+    ctx->infestNum = tmpinf;
     // Return type
     GET_TOKEN_RAW(token, file);
-    insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (!FN_TYPE(token))
         return false;
     // t_{
     GET_TOKEN_RAW(token, file);
-    insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.type == TOKEN_CURLYL_BRACKET)
     {
         // SCOPE
-        if (!SCOPE(file))
+        if (!SCOPE(ctx, file))
             return false;
     }
 
     return true;
 }
 /** @brief Processes if condition
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -333,30 +385,31 @@ bool FN_DEF(FILE *file)
  *  EXPRESSIONS;
  *  @endcode
  */
-bool IF_DEF(FILE *file)
+bool IF_DEF(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ IF_DEF ------\n");
     Token token;
-    insertRightMoveRight(currentNode, NODE_IF, TOKEN_EMPTY, "AUX");
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_IF, TOKEN_EMPTY, "AUX");
+    ctx->infestNum++;
     // t_(
     GET_TOKEN_RAW(token, file);
-    insertLeftMoveLeft(currentNode, NODE_IF, token.type, token.value.valueString.str);
-    infestNum++;
+    insertLeftMoveLeft(ctx->currentNode, NODE_IF, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.type != TOKEN_LPAREN)
         return false;
     // if(EXP)
     GET_TOKEN_RAW(token, file);
-    if (!EXPRESSION(file, token))
+    if (!EXPRESSION(ctx, file, token))
         return false;
     // if(EXP)|ID|
-    if (!IF_EXT(file))
+    if (!IF_EXT(ctx, file))
         return false;
     pmesg(" ------ END IF_DEF ------\n");
     return true;
 }
 /** @brief Processes else condition
  *  @note Works as preprocessing function for IF_EXT()
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -365,24 +418,25 @@ bool IF_DEF(FILE *file)
  *  EXPRESSIONS;
  *  @endcode
  */
-bool ELSE_DEF(FILE *file)
+bool ELSE_DEF(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ ELSE_DEF ------\n");
     Token token;
     // t_{
     GET_TOKEN_RAW(token, file);
-    insertRightMoveRight(currentNode, NODE_VAR, token.type, token.value.valueString.str);
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_VAR, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.type == TOKEN_CURLYL_BRACKET)
     {
         // SCOPE
-        if (!SCOPE(file))
+        if (!SCOPE(ctx, file))
             return false;
     }
     pmesg(" ------ END ELSE_DEF ------\n");
     return true;
 }
 /** @brief Processes while loop
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -391,27 +445,28 @@ bool ELSE_DEF(FILE *file)
  *  EXPRESSIONS;
  *  @endcode
  */
-bool WHILE_DEF(FILE *file)
+bool WHILE_DEF(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ WHILE_DEF ------\n");
     Token token;
     // t_(
     GET_TOKEN_RAW(token, file);
-    insertLeftMoveLeft(currentNode, NODE_IF, token.type, token.value.valueString.str);
-    infestNum++;
+    insertLeftMoveLeft(ctx->currentNode, NODE_IF, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.type != TOKEN_LPAREN)
         return false;
     // while(EXP)
     GET_TOKEN_RAW(token, file);
-    if (!EXPRESSION(file, token))
+    if (!EXPRESSION(ctx, file, token))
         return false;
     // while(EXP)|ID|
-    if (!IF_EXT(file))
+    if (!IF_EXT(ctx, file))
         return false;
     pmesg(" ------ END WHILE_DEF ------\n");
     return true;
 }
 /** @brief Processes return command
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -420,18 +475,19 @@ bool WHILE_DEF(FILE *file)
  *  EXPRESSIONS;
  *  @endcode
  */
-bool RET_DEF(FILE *file)
+bool RET_DEF(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ RET_DEF ------\n");
     Token token;
     GET_TOKEN_RAW(token, file);
-    if (!EXPRESSION(file, token))
+    if (!EXPRESSION(ctx, file, token))
         return false;
     pmesg(" ------ END RET_DEF ------\n");
     return true;
 }
 /** @brief Processes calling functions, variables
  *  @note Works as preprocessing function for IF_EXT()
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -440,10 +496,10 @@ bool RET_DEF(FILE *file)
  *  EXPRESSIONS;
  *  @endcode
  */
-bool CALL_DEF(FILE *file)
+bool CALL_DEF(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ CALL_DEF ------\n");
-    if (!CALL_EXT(file, false))
+    if (!CALL_EXT(ctx, file, false))
         return false;
     pmesg(" ------ END CALL_DEF ------\n");
     return true;
@@ -451,6 +507,7 @@ bool CALL_DEF(FILE *file)
 
 /** @brief Extended function for CALL_DEF()
  *  @details Processes functions arguments or assignment to a variable (= EXPRESSION)
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -459,7 +516,7 @@ bool CALL_DEF(FILE *file)
  *  EXPRESSIONS;
  *  @endcode
  */
-bool IF_EXT(FILE *file)
+bool IF_EXT(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ IF_EXT ------\n");
     Token token;
@@ -469,14 +526,14 @@ bool IF_EXT(FILE *file)
     {
         moveDownRight(1);
         moveDownLeft(1);
-        infestNum++;
-        insertRightMoveRight(currentNode, NODE_IF, token.type, token.value.valueString.str);
+        ctx->infestNum++;
+        insertRightMoveRight(ctx->currentNode, NODE_IF, token.type, token.value.valueString.str);
         GET_TOKEN_RAW(token, file);
-        insertRightMoveRight(currentNode, NODE_IF, token.type, token.value.valueString.str);
+        insertRightMoveRight(ctx->currentNode, NODE_IF, token.type, token.value.valueString.str);
         if (token.type != TOKEN_IDENTIFIER)
             return false;
         GET_TOKEN_RAW(token, file);
-        insertRightMoveRight(currentNode, NODE_IF, token.type, token.value.valueString.str);
+        insertRightMoveRight(ctx->currentNode, NODE_IF, token.type, token.value.valueString.str);
         if (token.type != TOKEN_PIPE)
             return false;
         moveUp(4);
@@ -485,15 +542,15 @@ bool IF_EXT(FILE *file)
     else
     {
         moveDownRight(1);
-        infestNum++;
+        ctx->infestNum++;
     }
     // SCOPE
     // TODO posuvanie nizsie lebo nieco pravdepodobne v expressions to dava velmi vysoko
-    insertRightMoveRight(currentNode, NODE_IF, token.type, token.value.valueString.str);
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_IF, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.type == TOKEN_CURLYL_BRACKET)
     {
-        if (!SCOPE(file))
+        if (!SCOPE(ctx, file))
             return false;
     }
     else
@@ -503,6 +560,7 @@ bool IF_EXT(FILE *file)
 }
 /** @brief Extended function for CALL_DEF()
  *  @details Processes functions arguments or assignment to a variable (= EXPRESSION)
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -511,14 +569,14 @@ bool IF_EXT(FILE *file)
  *  EXPRESSIONS;
  *  @endcode
  */
-bool CALL_EXT(FILE *file, bool isAlreadyFn)
+bool CALL_EXT(CompilerContext *ctx, FILE *file, bool isAlreadyFn)
 {
     pmesg(" ------ CALL_EXT ------\n");
     Token token;
     // Function call from Expression
     if (isAlreadyFn)
     {
-        if (!ARG(file))
+        if (!ARG(ctx, file))
             return false;
         GET_TOKEN_RAW(token, file);
         if (token.type != TOKEN_SEMICOLON)
@@ -530,9 +588,9 @@ bool CALL_EXT(FILE *file, bool isAlreadyFn)
         // Function call
         if (token.type == TOKEN_LPAREN)
         {
-            insertLeftMoveLeft(currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
-            infestNum++;
-            if (!ARG(file))
+            insertLeftMoveLeft(ctx->currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
+            ctx->infestNum++;
+            if (!ARG(ctx, file))
                 return false;
             GET_TOKEN_RAW(token, file);
             if (token.type != TOKEN_SEMICOLON)
@@ -541,36 +599,36 @@ bool CALL_EXT(FILE *file, bool isAlreadyFn)
         // Assignment to a variable
         else if (token.type == TOKEN_ASSIGNMENT)
         {
-            insertRightMoveRight(currentNode, NODE_VAR, token.type, token.value.valueString.str);
-            infestNum++;
+            insertRightMoveRight(ctx->currentNode, NODE_VAR, token.type, token.value.valueString.str);
+            ctx->infestNum++;
             GET_TOKEN_RAW(token, file);
-            if (!EXPRESSION(file, token))
+            if (!EXPRESSION(ctx, file, token))
                 return false;
         }
         else if (token.type == TOKEN_COLON)
         {
-            insertRightMoveRight(currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
-            infestNum++;
+            insertRightMoveRight(ctx->currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
+            ctx->infestNum++;
             GET_TOKEN_RAW(token, file);
-            insertRightMoveRight(currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
-            infestNum++;
+            insertRightMoveRight(ctx->currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
+            ctx->infestNum++;
             if (!VAL_TYPE(token))
                 return false;
             GET_TOKEN_RAW(token, file);
-            insertRightMoveRight(currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
-            infestNum++;
+            insertRightMoveRight(ctx->currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
+            ctx->infestNum++;
             if (token.type != TOKEN_ASSIGNMENT)
                 return false;
             GET_TOKEN_RAW(token, file);
-            if (!EXPRESSION(file, token))
+            if (!EXPRESSION(ctx, file, token))
                 return false;
         }
         // Object function
         else if (token.type == TOKEN_DOT)
         {
-            insertRightMoveRight(currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
-            infestNum++;
-            if (!CALL_OBJ(file))
+            insertRightMoveRight(ctx->currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
+            ctx->infestNum++;
+            if (!CALL_OBJ(ctx, file))
                 return false;
         }
         else
@@ -581,6 +639,7 @@ bool CALL_EXT(FILE *file, bool isAlreadyFn)
 }
 /** @brief Extended function for CALL_EXT()
  *  @details Processes build in functions with object type 
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -589,24 +648,24 @@ bool CALL_EXT(FILE *file, bool isAlreadyFn)
  *  EXPRESSIONS;
  *  @endcode
  */
-bool CALL_OBJ(FILE *file)
+bool CALL_OBJ(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ CALL_OBJ ------\n");
     Token token;
     // t_id
     GET_TOKEN_RAW(token, file);
-    insertRightMoveRight(currentNode, NODE_VAR, token.type, token.value.valueString.str);
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_VAR, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.type != TOKEN_IDENTIFIER)
         return false;
     // t_(
     GET_TOKEN_RAW(token, file);
-    insertLeftMoveLeft(currentNode, NODE_VAR, token.type, token.value.valueString.str);
-    infestNum++;
+    insertLeftMoveLeft(ctx->currentNode, NODE_VAR, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.type != TOKEN_LPAREN)
         return false;
     // Arguments
-    if (!ARG(file))
+    if (!ARG(ctx, file))
         return false;
     // t_;
     GET_TOKEN_RAW(token, file);
@@ -618,6 +677,7 @@ bool CALL_OBJ(FILE *file)
 
 /** @brief Processes assigning expresions to the variable
  *  @details
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -626,31 +686,32 @@ bool CALL_OBJ(FILE *file)
  *  EXPRESSIONS;
  *  @endcode
  */
-bool ASSIGN_VAR(FILE *file)
+bool ASSIGN_VAR(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ ASSIGN_VAR ------\n");
     Token token;
     // var result : i32 ...
     GET_TOKEN_RAW(token, file);
-    insertRightMoveRight(currentNode, NODE_VAR, token.type, token.value.valueString.str);
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_VAR, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (!VAL_TYPE(token))
         return false;
     // var result : i32 = ...
     GET_TOKEN_RAW(token, file);
-    insertRightMoveRight(currentNode, NODE_VAR, token.type, token.value.valueString.str);
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_VAR, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.type != TOKEN_ASSIGNMENT)
         return false;
     // var result : i32 = 0;
     GET_TOKEN_RAW(token, file);
-    if (!EXPRESSION(file, token))
+    if (!EXPRESSION(ctx, file, token))
         return false;
     pmesg(" ------ END ASSIGN_VAR ------\n");
     return true;
 }
 /** @brief Processes assigning expresions to the constant
  *  @details Processes functions arguments or assignment to a variable (= EXPRESSION)
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -659,7 +720,7 @@ bool ASSIGN_VAR(FILE *file)
  *  EXPRESSIONS;
  *  @endcode
  */
-bool ASSIGN_CONST(FILE *file)
+bool ASSIGN_CONST(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ ASSIGN_CONST ------\n");
     Token token;
@@ -669,31 +730,31 @@ bool ASSIGN_CONST(FILE *file)
     {
     // @import("ifj24.zig");
     case TOKEN_IMPORT:
-        insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-        infestNum++;
+        insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+        ctx->infestNum++;
         GET_TOKEN_RAW(token, file);
-        insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-        infestNum++;
+        insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+        ctx->infestNum++;
         if (token.type != TOKEN_LPAREN)
             return false;
         GET_TOKEN_RAW(token, file);
-        insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-        infestNum++;
+        insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+        ctx->infestNum++;
         if (token.type != TOKEN_STRING_LITERAL)
             return false;
         GET_TOKEN_RAW(token, file);
-        insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-        infestNum++;
+        insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+        ctx->infestNum++;
         if (token.type != TOKEN_RPAREN)
             return false;
         GET_TOKEN_RAW(token, file);
-        insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-        infestNum++;
+        insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+        ctx->infestNum++;
         if (token.type != TOKEN_SEMICOLON)
             return false;
         break;
     default:
-        if (!EXPRESSION(file, token))
+        if (!EXPRESSION(ctx, file, token))
             return false;
         break;
     }
@@ -703,6 +764,7 @@ bool ASSIGN_CONST(FILE *file)
 
 /** @brief Function for determining the depth of infestation
  *  @details In scope are Statements. Everything which can be between {} except declaration of functions.
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -712,27 +774,28 @@ bool ASSIGN_CONST(FILE *file)
  *  @endcode
  *  @todo Nefunkcny scope len na jeden riadok (bez {})
  */
-bool SCOPE(FILE *file)
+bool SCOPE(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ SCOPE ------\n");
-    insertLeftMoveLeft(currentNode, NODE_GENERAL, TOKEN_EMPTY, "");
-    infestNum++;
+    insertLeftMoveLeft(ctx->currentNode, NODE_GENERAL, TOKEN_EMPTY, "");
+    ctx->infestNum++;
     // Defined parametrers of infestation
-    int tmp = infestNum;
+    int tmp = ctx->infestNum;
     int tmpLokinfest = 0;
-    infestNum = 0;
-    scopeNum++;
-    if (!STATEMENT(file, &tmpLokinfest))
+    ctx->infestNum = 0;
+    ctx->scopeNum++;
+    if (!STATEMENT(ctx, file, &tmpLokinfest))
         return false;
-    // printf("SCOPE inf = %d\n", infestNum);
-    // printf("SCOPE num = %d\n", scopeNum);
+    // printf("SCOPE inf = %d\n", ctx->infestNum);
+    // printf("SCOPE num = %d\n", ctx->scopeNum);
     moveUp(tmpLokinfest);
-    scopeNum--;
-    infestNum = tmp;
+    ctx->scopeNum--;
+    ctx->infestNum = tmp;
     pmesg(" ------ END SCOPE ------\n");
     return true;
 }
 /** @brief Function for processing parameters of declaraced function
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -743,14 +806,14 @@ bool SCOPE(FILE *file)
  *  @endcode
  *  @todo x : []u8, y : []u8
  */
-bool PARAM(FILE *file)
+bool PARAM(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ PARAM ------\n");
     Token token;
     // t_) (end of recursion)
     GET_TOKEN_RAW(token, file);
-    insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.type == TOKEN_RPAREN)
         return true;
 
@@ -760,31 +823,31 @@ bool PARAM(FILE *file)
     case TOKEN_IDENTIFIER:
         // : u8
         GET_TOKEN_RAW(token, file);
-        insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-        infestNum++;
+        insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+        ctx->infestNum++;
         if (token.type != TOKEN_COLON)
             return false;
         GET_TOKEN_RAW(token, file);
-        insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-        infestNum++;
+        insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+        ctx->infestNum++;
         if (!VAL_TYPE(token))
             return false;
         break;
     case TOKEN_COMMA:
         // , y : u8
         GET_TOKEN_RAW(token, file);
-        insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-        infestNum++;
+        insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+        ctx->infestNum++;
         if (token.type != TOKEN_IDENTIFIER)
             return false;
         GET_TOKEN_RAW(token, file);
-        insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-        infestNum++;
+        insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+        ctx->infestNum++;
         if (token.type != TOKEN_COLON)
             return false;
         GET_TOKEN_RAW(token, file);
-        insertRightMoveRight(currentNode, NODE_CONST, token.type, token.value.valueString.str);
-        infestNum++;
+        insertRightMoveRight(ctx->currentNode, NODE_CONST, token.type, token.value.valueString.str);
+        ctx->infestNum++;
         if (!VAL_TYPE(token))
             return false;
         break;
@@ -793,13 +856,14 @@ bool PARAM(FILE *file)
         break;
     }
     // Next parameter
-    if (!PARAM(file))
+    if (!PARAM(ctx, file))
         return false;
     pmesg(" ------ END PARAM ------\n");
     return true;
 }
 
 /** @brief Function for processing argument of called function
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -809,16 +873,16 @@ bool PARAM(FILE *file)
  *  EXPRESSION
  *  @endcode
  */
-bool ARG(FILE *file)
+bool ARG(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ ARG ------\n");
     Token token;
     GET_TOKEN_RAW(token, file);
-    insertRightMoveRight(currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.type == TOKEN_IDENTIFIER || token.type == TOKEN_STRING_LITERAL || token.type == TOKEN_INT_LITERAL || token.type == TOKEN_FLOAT_LITERAL)
     {
-        if (!ARGS(file))
+        if (!ARGS(ctx, file))
             return false;
     }
     else if (token.type == TOKEN_RPAREN)
@@ -830,6 +894,7 @@ bool ARG(FILE *file)
 }
 /** @brief Function for processing another argument which is in queue
  *  @details First argument is processed in ARG() but after that should be character ",". That sequence is repeaded unltil ")"
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -838,18 +903,18 @@ bool ARG(FILE *file)
  *  t_,
  *  @endcode
  */
-bool ARGS(FILE *file)
+bool ARGS(CompilerContext *ctx, FILE *file)
 {
     pmesg(" ------ ARGS ------\n");
     Token token;
     GET_TOKEN_RAW(token, file);
-    insertRightMoveRight(currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
-    infestNum++;
+    insertRightMoveRight(ctx->currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
+    ctx->infestNum++;
     if (token.type == TOKEN_RPAREN)
         return true;
     if (token.type == TOKEN_COMMA)
     {
-        if (!ARG(file))
+        if (!ARG(ctx, file))
             return false;
     }
     else
@@ -859,10 +924,21 @@ bool ARGS(FILE *file)
     return true;
 }
 
+// Frees the stacks of EXPRESSION() and the strings of its "<" and "E" items
+static void expression_free(Stack *precStack, Stack *ruleStack, Dynamic_string *varLexThan,
+                            Dynamic_string *varNotTerminal)
+{
+    freeStack(precStack);
+    freeStack(ruleStack);
+    dynamic_string_free(varLexThan);
+    dynamic_string_free(varNotTerminal);
+}
+
 /** @brief Function for processing another argument which is in queue
  *  @warning First token is passed by argument (FIX)
  *  @details It ends when ";" or ")" . Also works: ((2+3)*6)-9; Also works: factorial(256*(56-7));
  *  @note It can ends with ")" because of declaration of function
+ *  @param ctx Context of the compilation.
  *  @param file A pointer to the file being analyzed.
  *  @return If syntactic analysis pass return true otherwise false
  *  Use case:
@@ -873,7 +949,7 @@ bool ARGS(FILE *file)
  * @todo Problem pri const a = fn(a) + fn(b); (program ocakava za fn() znak ';')
  * @todo Fix first token
  */
-bool EXPRESSION(FILE *file, Token token)
+bool EXPRESSION(CompilerContext *ctx, FILE *file, Token token)
 {
     pmesg(" ------ EXPRESSION ------\n");
     Stack precStack; 
@@ -885,14 +961,14 @@ bool EXPRESSION(FILE *file, Token token)
     Dynamic_string varLexThan;
     if (!dynamic_string_init(&varLexThan))
     {
-        fprintf(stderr, "Chyba: dynamic string init.\n");
+        fprintf(compiler_diagnostics(), "Chyba: dynamic string init.\n");
         exit(EXIT_FAILURE);
     }
     dynamic_string_add_char(&varLexThan, '<');
     Dynamic_string varNotTerminal;
     if (!dynamic_string_init(&varNotTerminal))
     {
-        fprintf(stderr, "Chyba: dynamic string init.\n");
+        fprintf(compiler_diagnostics(), "Chyba: dynamic string init.\n");
         exit(EXIT_FAILURE);
     }
     dynamic_string_add_char(&varNotTerminal, 'E');
@@ -929,7 +1005,7 @@ bool EXPRESSION(FILE *file, Token token)
         if (tmp_char == EOF)
         {
             pmesg("ERROR FIND OP\n");
-            return false;
+            break;
         }
         // Reduction by the rule
         else if (tmp_char == '>')
@@ -1006,7 +1082,8 @@ bool EXPRESSION(FILE *file, Token token)
             if (!isExpressionCorrect)
             {
                 // printf("STATE = %d", state);
-                return false;
+                tmp_char = EOF;
+                break;
             }
             // pushing N-terminal
             curPrecItem.type = precedence;
@@ -1040,11 +1117,10 @@ bool EXPRESSION(FILE *file, Token token)
             curPrecItem.data.token_val.valueString = token.value.valueString;
             push(&precStack, curPrecItem);
         }
-        else{
-            // Deallocation memory
-            freeStack(&precStack);
-            freeStack(&ruleStack);
-            return false;
+        else
+        {
+            tmp_char = EOF;
+            break;
         }
 
         // It means that reduction was made and we want to  process same token
@@ -1055,22 +1131,22 @@ bool EXPRESSION(FILE *file, Token token)
             getElement(&precStack, &tmpLastItem);
             if (tmpLastItem.data.token_type == TOKEN_IDENTIFIER && token.type == TOKEN_DOT)
             {
-                insertRightMoveRight(currentNode, NODE_FUNC_CALL, tmpLastItem.data.token_type, tmpLastItem.data.token_val.valueString.str);
-                infestNum++;
-                insertRightMoveRight(currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
-                infestNum++;
-                if (!CALL_OBJ(file))
-                    return false;
+                insertRightMoveRight(ctx->currentNode, NODE_FUNC_CALL, tmpLastItem.data.token_type, tmpLastItem.data.token_val.valueString.str);
+                ctx->infestNum++;
+                insertRightMoveRight(ctx->currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
+                ctx->infestNum++;
+                if (!CALL_OBJ(ctx, file))
+                    tmp_char = EOF;
                 break;
             }
             else if (tmpLastItem.data.token_type == TOKEN_IDENTIFIER && token.type == TOKEN_LPAREN)
             {
-                insertRightMoveRight(currentNode, NODE_FUNC_CALL, tmpLastItem.data.token_type, tmpLastItem.data.token_val.valueString.str);
-                infestNum++;
-                insertLeftMoveLeft(currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
-                infestNum++;
-                if (!CALL_EXT(file, true))
-                    return false;
+                insertRightMoveRight(ctx->currentNode, NODE_FUNC_CALL, tmpLastItem.data.token_type, tmpLastItem.data.token_val.valueString.str);
+                ctx->infestNum++;
+                insertLeftMoveLeft(ctx->currentNode, NODE_FUNC_CALL, token.type, token.value.valueString.str);
+                ctx->infestNum++;
+                if (!CALL_EXT(ctx, file, true))
+                    tmp_char = EOF;
                 break;
             }
         }
@@ -1078,6 +1154,12 @@ bool EXPRESSION(FILE *file, Token token)
         find_OP(N, table, token, &precStack, &tmp_char, &numOfLPar);
     }
 
+    if (tmp_char == EOF)
+    {
+        expression_free(&precStack, &ruleStack, &varLexThan, &varNotTerminal);
+        return false;
+    }
+
     // Inserting into tree
     bool dirRight = true;
     int i = 0;
@@ -1089,53 +1171,52 @@ bool EXPRESSION(FILE *file, Token token)
             if (dirRight)
             {
                 if (i == 0)
-                    insertLeft(currentNode, NODE_VAR, curRuleItem.data.token_type, curRuleItem.data.token_val.valueString.str);
+                    insertLeft(ctx->currentNode, NODE_VAR, curRuleItem.data.token_type, curRuleItem.data.token_val.valueString.str);
                 else
                 {
-                    insertRight(currentNode, NODE_VAR, curRuleItem.data.token_type, curRuleItem.data.token_val.valueString.str);
+                    insertRight(ctx->currentNode, NODE_VAR, curRuleItem.data.token_type, curRuleItem.data.token_val.valueString.str);
                     dirRight = false;
                 }
             }
             else
             {
-                insertLeft(currentNode, NODE_VAR, curRuleItem.data.token_type, curRuleItem.data.token_val.valueString.str);
+                insertLeft(ctx->currentNode, NODE_VAR, curRuleItem.data.token_type, curRuleItem.data.token_val.valueString.str);
                 while (!moveUp(0))
                 {
                     // printf("_________HERE_______ : %s\n", curRuleItem.data.token_val.valueString.str);
                     moveUp(1);
-                    infestNum--;
+                    ctx->infestNum--;
                 }
                 moveUp(1);
-                infestNum--;
+                ctx->infestNum--;
             }
         }
         else
         {
             if (i == 0)
-                insertLeftMoveLeft(currentNode, NODE_OP, curRuleItem.data.token_type, curRuleItem.data.token_val.valueString.str);
+                insertLeftMoveLeft(ctx->currentNode, NODE_OP, curRuleItem.data.token_type, curRuleItem.data.token_val.valueString.str);
             else if (dirRight)
-                insertRightMoveRight(currentNode, NODE_OP, curRuleItem.data.token_type, curRuleItem.data.token_val.valueString.str);
+                insertRightMoveRight(ctx->currentNode, NODE_OP, curRuleItem.data.token_type, curRuleItem.data.token_val.valueString.str);
             else
             {
-                insertLeftMoveLeft(currentNode, NODE_OP, curRuleItem.data.token_type, curRuleItem.data.token_val.valueString.str);
+                insertLeftMoveLeft(ctx->currentNode, NODE_OP, curRuleItem.data.token_type, curRuleItem.data.token_val.valueString.str);
                 dirRight = true;
             }
-            infestNum++;
+            ctx->infestNum++;
         }
     }
     if (i == 1)
     {
         moveUp(1);
-        infestNum--;
-        if(infestNum != 0){
+        ctx->infestNum--;
+        if(ctx->infestNum != 0){
             moveUp(1);
-            infestNum--;
+            ctx->infestNum--;
         }
     }
     
     // Deallocation memory
-    freeStack(&precStack);
-    freeStack(&ruleStack);
+    expression_free(&precStack, &ruleStack, &varLexThan, &varNotTerminal);
     pmesg(" ------ END EXPRESSION ------\n");
     return true;
 }
@@ -15,6 +15,7 @@
 #include "ast.h"
 #include "stack.h"
 #include "error.h"
+#include "token_pipeline.h"
 
 #define NDEBUG
 
@@ -24,41 +25,40 @@
 #define pmesg(...) // in case NDEBUG will not print notifications
 #endif
 
-// Get token without comments
-#define GET_TOKEN_RAW(token, file) \
-    do                            \
-    {                             \
-        token = get_token(file);  \
-    } while (token.type == TOKEN_COMMENT || token.type == TOKEN_EOL); 
+// Get token without comments, its string is freed by parser_free_tokens()
+#define GET_TOKEN_RAW(token, file) ((token) = parser_next_token(ctx, (file)))
     // print_token(token)
 
-bool FIRST(FILE *file);
-bool STATEMENT(FILE *file, int *infestNumLok);
+Token parser_next_token(CompilerContext *ctx, FILE *file);
+void parser_free_tokens(CompilerContext *ctx);
 
-bool VAR_DEF(FILE *file);
-bool CONST_DEF(FILE *file);
-bool FN_DEF(FILE *file);
-bool IF_DEF(FILE *file);
-bool ELSE_DEF(FILE *file);
-bool WHILE_DEF(FILE *file);
-bool RET_DEF(FILE *file);
-bool CALL_DEF(FILE *file);
+bool FIRST(CompilerContext *ctx, FILE *file);
+bool STATEMENT(CompilerContext *ctx, FILE *file, int *infestNumLok);
 
-bool IF_EXT(FILE *file);
-bool CALL_EXT(FILE *file, bool isAlreadyFn);
-bool CALL_OBJ(FILE *file);
+bool VAR_DEF(CompilerContext *ctx, FILE *file);
+bool CONST_DEF(CompilerContext *ctx, FILE *file);
+bool FN_DEF(CompilerContext *ctx, FILE *file);
+bool IF_DEF(CompilerContext *ctx, FILE *file);
+bool ELSE_DEF(CompilerContext *ctx, FILE *file);
+bool WHILE_DEF(CompilerContext *ctx, FILE *file);
+bool RET_DEF(CompilerContext *ctx, FILE *file);
+bool CALL_DEF(CompilerContext *ctx, FILE *file);
 
-bool ASSIGN_VAR(FILE *file);
-bool ASSIGN_CONST(FILE *file);
+bool IF_EXT(CompilerContext *ctx, FILE *file);
+bool CALL_EXT(CompilerContext *ctx, FILE *file, bool isAlreadyFn);
+bool CALL_OBJ(CompilerContext *ctx, FILE *file);
 
-bool SCOPE(FILE *file);
+bool ASSIGN_VAR(CompilerContext *ctx, FILE *file);
+bool ASSIGN_CONST(CompilerContext *ctx, FILE *file);
 
-bool PARAM(FILE *file);
+bool SCOPE(CompilerContext *ctx, FILE *file);
 
-bool ARG(FILE *file);
-bool ARGS(FILE *file);
+bool PARAM(CompilerContext *ctx, FILE *file);
 
-bool EXPRESSION(FILE *file, Token token);
+bool ARG(CompilerContext *ctx, FILE *file);
+bool ARGS(CompilerContext *ctx, FILE *file);
+
+bool EXPRESSION(CompilerContext *ctx, FILE *file, Token token);
 
 bool VAR_TYPE(Token t);
 bool VAL_TYPE(Token t);
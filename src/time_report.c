@@ -0,0 +1,163 @@
+/**
+ * @file time_report.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief Per-phase timing and allocation counters printed by --time-report.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <sys/resource.h>
+#include <time.h>
+
+#include "time_report.h"
+
+typedef struct
+{
+    double wallSeconds;
+    double cpuSeconds;
+    long long mallocs;  // malloc, calloc and realloc calls
+    long long bytes;    // Requested bytes
+    long peakRssKiB;    // Peak resident set size of the process at the end of the phase
+} PhaseStats;
+
+static const char *phaseNames[PHASE_COUNT] = {
+    [PHASE_OTHER] = "other",
+    [PHASE_LEX] = "lex",
+    [PHASE_PARSE] = "parse",
+    [PHASE_SEMANTIC] = "semantic",
+    [PHASE_CODEGEN] = "codegen",
+};
+
+static const char *counterNames[COUNTER_COUNT] = {
+    [COUNTER_TOKENS] = "tokens",
+    [COUNTER_AST_NODES] = "ast_nodes",
+    [COUNTER_SYMBOLS] = "symbols",
+    [COUNTER_INSTRUCTIONS] = "instructions",
+};
+
+// The report covers the compilation of the thread that started it
+_Thread_local bool timeReportActive = false;
+
+static _Thread_local PhaseStats phases[PHASE_COUNT];
+static _Thread_local long long counters[COUNTER_COUNT];
+static _Thread_local CompilerPhase currentPhase = PHASE_OTHER;
+static _Thread_local double phaseWallStart, phaseCpuStart;
+
+static double clock_seconds(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static long peak_rss_kib()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return usage.ru_maxrss; // KiB on Linux
+}
+
+/**
+ * @brief Starts measuring, the time until now is not reported.
+ */
+void time_report_start()
+{
+    timeReportActive = true;
+    currentPhase = PHASE_OTHER;
+    phaseWallStart = clock_seconds(CLOCK_MONOTONIC);
+    phaseCpuStart = clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+/**
+ * @brief Charges the time since the last switch to the current phase and enters another one.
+ *
+ * @param phase Phase entered.
+ * @return The phase that was left, to switch back to it.
+ */
+CompilerPhase time_report_switch(CompilerPhase phase)
+{
+    CompilerPhase previous = currentPhase;
+    if (!timeReportActive)
+        return previous;
+
+    double wall = clock_seconds(CLOCK_MONOTONIC);
+    double cpu = clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+    phases[previous].wallSeconds += wall - phaseWallStart;
+    phases[previous].cpuSeconds += cpu - phaseCpuStart;
+    phaseWallStart = wall;
+    phaseCpuStart = cpu;
+    currentPhase = phase;
+    return previous;
+}
+
+/**
+ * @brief Leaves the phase for PHASE_OTHER and records the peak RSS reached so far.
+ */
+void time_report_finish_phase(CompilerPhase phase)
+{
+    time_report_switch(PHASE_OTHER);
+    if (timeReportActive)
+        phases[phase].peakRssKiB = peak_rss_kib();
+}
+
+/**
+ * @brief Adds to a size counter.
+ */
+void time_report_count(TimeCounter counter, long long amount)
+{
+    counters[counter] += amount;
+}
+
+/**
+ * @brief Charges one allocation to the current phase (called by the malloc wrappers).
+ */
+void time_report_allocation(size_t bytes)
+{
+    phases[currentPhase].mallocs++;
+    phases[currentPhase].bytes += (long long)bytes;
+}
+
+/**
+ * @brief Prints the report as a table.
+ */
+void time_report_print(FILE *out)
+{
+    PhaseStats total = {0};
+    fprintf(out, "time: %-9s %12s %12s %10s %14s %14s\n", "phase", "wall [ms]", "cpu [ms]", "mallocs", "bytes",
+            "peak RSS [KiB]");
+    for (int i = 0; i < PHASE_COUNT; i++)
+    {
+        const PhaseStats *phase = &phases[i];
+        fprintf(out, "time: %-9s %12.3f %12.3f %10lld %14lld %14ld\n", phaseNames[i], phase->wallSeconds * 1e3,
+                phase->cpuSeconds * 1e3, phase->mallocs, phase->bytes, phase->peakRssKiB);
+        total.wallSeconds += phase->wallSeconds;
+        total.cpuSeconds += phase->cpuSeconds;
+        total.mallocs += phase->mallocs;
+        total.bytes += phase->bytes;
+    }
+    fprintf(out, "time: %-9s %12.3f %12.3f %10lld %14lld %14ld\n", "total", total.wallSeconds * 1e3,
+            total.cpuSeconds * 1e3, total.mallocs, total.bytes, peak_rss_kib());
+    fprintf(out, "time: %lld tokens, %lld AST nodes, %lld symbols, %lld instructions\n", counters[COUNTER_TOKENS],
+            counters[COUNTER_AST_NODES], counters[COUNTER_SYMBOLS], counters[COUNTER_INSTRUCTIONS]);
+}
+
+/**
+ * @brief Prints the report as one JSON object.
+ */
+void time_report_print_json(FILE *out)
+{
+    fprintf(out, "{\"phases\": {");
+    for (int i = 0; i < PHASE_COUNT; i++)
+    {
+        const PhaseStats *phase = &phases[i];
+        fprintf(out, "%s\"%s\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"mallocs\": %lld, \"bytes\": %lld, "
+                     "\"peak_rss_kib\": %ld}",
+                i ? ", " : "", phaseNames[i], phase->wallSeconds * 1e3, phase->cpuSeconds * 1e3, phase->mallocs,
+                phase->bytes, phase->peakRssKiB);
+    }
+    fprintf(out, "}, \"counts\": {");
+    for (int i = 0; i < COUNTER_COUNT; i++)
+        fprintf(out, "%s\"%s\": %lld", i ? ", " : "", counterNames[i], counters[i]);
+    fprintf(out, "}, \"peak_rss_kib\": %ld}\n", peak_rss_kib());
+}
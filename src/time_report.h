@@ -0,0 +1,59 @@
+/**
+ * @file time_report.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Compiler
+ * @brief Per-phase timing and allocation counters printed by --time-report.
+ *
+ * @details The compiler is always in one phase. Switching the phase charges the elapsed wall and
+ * CPU time to the phase being left; allocations (counted by the malloc wrappers in malloc_wrap.c)
+ * are charged to the current phase. Lexing runs inside parsing, get_token() switches to the lex
+ * phase and back, so the parse phase is reported without the time spent in the lexer. With
+ * --pipeline the lexer runs on a thread of its own and the lex phase is the time the parser waits
+ * for it (token_pipeline.c).
+ */
+#ifndef TIME_REPORT_H
+#define TIME_REPORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * @brief Phases of the compilation.
+ */
+typedef enum
+{
+    PHASE_OTHER,    // Everything outside the phases below (option parsing, output)
+    PHASE_LEX,      // get_token()
+    PHASE_PARSE,    // Syntactic analysis without the lexer
+    PHASE_SEMANTIC, // ProcessTree()
+    PHASE_CODEGEN,  // Generation and optimisation of the IR
+    PHASE_COUNT
+} CompilerPhase;
+
+/**
+ * @brief Sizes of the compiled program.
+ */
+typedef enum
+{
+    COUNTER_TOKENS,
+    COUNTER_AST_NODES,
+    COUNTER_SYMBOLS,
+    COUNTER_INSTRUCTIONS, // Instructions emitted by the generator (before optimisation)
+    COUNTER_COUNT
+} TimeCounter;
+
+// Set by time_report_start(), instrumented hot paths check it first
+extern _Thread_local bool timeReportActive;
+
+void time_report_start();
+CompilerPhase time_report_switch(CompilerPhase phase);
+void time_report_finish_phase(CompilerPhase phase);
+void time_report_count(TimeCounter counter, long long amount);
+void time_report_allocation(size_t bytes);
+
+// Output
+void time_report_print(FILE *out);
+void time_report_print_json(FILE *out);
+
+#endif
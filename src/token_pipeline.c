@@ -0,0 +1,295 @@
+/**
+ * @file token_pipeline.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Lexical Analysis
+ * @brief Lexer running on its own thread ahead of the parser (main --pipeline).
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <sched.h>
+#include <setjmp.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "token_pipeline.h"
+#include "context.h"
+#include "literal_pool.h"
+#include "time_report.h"
+
+#define PIPELINE_RING_SIZE 1024  // Tokens in the ring, a power of two
+#define PIPELINE_BATCH 64        // Tokens written or taken between two publications of an index
+#define PIPELINE_SPIN_ROUNDS 64  // A waiting side yields this many times before it starts to sleep
+#define PIPELINE_SLEEP_NS 50000L // Then it checks the other side every 50 us
+#define PIPELINE_CACHE_LINE 64
+
+/**
+ * @brief One token in the ring.
+ */
+typedef struct
+{
+    Token token;
+    int error;          // ErrorCode of the lexer in place of a token, 0 for a token
+    int scanned;        // Tokens read by get_token() for this one, with the skipped comments and ends of lines
+    long long intValue; // Value of an int literal
+    double floatValue;  // Value of a float literal
+} TokenSlot;
+
+/**
+ * @brief Ring between the lexer thread and the parser, slots[tail .. head - 1] are waiting.
+ *
+ * @details The indices only grow, the slot of index i is slots[i % PIPELINE_RING_SIZE]. The fields
+ * of each side sit on their own cache line.
+ */
+struct TokenPipeline
+{
+    // Written by the lexer thread
+    _Alignas(PIPELINE_CACHE_LINE) atomic_size_t head; // Slots before head are written
+    size_t written;    // Slots written, published to head once per batch
+    size_t writeLimit; // written can grow up to here without loading tail
+    FILE *source;
+    FILE *quiet; // Messages of the lexer thread, the parser reports the error again
+    char *messages;
+    size_t messagesLength;
+
+    // Written by the parser
+    _Alignas(PIPELINE_CACHE_LINE) atomic_size_t tail; // Slots before tail are taken
+    size_t read;      // Slots taken, published to tail once per batch
+    size_t readLimit; // read can grow up to here without loading head
+    bool finished;    // The parser took the end of file or the error
+    atomic_bool stop; // The parser does not want more tokens
+
+    pthread_t thread;
+    bool joined; // The lexer thread ended and was joined
+    TokenSlot slots[PIPELINE_RING_SIZE];
+};
+
+// Waits for the other side: yields first, then sleeps (the other side may be blocked in a read)
+static void pipeline_wait(int *rounds)
+{
+    if ((*rounds)++ < PIPELINE_SPIN_ROUNDS)
+    {
+        sched_yield();
+        return;
+    }
+    struct timespec pause = {0, PIPELINE_SLEEP_NS};
+    nanosleep(&pause, NULL);
+}
+
+static void lexer_publish(TokenPipeline *pipeline)
+{
+    atomic_store_explicit(&pipeline->head, pipeline->written, memory_order_release);
+}
+
+/**
+ * @brief Writes a slot into the ring, waits while the ring is full.
+ *
+ * @return False when the parser stopped the pipeline.
+ */
+static bool lexer_push(TokenPipeline *pipeline, const TokenSlot *slot)
+{
+    int rounds = 0;
+    while (pipeline->written == pipeline->writeLimit)
+    {
+        lexer_publish(pipeline);
+        pipeline->writeLimit = atomic_load_explicit(&pipeline->tail, memory_order_acquire) + PIPELINE_RING_SIZE;
+        if (pipeline->written < pipeline->writeLimit)
+            break;
+        if (atomic_load_explicit(&pipeline->stop, memory_order_relaxed))
+            return false;
+        pipeline_wait(&rounds);
+    }
+
+    pipeline->slots[pipeline->written % PIPELINE_RING_SIZE] = *slot;
+    pipeline->written++;
+    if (pipeline->written % PIPELINE_BATCH == 0)
+    {
+        lexer_publish(pipeline);
+        return !atomic_load_explicit(&pipeline->stop, memory_order_relaxed);
+    }
+    return true;
+}
+
+/**
+ * @brief Lexer thread: writes the tokens up to the end of file or the first error.
+ *
+ * @details The thread has its own context, an error of the lexer returns to it from handle_error()
+ * and goes into the ring. The literals go to the literal pool of this thread, which is dropped at
+ * the end; the slot carries the value of a number, so the parser does not compute it again.
+ */
+static void *lexer_main(void *argument)
+{
+    TokenPipeline *pipeline = argument;
+    CompilerContext context = {0};
+    jmp_buf handler;
+    context.diagnostics = pipeline->quiet;
+    context.errorHandler = &handler;
+    compilerContext = &context;
+    lexer_begin(pipeline->source);
+
+    if (setjmp(handler) == 0)
+    {
+        bool more = true;
+        while (more)
+        {
+            TokenSlot slot = {0};
+            slot.token = get_token(pipeline->source);
+            slot.scanned = 1;
+            while (slot.token.type == TOKEN_COMMENT || slot.token.type == TOKEN_EOL)
+            {
+                dynamic_string_free(&slot.token.value.valueString);
+                slot.token = get_token(pipeline->source);
+                slot.scanned++;
+            }
+
+            const char *text = slot.token.value.valueString.str;
+            if (slot.token.type == TOKEN_INT_LITERAL)
+                slot.intValue = literal_pool_int(literal_pool_find(TOKEN_INT_LITERAL, text));
+            else if (slot.token.type == TOKEN_FLOAT_LITERAL)
+                slot.floatValue = literal_pool_float(literal_pool_find(TOKEN_FLOAT_LITERAL, text));
+
+            more = lexer_push(pipeline, &slot) && slot.token.type != TOKEN_EOF;
+        }
+    }
+    else
+    {
+        TokenSlot slot = {0};
+        slot.error = context.errorCode;
+        lexer_push(pipeline, &slot);
+    }
+    lexer_publish(pipeline);
+
+    literal_pool_free();
+    compilerContext = NULL;
+    return NULL;
+}
+
+/**
+ * @brief Starts the lexer thread on the source.
+ *
+ * @param source Source code of the program, read only by the lexer thread until token_pipeline_stop().
+ * @return The pipeline, or NULL when the thread cannot be started (the caller lexes by itself).
+ */
+TokenPipeline *token_pipeline_start(FILE *source)
+{
+    TokenPipeline *pipeline = aligned_alloc(PIPELINE_CACHE_LINE, sizeof(TokenPipeline));
+    if (!pipeline)
+        return NULL;
+
+    atomic_init(&pipeline->head, 0);
+    atomic_init(&pipeline->tail, 0);
+    atomic_init(&pipeline->stop, false);
+    pipeline->written = 0;
+    pipeline->writeLimit = PIPELINE_RING_SIZE;
+    pipeline->read = 0;
+    pipeline->readLimit = 0;
+    pipeline->finished = false;
+    pipeline->joined = false;
+    pipeline->source = source;
+    pipeline->messages = NULL;
+    pipeline->quiet = open_memstream(&pipeline->messages, &pipeline->messagesLength);
+    if (!pipeline->quiet)
+    {
+        free(pipeline);
+        return NULL;
+    }
+
+    if (pthread_create(&pipeline->thread, NULL, lexer_main, pipeline) != 0)
+    {
+        fclose(pipeline->quiet);
+        free(pipeline->messages);
+        free(pipeline);
+        return NULL;
+    }
+    return pipeline;
+}
+
+// Waits until the lexer thread publishes more tokens, the wait is charged to the lex phase
+static void parser_wait(TokenPipeline *pipeline)
+{
+    CompilerPhase outer = timeReportActive ? time_report_switch(PHASE_LEX) : PHASE_LEX;
+
+    // Every taken slot goes back before waiting, the lexer may be waiting for them
+    atomic_store_explicit(&pipeline->tail, pipeline->read, memory_order_release);
+    int rounds = 0;
+    while ((pipeline->readLimit = atomic_load_explicit(&pipeline->head, memory_order_acquire)) == pipeline->read)
+        pipeline_wait(&rounds);
+
+    if (timeReportActive)
+        time_report_switch(outer);
+}
+
+/**
+ * @brief Takes the next token, like GET_TOKEN_RAW() with get_token().
+ *
+ * @details Adds a literal to the literal pool of the calling thread, so the pool is filled in the
+ * order of a sequential run. An error of the lexer is reported by handle_error() here, when the
+ * parser reaches it. After the end of file, every call returns the end of file again.
+ *
+ * @param pipeline Pipeline of the source.
+ * @return The token, its string is owned by the caller.
+ */
+Token token_pipeline_next(TokenPipeline *pipeline)
+{
+    Token token;
+    if (pipeline->finished)
+    {
+        token.type = TOKEN_EOF;
+        token.keyword_val = 0;
+        if (!dynamic_string_init(&token.value.valueString))
+            handle_error(ERR_COMPILER_INTERNAL);
+        return token;
+    }
+
+    if (pipeline->read == pipeline->readLimit)
+        parser_wait(pipeline);
+    TokenSlot slot = pipeline->slots[pipeline->read % PIPELINE_RING_SIZE];
+    pipeline->read++;
+    if (pipeline->read % PIPELINE_BATCH == 0)
+        atomic_store_explicit(&pipeline->tail, pipeline->read, memory_order_release);
+
+    time_report_count(COUNTER_TOKENS, slot.scanned);
+    if (slot.error)
+    {
+        // The error is the last slot, the thread has ended (handle_error() may end the process)
+        pthread_join(pipeline->thread, NULL);
+        pipeline->joined = true;
+        pipeline->finished = true;
+        handle_error((ErrorCode)slot.error);
+    }
+
+    token = slot.token;
+    if (token.type == TOKEN_INT_LITERAL)
+        literal_pool_add_int(token.value.valueString.str, slot.intValue);
+    else if (token.type == TOKEN_FLOAT_LITERAL)
+        literal_pool_add_float(token.value.valueString.str, slot.floatValue);
+    else if (token.type == TOKEN_STRING_LITERAL)
+        literal_pool_add_string(token.value.valueString.str);
+    else if (token.type == TOKEN_EOF)
+        pipeline->finished = true;
+    return token;
+}
+
+/**
+ * @brief Stops the lexer thread and frees the pipeline with the tokens the parser did not take.
+ *
+ * @details The lexer thread ends at its next batch, so it reads at most a batch of tokens past
+ * the point where the parser stopped (it finishes a read that is blocked first).
+ */
+void token_pipeline_stop(TokenPipeline *pipeline)
+{
+    atomic_store_explicit(&pipeline->stop, true, memory_order_relaxed);
+    if (!pipeline->joined)
+        pthread_join(pipeline->thread, NULL);
+
+    for (size_t i = pipeline->read; i < pipeline->written; i++)
+    {
+        TokenSlot *slot = &pipeline->slots[i % PIPELINE_RING_SIZE];
+        if (!slot->error)
+            dynamic_string_free(&slot->token.value.valueString);
+    }
+    fclose(pipeline->quiet);
+    free(pipeline->messages);
+    free(pipeline);
+}
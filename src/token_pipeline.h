@@ -0,0 +1,32 @@
+/**
+ * @file token_pipeline.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Lexical Analysis
+ * @brief Lexer running on its own thread ahead of the parser (main --pipeline).
+ *
+ * @details The lexer thread reads the source with get_token() and writes the tokens into a ring
+ * shared with the parser, which takes them with token_pipeline_next() instead of calling the
+ * lexer. The ring has one writer and one reader, so it needs no lock: each side owns one index
+ * and publishes it with a release store. Both sides publish their index once per batch of tokens
+ * (and before they wait), so the cache line of an index moves between the cores once per batch
+ * instead of once per token.
+ *
+ * The parser sees exactly the tokens of get_token(), in the same order and with the same
+ * errors: the lexer thread keeps its literals and messages to itself, the parser adds the literals
+ * to its pool when it takes a token and reports an error of the lexer when it reaches the token
+ * that failed. Comments and ends of lines, which the parser skips, are dropped by the lexer thread.
+ */
+#ifndef TOKEN_PIPELINE_H
+#define TOKEN_PIPELINE_H
+
+#include <stdio.h>
+
+#include "lexical_analyser.h"
+
+typedef struct TokenPipeline TokenPipeline;
+
+TokenPipeline *token_pipeline_start(FILE *source);
+Token token_pipeline_next(TokenPipeline *pipeline);
+void token_pipeline_stop(TokenPipeline *pipeline);
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ * @file vm.h
+ * @author Pavel Glvač <xglvacp00>
+ * @category Interpreter
+ * @brief Built-in interpreter of IFJcode24 used to run and benchmark the generated code.
+ *
+ * @details The interpreter executes an IRProgram in-process: it has the global, temporary
+ * and local frames, the data stack, the call stack and typed values, and it implements the
+ * whole IFJcode24 instruction set. Errors are reported with the return codes of the
+ * reference interpreter (52 - 58). On request it records the execution profile (see profile.h).
+ */
+#ifndef VM_H
+#define VM_H
+
+#include <stdio.h>
+#include "ir.h"
+#include "profile.h"
+
+/**
+ * @brief Return codes of the interpreter.
+ */
+typedef enum
+{
+    VM_OK = 0,
+    VM_ERR_HEADER = 21,        // Missing .IFJcode24 header
+    VM_ERR_OPCODE = 22,        // Unknown instruction
+    VM_ERR_SYNTAX = 23,        // Malformed operand
+    VM_ERR_SEMANTIC = 52,      // Undefined label, redefinition of a variable
+    VM_ERR_OPERAND_TYPE = 53,  // Wrong operand types
+    VM_ERR_UNDEFINED_VAR = 54, // Access to a non-existing variable
+    VM_ERR_FRAME = 55,         // Frame does not exist
+    VM_ERR_MISSING_VALUE = 56, // Uninitialised variable, empty data or call stack
+    VM_ERR_OPERAND_VALUE = 57, // Division by zero, wrong EXIT code
+    VM_ERR_STRING = 58,        // Wrong string operation
+    VM_ERR_INTERNAL = 99
+} VMResult;
+
+/**
+ * @brief Counters collected during one run.
+ */
+typedef struct
+{
+    long long instructions; // Executed instructions
+    long long calls;        // Executed CALL instructions
+    long long framePushes;  // Executed PUSHFRAME instructions
+    long long frameCreates; // Executed CREATEFRAME instructions
+    int maxDataStack;       // Highest depth of the data stack
+    int maxCallDepth;       // Highest depth of the call stack
+    int exitCode;           // Argument of EXIT (0 when the program ran to its end)
+    double loadSeconds;     // Wall time of the translation to bytecode
+    double wallSeconds;     // Wall time of the translation and the execution
+} VMStats;
+
+int vm_run(const IRProgram *program, FILE *in, FILE *out, VMStats *stats, Profile *profile);
+void vm_print_stats(const VMStats *stats, FILE *out);
+
+#endif
@@ -0,0 +1,276 @@
+/**
+ * @file ifj_gen.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Benchmarks
+ * @brief Generator of synthetic IFJ24 programs for the scaling benchmarks.
+ *
+ * @details The same options and seed always give the same program. Every generated program is valid,
+ * it terminates and prints one number:
+ *  - functions fun0 .. funN-1 (f64 is a keyword) take a call depth d and a value p, they return p right away when d < 1,
+ *    otherwise their body may call the functions defined before them with d - 1,
+ *  - while loops run three times, their counters are never assigned in the body,
+ *  - expressions use + and - with at most one local variable, so the values grow only linearly.
+ *
+ * Usage: ifj_gen [--seed N] [--lines N] [--functions N] [--nesting N] [--expr-depth N]
+ *                [--string-size N] [--identifiers N] [--call-density PERCENT] > program.ifj
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Size and shape of the generated program.
+ */
+typedef struct
+{
+    unsigned long long seed; // Seed of the random generator
+    long lines;              // Approximate number of lines of the program
+    int functions;           // Number of functions besides main
+    int nesting;             // Maximum nesting of if and while blocks
+    int exprDepth;           // Maximum depth of an expression tree
+    int stringSize;          // Length of the string literals
+    int identifiers;         // Number of int variables declared at the start of each function
+    int callDensity;         // Percentage of statements that call another function
+} GenOptions;
+
+static GenOptions options = {1, 1000, 10, 3, 3, 16, 8, 10};
+static unsigned long long randomState;
+static long linesEmitted = 0;
+static int uniqueCounter = 0; // Suffix of the variables declared in the blocks of a function
+
+// xorshift64*, the programs do not depend on the rand() of the C library
+static unsigned long long next_random()
+{
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+    return randomState * 2685821657736338717ULL;
+}
+
+static int random_below(int bound)
+{
+    return bound > 0 ? (int)(next_random() % (unsigned long long)bound) : 0;
+}
+
+// Writes one indented line of the program
+static void emit(int indent, const char *format, ...)
+{
+    printf("%*s", 4 * indent, "");
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    putchar('\n');
+    linesEmitted++;
+}
+
+// Writes an operand, at most one local variable is used in an expression
+static void emit_leaf(int *variableUsed)
+{
+    int choice = random_below(4);
+    if (choice == 0 && !*variableUsed)
+    {
+        *variableUsed = 1;
+        printf("v%d", random_below(options.identifiers));
+    }
+    else if (choice == 1)
+        printf("p");
+    else
+        printf("%d", random_below(100));
+}
+
+// Writes an expression of at most the given depth, nested operations are parenthesised
+static void emit_expression(int depth, int parenthesise, int *variableUsed)
+{
+    if (depth <= 1 || random_below(3) == 0)
+    {
+        emit_leaf(variableUsed);
+        return;
+    }
+    if (parenthesise)
+        putchar('(');
+    emit_expression(depth - 1, 1, variableUsed);
+    printf(random_below(2) ? " + " : " - ");
+    emit_expression(depth - 1, 1, variableUsed);
+    if (parenthesise)
+        putchar(')');
+}
+
+static void emit_expression_line(int indent, const char *prefix, const char *suffix)
+{
+    int variableUsed = 0;
+    printf("%*s%s", 4 * indent, "", prefix);
+    emit_expression(options.exprDepth, 0, &variableUsed);
+    printf("%s\n", suffix);
+    linesEmitted++;
+}
+
+// Writes a condition, the parser does not accept parentheses inside one, so its operand is a flat chain
+static void emit_condition_line(int indent, const char *suffix)
+{
+    int variableUsed = 1; // v0 is on the left
+    printf("%*sif (v0 < ", 4 * indent, "");
+    emit_leaf(&variableUsed);
+    for (int i = random_below(options.exprDepth); i > 0; i--)
+    {
+        printf(random_below(2) ? " + " : " - ");
+        emit_leaf(&variableUsed);
+    }
+    printf("%s\n", suffix);
+    linesEmitted++;
+}
+
+// Writes a string literal of options.stringSize letters and spaces
+static void emit_string_line(int indent, int index)
+{
+    printf("%*svar s%d : []u8 = ifj.string(\"", 4 * indent, "", index);
+    for (int i = 0; i < options.stringSize; i++)
+        putchar(random_below(8) == 0 ? ' ' : 'a' + random_below(26));
+    printf("\");\n");
+    linesEmitted++;
+}
+
+static void emit_block(int indent, int depth, int function, long end);
+
+// Writes one statement of the body of the function
+static void emit_statement(int indent, int depth, int function, long end)
+{
+    int roll = random_below(100);
+    int index;
+    char prefix[64];
+
+    if (function > 0 && roll < options.callDensity)
+    {
+        emit(indent, "v%d = fun%d(dn, v%d);", random_below(options.identifiers), random_below(function),
+             random_below(options.identifiers));
+    }
+    else if (depth < options.nesting && roll < options.callDensity + 15)
+    {
+        emit_condition_line(indent, ") {");
+        emit_block(indent + 1, depth + 1, function, end);
+        emit(indent, "} else {");
+        emit_block(indent + 1, depth + 1, function, end);
+        emit(indent, "}");
+    }
+    else if (depth < options.nesting && roll < options.callDensity + 25)
+    {
+        index = uniqueCounter++;
+        emit(indent, "var w%d : i32 = 0;", index);
+        emit(indent, "while (w%d < 3) {", index);
+        emit_block(indent + 1, depth + 1, function, end);
+        emit(indent + 1, "w%d = w%d + 1;", index, index);
+        emit(indent, "}");
+    }
+    else if (roll < options.callDensity + 35)
+    {
+        index = uniqueCounter++;
+        emit_string_line(indent, index);
+        emit(indent, "var l%d : i32 = ifj.length(s%d);", index, index);
+        index = random_below(options.identifiers);
+        emit(indent, "v%d = v%d + l%d;", index, index, uniqueCounter - 1);
+    }
+    else
+    {
+        snprintf(prefix, sizeof(prefix), "v%d = ", random_below(options.identifiers));
+        emit_expression_line(indent, prefix, ";");
+    }
+}
+
+// Writes statements until the line budget of the function is used up, nested blocks get fewer
+static void emit_block(int indent, int depth, int function, long end)
+{
+    int statements = 1 + random_below(depth == 0 ? 8 : 4);
+    for (int i = 0; i < statements || (depth == 0 && linesEmitted < end); i++)
+    {
+        if (depth > 0 && linesEmitted >= end)
+            break;
+        emit_statement(indent, depth, function, end);
+    }
+}
+
+static void emit_function(int function, long end)
+{
+    uniqueCounter = 0;
+    emit(0, "pub fn fun%d(d : i32, p : i32) i32 {", function);
+    emit(1, "if (d < 1) {");
+    emit(2, "return p;");
+    emit(1, "} else {");
+    emit(1, "}");
+    emit(1, "var dn : i32 = d - 1;");
+    for (int i = 0; i < options.identifiers; i++)
+        emit(1, "var v%d : i32 = p + %d;", i, random_below(100));
+    emit_block(1, 0, function, end);
+    emit(1, "return v%d;", random_below(options.identifiers));
+    emit(0, "}");
+    emit(0, "");
+}
+
+static void emit_main()
+{
+    int calls = options.functions < 4 ? options.functions : 4;
+    emit(0, "pub fn main() void {");
+    emit(1, "var depth : i32 = 2;");
+    emit(1, "var acc : i32 = 0;");
+    for (int i = 0; i < calls; i++)
+    {
+        emit(1, "var r%d : i32 = fun%d(depth, acc);", i, options.functions - 1 - i);
+        emit(1, "acc = acc + r%d;", i);
+    }
+    emit(1, "ifj.write(acc);");
+    emit(1, "ifj.write(\"\\n\");");
+    emit(1, "return;");
+    emit(0, "}");
+}
+
+static int parse_option(const char *name, const char *value)
+{
+    char *end;
+    long long number = strtoll(value, &end, 10);
+    if (*end != '\0' || number < 0)
+        return 0;
+
+    if (strcmp(name, "--seed") == 0)
+        options.seed = (unsigned long long)number;
+    else if (strcmp(name, "--lines") == 0)
+        options.lines = (long)number;
+    else if (strcmp(name, "--functions") == 0 && number > 0)
+        options.functions = (int)number;
+    else if (strcmp(name, "--nesting") == 0)
+        options.nesting = (int)number;
+    else if (strcmp(name, "--expr-depth") == 0 && number > 0)
+        options.exprDepth = (int)number;
+    else if (strcmp(name, "--string-size") == 0)
+        options.stringSize = (int)number;
+    else if (strcmp(name, "--identifiers") == 0 && number > 0)
+        options.identifiers = (int)number;
+    else if (strcmp(name, "--call-density") == 0 && number <= 100)
+        options.callDensity = (int)number;
+    else
+        return 0;
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i += 2)
+    {
+        if (i + 1 >= argc || !parse_option(argv[i], argv[i + 1]))
+        {
+            fprintf(stderr, "Usage: %s [--seed N] [--lines N] [--functions N] [--nesting N] [--expr-depth N] "
+                            "[--string-size N] [--identifiers N] [--call-density PERCENT]\n", argv[0]);
+            return 1;
+        }
+    }
+    // A zero state would stay zero
+    randomState = options.seed * 0x9E3779B97F4A7C15ULL + 1;
+
+    emit(0, "const ifj = @import(\"ifj24.zig\");");
+    emit(0, "");
+    // Main takes about 16 lines, the rest is split evenly between the functions
+    long perFunction = (options.lines - 16) / options.functions;
+    for (int i = 0; i < options.functions; i++)
+        emit_function(i, linesEmitted + perFunction);
+    emit_main();
+    return 0;
+}
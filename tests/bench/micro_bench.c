@@ -0,0 +1,448 @@
+/**
+ * @file micro_bench.c
+ * @author Pavel Glvač <xglvacp00>
+ * @category Benchmarks
+ * @brief Microbenchmarks of the lexer, the expression parser, the symbol table and the code generator.
+ *
+ * @details Every benchmark runs a few untimed warmup rounds and then the timed repetitions. A round
+ * performs a number of operations (tokens, expressions, symbols or emitted instructions), the time of
+ * the round divided by that number gives ns/op. The median, the 95th percentile and the minimum over
+ * the repetitions are printed and appended to a CSV file together with the date and the revision,
+ * so the results can be tracked over time.
+ *
+ * Usage: micro_bench [--csv file] [--revision name] [--warmup N] [--repetitions N] [--filter text]
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lexical_analyser.h"
+#include "syntactic_analysis.h"
+#include "symtable.h"
+#include "Code_generator.h"
+#include "newstring.h"
+
+#define BENCH_MAX_REPETITIONS 1000
+
+/**
+ * @brief One benchmark at one size.
+ *
+ * @details setup() and teardown() are not timed, run() performs one round and returns the number
+ * of operations it did.
+ */
+typedef struct
+{
+    const char *name;
+    long size;
+    void (*setup)(long size);
+    long (*run)(long size);
+    void (*teardown)(void);
+} Benchmark;
+
+static int warmup = 3;
+static int repetitions = 25;
+
+static double now_ns()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Input text kept open as a stream, rewound before every round
+static char *inputText = NULL;
+static FILE *input = NULL;
+
+static void input_open(char *text)
+{
+    inputText = text;
+    input = fmemopen(inputText, strlen(inputText), "r");
+    if (!input)
+    {
+        perror("fmemopen");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void input_close()
+{
+    fclose(input);
+    free(inputText);
+    input = NULL;
+    inputText = NULL;
+}
+
+// Appends formatted text to a growing buffer
+static void text_append(char **text, size_t *length, size_t *capacity, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int needed = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (*length + needed + 1 > *capacity)
+    {
+        *capacity = 2 * (*length + needed + 1);
+        *text = realloc(*text, *capacity);
+        if (!*text)
+            exit(EXIT_FAILURE);
+    }
+    va_start(args, format);
+    vsnprintf(*text + *length, needed + 1, format, args);
+    va_end(args);
+    *length += needed;
+}
+
+// Nested expression "((a + 1) * 2 - 3) ..." of the given depth, terminated by ';'
+static char *deep_expression(long depth)
+{
+    static const char *operators[] = {" + ", " * ", " - "};
+    char *text = NULL;
+    size_t length = 0, capacity = 0;
+    for (long i = 0; i < depth; i++)
+        text_append(&text, &length, &capacity, "(");
+    text_append(&text, &length, &capacity, "a");
+    for (long i = 0; i < depth; i++)
+        text_append(&text, &length, &capacity, "%s%ld)", operators[i % 3], i % 10 + 1);
+    text_append(&text, &length, &capacity, ";");
+    return text;
+}
+
+/* ---------- get_token ---------- */
+
+static void lexer_setup(long lines)
+{
+    char *text = NULL;
+    size_t length = 0, capacity = 0;
+    text_append(&text, &length, &capacity, "const ifj = @import(\"ifj24.zig\");\n");
+    for (long i = 0; i < lines; i++)
+    {
+        switch (i % 4)
+        {
+        case 0:
+            text_append(&text, &length, &capacity, "    var value%ld : i32 = (count + 12) * limit - 7;\n", i);
+            break;
+        case 1:
+            text_append(&text, &length, &capacity, "    ifj.write(\"line %ld\\n\"); // comment\n", i);
+            break;
+        case 2:
+            text_append(&text, &length, &capacity, "    if (ratio >= 2.5e-3) { ratio = ratio / 1.25; } else { }\n");
+            break;
+        default:
+            text_append(&text, &length, &capacity, "    while (index < 100) { index = index + 1; }\n");
+            break;
+        }
+    }
+    input_open(text);
+}
+
+// Lines of commented-out code and long indented comments, the lexer spends its time skipping them
+static void comments_setup(long lines)
+{
+    char *text = NULL;
+    size_t length = 0, capacity = 0;
+    text_append(&text, &length, &capacity, "const ifj = @import(\"ifj24.zig\");\n");
+    for (long i = 0; i < lines; i++)
+    {
+        if (i % 2 == 0)
+            text_append(&text, &length, &capacity, "        // var value%ld : i32 = (count + 12) * limit - 7; // old code\n", i);
+        else
+            text_append(&text, &length, &capacity, "    // Line %ld of a long explanation, which goes on for some more words than usual.\n", i);
+    }
+    input_open(text);
+}
+
+// Long string literals, long numbers and long identifiers
+static void literals_setup(long lines)
+{
+    char *text = NULL;
+    size_t length = 0, capacity = 0;
+    text_append(&text, &length, &capacity, "const ifj = @import(\"ifj24.zig\");\n");
+    for (long i = 0; i < lines; i++)
+    {
+        switch (i % 3)
+        {
+        case 0:
+            text_append(&text, &length, &capacity,
+                        "    ifj.write(\"Line %ld of the report: every value has been checked twice.\\n\");\n", i);
+            break;
+        case 1:
+            text_append(&text, &length, &capacity, "    const ratio%ld = 3.14159265358979323846 * 2718281828459045;\n", i);
+            break;
+        default:
+            text_append(&text, &length, &capacity,
+                        "    accumulated_total_of_values_%ld = accumulated_total_of_values_%ld + 1;\n", i, i - 1);
+            break;
+        }
+    }
+    input_open(text);
+}
+
+static long lexer_run(long lines)
+{
+    (void)lines;
+    long tokens = 0;
+    rewind(input);
+    lexer_begin(input);
+    for (;;)
+    {
+        Token token = get_token(input);
+        if (token.type == TOKEN_EOF)
+            break;
+        dynamic_string_free(&token.value.valueString);
+        tokens++;
+    }
+    return tokens;
+}
+
+/* ---------- EXPRESSION ---------- */
+
+// Context of the benchmarked components, current for the whole run
+static CompilerContext benchContext;
+
+static void expression_setup(long depth)
+{
+    input_open(deep_expression(depth));
+}
+
+// Parses the expression as the value of "var x = ...", the caller frees the tree
+static BinaryTreeNode *parse_expression()
+{
+    BinaryTreeNode *root = createBinaryNode(NODE_GENERAL, TOKEN_EMPTY, "");
+    setStartNode(root);
+    insertRightMoveRight(benchContext.currentNode, NODE_VAR_DECL, TOKEN_KEYWORD, "var");
+    insertRightMoveRight(benchContext.currentNode, NODE_VAR, TOKEN_IDENTIFIER, "x");
+    insertRightMoveRight(benchContext.currentNode, NODE_VAR, TOKEN_ASSIGNMENT, "=");
+    rewind(input);
+    lexer_begin(input);
+    if (!EXPRESSION(&benchContext, input, parser_next_token(&benchContext, input)))
+    {
+        fprintf(stderr, "micro_bench: the expression was rejected\n");
+        exit(EXIT_FAILURE);
+    }
+    parser_free_tokens(&benchContext);
+    return root;
+}
+
+static long expression_run(long depth)
+{
+    (void)depth;
+    freeBinaryTree(parse_expression());
+    return 1;
+}
+
+/* ---------- symbol table ---------- */
+
+static char **symbolNames = NULL;
+static long symbolCount = 0;
+static SymbolStack *symbols = NULL;
+
+static void symbols_setup(long count)
+{
+    symbolCount = count;
+    symbolNames = malloc(sizeof(char *) * count);
+    if (!symbolNames)
+        exit(EXIT_FAILURE);
+    for (long i = 0; i < count; i++)
+    {
+        symbolNames[i] = malloc(32);
+        if (!symbolNames[i])
+            exit(EXIT_FAILURE);
+        snprintf(symbolNames[i], 32, "symbol_%ld", i);
+    }
+}
+
+static void symbols_fill(long count)
+{
+    int value = 0;
+    symbols = initialize_symbol_stack();
+    for (long i = 0; i < count; i++)
+        insert_symbol_stack(symbols, symbolNames[i], TYPE_INT, &value, false, false, false, TYPE_EMPTY);
+}
+
+static void symbols_teardown()
+{
+    // The stack of the insert benchmark is freed by its round
+    if (symbols)
+        free_symbol_stack(symbols);
+    symbols = NULL;
+    for (long i = 0; i < symbolCount; i++)
+        free(symbolNames[i]);
+    free(symbolNames);
+    symbolNames = NULL;
+}
+
+static long insert_run(long count)
+{
+    symbols_fill(count);
+    free_symbol_stack(symbols);
+    symbols = NULL;
+    return count;
+}
+
+static void search_setup(long count)
+{
+    symbols_setup(count);
+    symbols_fill(count);
+    // Lookups also pass through an enclosing scope, as in a function body
+    push_scope(symbols);
+}
+
+static long search_run(long count)
+{
+    for (long i = 0; i < count; i++)
+    {
+        if (!search_symbol_stack(symbols, symbolNames[(i * 7919) % count]))
+        {
+            fprintf(stderr, "micro_bench: symbol %ld not found\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    return count;
+}
+
+/* ---------- generateExpression ---------- */
+
+static BinaryTreeNode *expressionTree = NULL;
+static BinaryTreeNode *expression = NULL;
+
+static void generate_setup(long depth)
+{
+    expression_setup(depth);
+    expressionTree = parse_expression();
+    // Value of the declaration, found as in generateDeclaration()
+    BinaryTreeNode *assignNode = move_right_until(expressionTree->right, TOKEN_ASSIGNMENT);
+    expression = assignNode->left ? assignNode->left : assignNode->right;
+}
+
+static long generate_run(long depth)
+{
+    (void)depth;
+    IRProgram *target = ir_create_program();
+    free(generateExpressionInto(target, expression));
+    long instructions = target->count;
+    ir_free_program(target);
+    return instructions;
+}
+
+static void generate_teardown()
+{
+    freeBinaryTree(expressionTree);
+    expressionTree = NULL;
+    input_close();
+}
+
+static const Benchmark benchmarks[] = {
+    {"get_token", 100, lexer_setup, lexer_run, input_close},
+    {"get_token", 10000, lexer_setup, lexer_run, input_close},
+    {"get_token/comments", 10000, comments_setup, lexer_run, input_close},
+    {"get_token/literals", 10000, literals_setup, lexer_run, input_close},
+    {"EXPRESSION", 8, expression_setup, expression_run, input_close},
+    {"EXPRESSION", 64, expression_setup, expression_run, input_close},
+    {"EXPRESSION", 512, expression_setup, expression_run, input_close},
+    {"insert_symbol_stack", 100, symbols_setup, insert_run, symbols_teardown},
+    {"insert_symbol_stack", 1000, symbols_setup, insert_run, symbols_teardown},
+    {"insert_symbol_stack", 10000, symbols_setup, insert_run, symbols_teardown},
+    {"search_symbol_stack", 100, search_setup, search_run, symbols_teardown},
+    {"search_symbol_stack", 1000, search_setup, search_run, symbols_teardown},
+    {"search_symbol_stack", 10000, search_setup, search_run, symbols_teardown},
+    {"generateExpression", 8, generate_setup, generate_run, generate_teardown},
+    {"generateExpression", 64, generate_setup, generate_run, generate_teardown},
+    {"generateExpression", 512, generate_setup, generate_run, generate_teardown},
+};
+
+// Runs the benchmark and reports ns/op, the CSV row is appended when csv is not NULL
+static void bench_run(const Benchmark *benchmark, FILE *csv, const char *date, const char *revision)
+{
+    static double nsPerOp[BENCH_MAX_REPETITIONS];
+    long ops = 0;
+
+    benchmark->setup(benchmark->size);
+    for (int i = 0; i < warmup; i++)
+        benchmark->run(benchmark->size);
+    for (int i = 0; i < repetitions; i++)
+    {
+        double start = now_ns();
+        ops = benchmark->run(benchmark->size);
+        nsPerOp[i] = (now_ns() - start) / (ops > 0 ? ops : 1);
+    }
+    benchmark->teardown();
+
+    qsort(nsPerOp, repetitions, sizeof(double), compare_doubles);
+    double median = nsPerOp[repetitions / 2];
+    double p95 = nsPerOp[(repetitions * 95 + 99) / 100 - 1];
+    printf("%-20s %8ld %10ld %14.1f %14.1f %14.1f\n", benchmark->name, benchmark->size, ops, median, p95, nsPerOp[0]);
+    if (csv)
+        fprintf(csv, "%s,%s,%s,%ld,%ld,%d,%.1f,%.1f,%.1f\n", date, revision, benchmark->name, benchmark->size, ops,
+                repetitions, median, p95, nsPerOp[0]);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *csvPath = NULL;
+    const char *revision = "unknown";
+    const char *filter = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+            csvPath = argv[++i];
+        else if (strcmp(argv[i], "--revision") == 0 && i + 1 < argc)
+            revision = argv[++i];
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            warmup = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+            repetitions = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [--csv file] [--revision name] [--warmup N] [--repetitions N] "
+                            "[--filter text]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (repetitions < 1 || repetitions > BENCH_MAX_REPETITIONS || warmup < 0)
+    {
+        fprintf(stderr, "micro_bench: repetitions must be 1 - %d\n", BENCH_MAX_REPETITIONS);
+        return 1;
+    }
+    compilerContext = &benchContext;
+
+    FILE *csv = NULL;
+    if (csvPath)
+    {
+        csv = fopen(csvPath, "a");
+        if (!csv)
+        {
+            perror(csvPath);
+            return 1;
+        }
+        // Header only at the start of a new file, later runs are appended below it
+        if (ftell(csv) == 0)
+            fprintf(csv, "date,revision,benchmark,size,ops,repetitions,median_ns_per_op,p95_ns_per_op,min_ns_per_op\n");
+    }
+
+    char date[32];
+    time_t seconds = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&seconds));
+
+    printf("%-20s %8s %10s %14s %14s %14s\n", "benchmark", "size", "ops", "median ns/op", "p95 ns/op", "min ns/op");
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+    {
+        if (!filter || strstr(benchmarks[i].name, filter))
+            bench_run(&benchmarks[i], csv, date, revision);
+    }
+
+    if (csv)
+        fclose(csv);
+    return 0;
+}
@@ -0,0 +1,91 @@
+#!/usr/bin/env bash
+
+# Scaling benchmark of the compiler on generated programs.
+#
+# usage:   scale.sh compiler generator [outdir] [sizes...]
+#   compiler   the built compiler (src/main)
+#   generator  the built program generator (src/ifj_gen, make ifj_gen)
+#   outdir     directory for the programs, the CSV and the plots (default scale_out)
+#   sizes      program sizes in lines (default 1000 10000 100000 1000000)
+#
+# Every size is generated in two shapes: "short" keeps functions at about a hundred lines (the
+# number of functions grows with the program), "long" keeps SCALE_FUNCTIONS functions (default 10)
+# whose length grows with the program, which exposes costs quadratic in the size of a function.
+# Every program is compiled once with --time-report=json, the per-phase wall time, CPU time,
+# allocations and peak RSS are collected in outdir/scale.csv. When gnuplot is installed,
+# outdir/scale_time.png and outdir/scale_memory.png plot the wall time and the allocated bytes
+# of each phase and shape against the program size.
+# Options of the generator can be passed in IFJ_GEN_FLAGS (the seed defaults to 1).
+
+COMPILER=$1
+GENERATOR=$2
+OUTDIR=${3:-scale_out}
+shift $(( $# < 3 ? $# : 3 ))
+SIZES=${*:-1000 10000 100000 1000000}
+PHASES="lex parse semantic codegen"
+SHAPES="short long"
+FIXED_FUNCTIONS=${SCALE_FUNCTIONS:-10}
+
+if [[ ! -x $COMPILER || ! -x $GENERATOR ]]; then
+  echo "usage: $0 compiler generator [outdir] [sizes...]" >&2
+  exit 1
+fi
+mkdir -p "$OUTDIR"
+CSV=$OUTDIR/scale.csv
+echo "lines,shape,phase,wall_ms,cpu_ms,mallocs,bytes,peak_rss_kib" > "$CSV"
+
+# Value of a field of one phase object in the JSON report
+function field () { # $1=report $2=phase $3=field
+  echo "$1" | grep -o "\"$2\": {[^}]*}" | grep -o "\"$3\": [0-9.]*" | cut -d' ' -f2
+}
+
+for SIZE in $SIZES; do
+for SHAPE in $SHAPES; do
+  PROGRAM=$OUTDIR/gen_${SHAPE}_$SIZE.ifj
+  if [[ $SHAPE == short ]]; then
+    FUNCTIONS=$(( SIZE / 100 > 0 ? SIZE / 100 : 1 ))
+  else
+    FUNCTIONS=$FIXED_FUNCTIONS
+  fi
+  "$GENERATOR" --seed 1 --functions $FUNCTIONS $IFJ_GEN_FLAGS --lines "$SIZE" > "$PROGRAM" || exit 1
+
+  REPORT=$("$COMPILER" --time-report=json "$PROGRAM" 2>&1 >/dev/null | grep '^{')
+  if [[ -z $REPORT ]]; then
+    echo "$PROGRAM: compilation failed" >&2
+    exit 1
+  fi
+  for PHASE in $PHASES; do
+    echo "$SIZE,$SHAPE,$PHASE,$(field "$REPORT" $PHASE wall_ms),$(field "$REPORT" $PHASE cpu_ms),$(field "$REPORT" $PHASE mallocs),$(field "$REPORT" $PHASE bytes),$(field "$REPORT" $PHASE peak_rss_kib)" >> "$CSV"
+  done
+  echo "$(wc -l < "$PROGRAM") lines, $FUNCTIONS functions: $(echo "$REPORT" | grep -o '"counts": {[^}]*}')"
+done
+done
+
+awk -F, '{ printf "%-8s %-6s %-9s %12s %12s %10s %12s %13s\n", $1, $2, $3, $4, $5, $6, $7, $8 }' "$CSV"
+
+if ! command -v gnuplot > /dev/null; then
+  echo "gnuplot not found, plots skipped"
+  exit 0
+fi
+
+# One line per phase and shape, its rows are selected from the CSV by grep
+PLOT=""
+for SHAPE in $SHAPES; do
+  for PHASE in $PHASES; do
+    PLOT="$PLOT${PLOT:+, }'< grep \",$SHAPE,$PHASE,\" $CSV' using 1:COLUMN with linespoints title '$PHASE ($SHAPE)'"
+  done
+done
+gnuplot <<EOF
+set datafile separator ','
+set terminal png size 800,600
+set logscale xy
+set xlabel 'program size [lines]'
+set key top left
+set output '$OUTDIR/scale_time.png'
+set ylabel 'wall time [ms]'
+plot ${PLOT//COLUMN/4}
+set output '$OUTDIR/scale_memory.png'
+set ylabel 'allocated [bytes]'
+plot ${PLOT//COLUMN/7}
+EOF
+echo "plots written to $OUTDIR/scale_time.png and $OUTDIR/scale_memory.png"
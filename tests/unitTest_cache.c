@@ -0,0 +1,180 @@
+#define _XOPEN_SOURCE 700
+#include <ftw.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "unity.h"                 // Unity framework
+#include "cache.h"
+#include "compiler.h"
+
+// Small bound, the share of one subdirectory (bound / 256) is smaller than any program
+#define TEST_CACHE_BYTES (16 * 1024)
+
+char cacheDirectory[] = "/tmp/ifj_cache_test_XXXXXX";
+CompileCache cache;
+
+const char *program =
+    "const ifj = @import(\"ifj24.zig\");\n"
+    "pub fn add(a: i32, b: i32) i32 {\n"
+    "    const s = a + b;\n"
+    "    return s;\n"
+    "}\n"
+    "pub fn twice(x: i32) i32 {\n"
+    "    const y = add(x, x);\n"
+    "    return y;\n"
+    "}\n"
+    "pub fn main() void {\n"
+    "    const r = twice(21);\n"
+    "    ifj.write(r);\n"
+    "}\n";
+
+// The program with the body of twice() edited
+const char *editedProgram =
+    "const ifj = @import(\"ifj24.zig\");\n"
+    "pub fn add(a: i32, b: i32) i32 {\n"
+    "    const s = a + b;\n"
+    "    return s;\n"
+    "}\n"
+    "pub fn twice(x: i32) i32 {\n"
+    "    const y = add(x, 1);\n"
+    "    const z = add(y, x);\n"
+    "    return z;\n"
+    "}\n"
+    "pub fn main() void {\n"
+    "    const r = twice(21);\n"
+    "    ifj.write(r);\n"
+    "}\n";
+
+// The caller stays the same when the signature of show() changes, and becomes wrong
+const char *callerProgram =
+    "const ifj = @import(\"ifj24.zig\");\n"
+    "pub fn show(x: i32) void {\n"
+    "    ifj.write(x);\n"
+    "    return;\n"
+    "}\n"
+    "pub fn main() void {\n"
+    "    show(21);\n"
+    "}\n";
+
+const char *changedCalleeProgram =
+    "const ifj = @import(\"ifj24.zig\");\n"
+    "pub fn show(x: i32, y: i32) void {\n"
+    "    ifj.write(x);\n"
+    "    ifj.write(y);\n"
+    "    return;\n"
+    "}\n"
+    "pub fn main() void {\n"
+    "    show(21);\n"
+    "}\n";
+
+/**
+ * @brief Compiles the source through the cache.
+ *
+ * @param source Source code of the program.
+ * @param output Receives the program, owned by the caller.
+ * @param hit Receives whether the result came from the cache.
+ * @return Exit code of the compiler.
+ */
+int compile_cached(const char *source, char **output, bool *hit) {
+    size_t length;
+    FILE *out = open_memstream(output, &length);
+    CompilerContext context = {0};
+    int result = cache_compile(&cache, &context, source, strlen(source), out, hit);
+    fclose(out);
+    return result;
+}
+
+/**
+ * @brief Compiles the source without the cache.
+ *
+ * @param source Source code of the program.
+ * @param output Receives the program, owned by the caller.
+ * @return Exit code of the compiler.
+ */
+int compile_full(const char *source, char **output) {
+    size_t length;
+    FILE *out = open_memstream(output, &length);
+    CompilerContext context = {0};
+    int result = ifj_compile(&context, source, strlen(source), out);
+    fclose(out);
+    return result;
+}
+
+/**
+ * @brief Compiles the original source, then the edited one through the cache, and checks that the
+ * exit code and the program equal those of the edited source compiled without the cache.
+ */
+void check_recompiled(const char *original, const char *edited) {
+    char *first, *cached, *full;
+    bool hit;
+    // Large enough to keep the code of every function
+    cache_close(&cache);
+    TEST_ASSERT_TRUE(cache_open(&cache, cacheDirectory, 1 << 20));
+
+    TEST_ASSERT_EQUAL(0, compile_cached(original, &first, &hit));
+    TEST_ASSERT_FALSE(hit);
+
+    int cachedResult = compile_cached(edited, &cached, &hit);
+    TEST_ASSERT_FALSE(hit);
+    TEST_ASSERT_EQUAL(compile_full(edited, &full), cachedResult);
+    TEST_ASSERT_EQUAL_STRING(full, cached);
+    TEST_ASSERT_TRUE(strcmp(first, cached) != 0);
+    free(first);
+    free(cached);
+    free(full);
+}
+
+int remove_entry(const char *path, const struct stat *info, int flag, struct FTW *walk) {
+    (void)info;
+    (void)flag;
+    (void)walk;
+    return remove(path);
+}
+
+// Optional setup code for tests (runs before each test)
+void setUp(void) {
+    strcpy(cacheDirectory, "/tmp/ifj_cache_test_XXXXXX");
+    if (!mkdtemp(cacheDirectory) || !cache_open(&cache, cacheDirectory, TEST_CACHE_BYTES))
+        fprintf(stderr, "Failed to create the cache directory");
+}
+
+// Optional teardown code for tests (runs after each test)
+void tearDown(void) {
+    cache_close(&cache);
+    nftw(cacheDirectory, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+// A program larger than the share of its subdirectory stays in the cache
+void test_second_compile_hits(void) {
+    char *first, *second;
+    bool hit;
+    TEST_ASSERT_EQUAL(0, compile_cached(program, &first, &hit));
+    TEST_ASSERT_FALSE(hit);
+    TEST_ASSERT_TRUE(strlen(first) > TEST_CACHE_BYTES / 256);
+
+    TEST_ASSERT_EQUAL(0, compile_cached(program, &second, &hit));
+    TEST_ASSERT_TRUE(hit);
+    TEST_ASSERT_EQUAL_STRING(first, second);
+    free(first);
+    free(second);
+}
+
+// Unchanged functions come from the cache, the edited one is compiled again
+void test_edited_function_matches_full_compile(void) {
+    check_recompiled(program, editedProgram);
+}
+
+// A caller whose text is unchanged is checked again when the signature of its callee changes
+void test_changed_callee_signature_matches_full_compile(void) {
+    check_recompiled(callerProgram, changedCalleeProgram);
+}
+
+// Main test runner
+int main(void) {
+    UNITY_BEGIN();            // Initialize Unity test framework
+    RUN_TEST(test_second_compile_hits);
+    RUN_TEST(test_edited_function_matches_full_compile);
+    RUN_TEST(test_changed_callee_signature_matches_full_compile);
+    return UNITY_END();       // Finalize Unity and report results
+}
@@ -1,5 +1,8 @@
+#include <string.h>
+
 #include "unity.h"                 // Unity framework
 #include "lexical_analyser.h"      // Assume this declares `add`
+#include "literal_pool.h"
 
 FILE *file;
 FILE *tempFile;
@@ -12,6 +15,7 @@ void setUp(void) {
     tempFile = tmpfile();
     if (tempFile == NULL)
         fprintf(stderr, "Failed to create temporary file");
+    lexer_begin(tempFile); // Drops what the lexer read ahead in the previous test
     
 }
 
@@ -19,6 +23,7 @@ void setUp(void) {
 void tearDown(void) {
     fclose(tempFile);
     fclose(file); 
+    literal_pool_free();
 }
 
 void test_general(void) {
@@ -36,11 +41,40 @@ void test_general(void) {
     } while (token.type != TOKEN_EOF); // Continue until EOF
 }
 
+// Value the lexer put into the literal pool for the float literal in text
+double scan_float(const char *text) {
+    FILE *source = fmemopen((void *)text, strlen(text), "r");
+    lexer_begin(source);
+    Token token = get_token(source);
+    TEST_ASSERT_EQUAL_MESSAGE(TOKEN_FLOAT_LITERAL, token.type, text);
+    double value = literal_pool_float(literal_pool_find(TOKEN_FLOAT_LITERAL, token.value.valueString.str));
+    dynamic_string_free(&token.value.valueString);
+    fclose(source);
+    return value;
+}
 
+// Values of float literals equal strtod() of their text, also where the lexer leaves its fast path
+void test_float_values_match_strtod(void) {
+    const char *literals[] = {
+        "0.1", "1.1", "2.675", "0.30000000000000004",   // Differ from their %.17g rendering
+        "9007199254740992.0", "9007199254740993.0",      // 2^53 and the first integer above it
+        "123456789012345678.0", "0.12345678901234567890", // More than 17 digits
+        "1.00000000000000011102230246251565404236316680908203125", // Halfway between two doubles
+        "1.0e22", "1.0e23", "1.0e-22", "1.0e-23",         // Largest exact power of ten and beyond
+        "1.7976931348623157e308", "1.8e308",              // Largest double, overflow
+        "2.2250738585072014e-308", "4.9e-324", "2.5e-324", // Smallest normal and subnormal, rounds up
+        "1.5e-310", "12345678901234567890e-20", "9.3e18"};  // Subnormal, long mantissa, above long long
+    for (size_t i = 0; i < sizeof(literals) / sizeof(literals[0]); i++) {
+        double expected = strtod(literals[i], NULL);
+        double value = scan_float(literals[i]);
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&expected, &value, sizeof(double), literals[i]);
+    }
+}
 
 // Main test runner
 int main(void) {
     UNITY_BEGIN();            // Initialize Unity test framework
     RUN_TEST(test_general);
+    RUN_TEST(test_float_values_match_strtod);
     return UNITY_END();       // Finalize Unity and report results
 }
\ No newline at end of file
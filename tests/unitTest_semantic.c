@@ -4,17 +4,20 @@
 
 FILE *file;
 FILE *tempFile;
+CompilerContext context;
 
 //! Len provizorne 
 
 // Optional setup code for tests (runs before each test)
 void setUp(void) {
+    compilerContext = &context;
     file = fopen("../tests/inputs/01.txt", "r");
     if(file == NULL)
         fprintf(stderr, "Usage: %s <filename>\n", "./inputs/01.txt");
     tempFile = tmpfile();
     if (tempFile == NULL)
         fprintf(stderr, "Failed to create temporary file");
+    lexer_begin(tempFile); // Drops what the lexer read ahead in the previous test
     
 }
 
@@ -25,7 +28,7 @@ void tearDown(void) {
 }
 
 void test_syntactic(void) {
-    TEST_ASSERT_EQUAL(1, FIRST(file)); 
+    TEST_ASSERT_EQUAL(1, FIRST(&context, file)); 
 }
 
 void test_synt_import(void) {
@@ -33,12 +36,12 @@ void test_synt_import(void) {
     fprintf(tempFile, "const ifj = @import(\"ifj24.zig\");\n");
     // Move the file pointer to the beginning for reading
     rewind(tempFile);
-    TEST_ASSERT_EQUAL(1, FIRST(tempFile)); 
+    TEST_ASSERT_EQUAL(1, FIRST(&context, tempFile)); 
 }
 void test_synt_const(void) {
     fprintf(tempFile, "const inp = ifj.readi32();\n");
     rewind(tempFile);
-    TEST_ASSERT_EQUAL(1, FIRST(tempFile)); 
+    TEST_ASSERT_EQUAL(1, FIRST(&context, tempFile)); 
 }
 
 